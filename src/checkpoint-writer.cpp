@@ -0,0 +1,85 @@
+//           checkpoint-writer.cpp
+//  Copyright  2011  Peter Urban
+//  <s9peurba@stud.uni-saarland.de>
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+
+# include "checkpoint-writer.h"
+
+# include "utk/log.h"
+
+using namespace flat;
+
+session::CheckpointWriter::CheckpointWriter( const std::string& path )
+: m_path( path ), m_writing( false ), m_stop( false )
+{
+  m_thread = std::thread( [this]() { run(); } );
+}
+
+session::CheckpointWriter::~CheckpointWriter()
+{
+  {
+    std::lock_guard< std::mutex > lock( m_mutex );
+    m_stop = true;
+  }
+  m_condition.notify_all();
+  m_thread.join();
+}
+
+void    session::CheckpointWriter::submit( std::unique_ptr< snapshot > contents )
+{
+  {
+    std::lock_guard< std::mutex > lock( m_mutex );
+
+    if( m_pending )
+      UTK_LOG( WARNING, "flat::session::CheckpointWriter::submit\t| dropping the checkpoint of iteration " << m_pending->meta.iteration << " - the disk is slower than the solver" );
+
+    m_pending = std::move( contents );
+  }
+  m_condition.notify_all();
+}
+
+void    session::CheckpointWriter::flush()
+{
+  std::unique_lock< std::mutex > lock( m_mutex );
+  m_condition.wait( lock, [this]() { return !m_pending && !m_writing; } );
+}
+
+void    session::CheckpointWriter::run()
+{
+  std::unique_lock< std::mutex > lock( m_mutex );
+
+  for( ;; )
+  {
+    m_condition.wait( lock, [this]() { return m_pending || m_stop; } );
+
+    // the last snapshot is written even when stopping
+    if( !m_pending ) return;
+
+    std::unique_ptr< snapshot > contents( std::move( m_pending ) );
+    m_writing = true;
+    lock.unlock();
+
+    try
+    { write( m_path, *contents );
+    }catch( const std::exception& e )
+    { UTK_LOG( ERROR, "flat::session::CheckpointWriter\t| checkpoint of iteration " << contents->meta.iteration << " failed - " << e.what() );
+    }
+
+    lock.lock();
+    m_writing = false;
+    m_condition.notify_all();
+  }
+}
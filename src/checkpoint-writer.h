@@ -0,0 +1,76 @@
+/***************************************************************************
+ *            checkpoint-writer.h
+ *
+ *  Copyright  2011  Peter Urban
+ *  <s9peurba@stud.uni-saarland.de>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+# pragma once
+
+# include "common.h"
+
+# include "session-format.h"
+
+# include <condition_variable>
+# include <memory>
+# include <mutex>
+# include <string>
+# include <thread>
+
+namespace flat
+{
+  namespace session
+  {
+    // writes session snapshots to a file on a background thread
+    // - the solver thread only pays for copying the snapshot
+    // - a snapshot submitted while another one is written replaces the one waiting,
+    //   so a slow disk drops intermediate checkpoints instead of stalling the solver
+    class CheckpointWriter
+    {
+        const std::string   m_path;
+
+        std::mutex                  m_mutex;
+        std::condition_variable     m_condition;
+        std::unique_ptr< snapshot > m_pending;
+        bool        m_writing;
+        bool        m_stop;
+
+        std::thread m_thread;
+
+        void    run();
+
+        CheckpointWriter( const CheckpointWriter& );
+        CheckpointWriter&   operator=( const CheckpointWriter& );
+
+      public:
+
+        CheckpointWriter( const std::string& path );
+
+        // writes the waiting snapshot before the thread ends
+        ~CheckpointWriter();
+
+        const std::string&  path()  const   { return m_path; }
+
+        void    submit( std::unique_ptr< snapshot > contents );
+
+        // blocks until no snapshot is waiting or being written
+        void    flush();
+    };
+  }
+}
@@ -73,6 +73,15 @@ namespace flat
   typedef double    curvature_t;
   typedef double    energy_type;
   typedef float     color_channel_t;
+
+  // precision of the solver and storage layers ( distance matrix, mds matrices, spring lengths )
+  // - mesh geometry and the mmp geodesics always use double
+  # if defined FLAT_SINGLE_PRECISION_SOLVER
+  typedef float     solver_coord_t;
+  # else
+  typedef double    solver_coord_t;
+  # endif
+  typedef solver_coord_t    solver_distance_t;
   
   typedef utk::veca<coord_t,3>	location_t;
   typedef utk::vecn<coord_t,3>	location_ref_t;
@@ -22,6 +22,8 @@
 # include "surface-generators.h"
 # include "drawable.h"
 
+# include <sstream>
+
 using namespace gtk;
 
 const UI::widget_name_t Controller::SURFACE_MODEL_SLOT = "surface_model_container";
@@ -30,7 +32,8 @@ const UI::widget_name_t Controller::SOLVER_MODEL_SLOT 	= "solver_model_container
 const UI::widget_name_t Controller::SOLVER_VIEW_SLOT 	= "solver_view_container";
 
 Controller::Controller( const Glib::RefPtr<Gtk::Builder>& builder )
-: m_builder( builder ), model(), m_gl_view( 0 ), m_play_connection()
+: m_builder( builder ), model(), m_solver_thread( model ), m_gl_view( 0 ), m_ui_outdated( false )
+, m_display_ticks( 0 ), m_reported_steps( 0 ), m_reported_frames( 0 )
 {
   // derived widgets
   get_builder()->get_widget_derived( "image_export_dialog", image_export_dialog );
@@ -41,11 +44,16 @@ Controller::Controller( const Glib::RefPtr<Gtk::Builder>& builder )
   
   // viewport container
   get_builder()->get_widget( "main_paned", main_paned );
+
+  get_builder()->get_widget( "statusbar1", m_statusbar );
   
   // toolbar buttons
   get_builder()->get_widget( "play_toolbar_button", play_button );
   play_button->signal_clicked().connect( sigc::mem_fun( *this, &Controller::on_play_button_clicked ) ); 
 
+  get_builder()->get_widget( "step_toolbar_button", step_button );
+  step_button->signal_clicked().connect( sigc::mem_fun( *this, &Controller::on_step_button_clicked ) ); 
+
   get_builder()->get_widget( "new_toolbar_button", new_button );
   new_button->signal_activate().connect( sigc::mem_fun( *this, &Controller::on_new_menu_item_activate ) );
 
@@ -57,6 +65,7 @@ Controller::Controller( const Glib::RefPtr<Gtk::Builder>& builder )
 
   // default OpenGL view
   set_view( gtk::GLView::create() ); 
+  m_gl_view->get_canvas()->connect_pick_observer( boost::bind( &Controller::on_pick, this, _1, _2 ) );
   
   // construct the default model
 
@@ -94,24 +103,93 @@ Controller::Controller( const Glib::RefPtr<Gtk::Builder>& builder )
 
   set_model( surface, solver );
 
+  m_display_connection = Glib::signal_timeout().connect( sigc::mem_fun( *this, &Controller::on_display_timeout ), 40 );
 }
 
-// connects/disconnects the gtk idle signal to Contoller::step()
-// returns true if the connection is now unblocked (simulation running)
-// returns false if connection is blocked (simulation stopped)
 void    Controller::toggle_iteration()
 {
+  if( !m_solver_thread.is_playing() )
+  { m_solver_thread.play(); play_button->set_stock_id( Gtk::Stock::MEDIA_PAUSE ); }
+  else { m_solver_thread.pause(); play_button->set_stock_id( Gtk::Stock::MEDIA_PLAY  ); }
+}
 
-  if( !m_play_connection.connected() ) 
-  { m_play_connection = Glib::signal_idle().connect( sigc::mem_fun( *this, &Controller::step ), Glib::PRIORITY_DEFAULT_IDLE);
-    m_play_connection.block();
+std::unique_lock< std::recursive_mutex >  Controller::stop_iteration()
+{
+  m_solver_thread.pause();
+  play_button->set_stock_id( Gtk::Stock::MEDIA_PLAY );
+  return std::unique_lock< std::recursive_mutex >( m_solver_thread.model_mutex() );
+}
+
+bool    Controller::on_display_timeout()
+{
+  if( m_solver_thread.consume_snapshot() )
+  { m_ui_outdated = true;
+    m_gl_view->invalidate();
   }
-  
-  if( m_play_connection.blocked() )
-  { m_play_connection.unblock(); play_button->set_stock_id( Gtk::Stock::MEDIA_PAUSE ); }
-  else { m_play_connection.block(); play_button->set_stock_id( Gtk::Stock::MEDIA_PLAY  ); }
+
+  if( m_ui_outdated )
+  {
+    // the widgets read the surface - retried on the next timeout while a step runs
+    std::unique_lock< std::recursive_mutex > lock( m_solver_thread.model_mutex(), std::try_to_lock );
+    if( lock.owns_lock() )
+    {
+      for_each( m_surface_ui.first.begin(), m_surface_ui.first.end() 
+		      , [] ( ui_modules_t::first_type::const_reference ui ) { ui.first->update(); } );
+      m_ui_outdated = false;
+    }
+  }
+
+  // about once a second
+  if( ++m_display_ticks % 25 == 0 )
+  {
+    const std::pair< size_t, double > steps = m_solver_thread.statistics();
+    const size_t frames = m_gl_view->get_canvas()->get_frame_count();
+
+    if( steps.first != m_reported_steps )
+    {
+      std::ostringstream message;
+      message.precision( 3 );
+      message << "frame " << 1000. * m_gl_view->get_canvas()->get_frame_time() << " ms - step " << 1000. * steps.second << " ms - "
+              << double( steps.first - m_reported_steps ) / std::max< size_t >( 1, frames - m_reported_frames ) << " steps per frame";
+
+      m_statusbar->pop();
+      m_statusbar->push( message.str() );
+    }
+
+    m_reported_steps  = steps.first;
+    m_reported_frames = frames;
+  }
+
+  return true; // keep polling
 }
 
+void    Controller::on_pick( const utk::ray< flat::coord_t, 3 >& ray, const flat::coord_t pixel_angle )
+{
+  // primitives within a few pixels of the click are picked instead of the face
+  const flat::coord_t pick_pixels = 4;
+
+  if( !shared_surface_drawable ) return;
+
+  typedef flat::SurfacePicker::hit hit;
+  const hit picked = shared_surface_drawable->pick( ray, pick_pixels * pixel_angle );
+
+  std::ostringstream message;
+  message.precision( 4 );
+
+  switch( picked.type )
+  {
+    case hit::VERTEX: message << "vertex " << picked.vertices[0]; break;
+    case hit::EDGE:   message << "edge " << picked.vertices[0] << " - " << picked.vertices[1]; break;
+    case hit::FACE:   message << "face " << picked.face; break;
+    default:          message << "nothing picked";
+  }
+
+  if( picked.type != hit::NONE )
+    message << " at " << picked.location;
+
+  m_statusbar->pop();
+  m_statusbar->push( message.str() );
+}
 
 void	Controller::on_new_menu_item_activate()
 {
@@ -142,10 +220,14 @@ void	Controller::on_open_menu_item_activate()
 
 void	Controller::on_play_button_clicked() 
 {  
-  //step();
   toggle_iteration();
 }
 
+void	Controller::on_step_button_clicked() 
+{  
+  m_solver_thread.step();
+}
+
 void	Controller::on_export_button_clicked()
 { 
   // ask the user for a file to open
@@ -157,6 +239,8 @@ void	Controller::on_export_button_clicked()
 		   << '\"' << image_export_dialog->get_filename() << '\"'
 		   << std::endl;
 
+  std::unique_lock< std::recursive_mutex > lock( m_solver_thread.model_mutex() );
+
   try{ image_export_dialog->write( model.get_surface() ); }
   catch(std::bad_alloc)
   {
@@ -167,6 +251,12 @@ void	Controller::on_export_button_clicked()
                         );
     d.run();
   }
+  catch( const std::exception& e )
+  {
+    Gtk::MessageDialog d( *main_window, "<b>Could not write the image</b>\n" + Glib::Markup::escape_text( e.what() ),
+                          true, Gtk::MESSAGE_ERROR, Gtk::BUTTONS_OK, true );
+    d.run();
+  }
 }
 
 
@@ -174,6 +264,9 @@ void  Controller::on_solver_combo_changed( Gtk::ComboBoxText* combo )
 {
   std::string active = combo->get_active_text();
 
+  // the new solver reads the surface
+  std::unique_lock< std::recursive_mutex > lock( stop_iteration() );
+
   if( active == spring::SpringSolver<false,false>::class_name() )
   {
     std::shared_ptr< spring::SpringSolver<false,false> > solver( new spring::SpringSolver<false,false>( model.get_surface() ) );
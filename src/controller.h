@@ -26,6 +26,7 @@
 # pragma once
 
 # include "model.h"
+# include "solver-thread.h"
 
 # include "gl-view.h"
 
@@ -65,6 +66,8 @@ namespace gtk
       const Glib::RefPtr< Gtk::Builder >& m_builder;
       
   	  flat::Model	model;
+  	  // steps the model - declared after it, so it is stopped first
+  	  flat::SolverThread	m_solver_thread;
 
       std::shared_ptr< gl::SharedSurfaceDrawable > shared_surface_drawable;
       std::shared_ptr< gtk::SurfaceDrawableUI > shared_surface_drawable_ui;
@@ -84,21 +87,32 @@ namespace gtk
   	  Gtk::ImageMenuItem*	new_button;
   	  Gtk::ImageMenuItem*	open_button;
    	  Gtk::ToolButton*		play_button; 
+   	  Gtk::ToolButton*		step_button; 
   	  Gtk::ToolButton* 		export_button;
 
       Gtk::ComboBoxText*    m_solver_combo;
+
+      // shows the frame time against the solver step time
+      Gtk::Statusbar*       m_statusbar;
+      size_t    m_display_ticks;
+      size_t    m_reported_steps;
+      size_t    m_reported_frames;
       
-      sigc::connection      m_play_connection;
+      sigc::connection      m_display_connection;
+      // a snapshot was drawn but the surface widgets could not read the surface yet
+      bool  m_ui_outdated;
       
   	protected:
-			// connects/disconnects the gtk idle signal to Contoller::step()
-			// returns true if the connection was blocked
-			// returns false if connection was established
+  	  // starts or pauses the solver thread
   	  void  toggle_iteration();
 
+  	  // pauses the solver thread and waits for its step to end
+  	  std::unique_lock< std::recursive_mutex >	stop_iteration();
+
   	  void	on_new_menu_item_activate();
       void	on_open_menu_item_activate();
   	  void	on_play_button_clicked();
+  	  void	on_step_button_clicked();
   	  void	on_export_button_clicked();        
 
       void  on_solver_combo_changed( Gtk::ComboBoxText* );
@@ -154,24 +168,19 @@ namespace gtk
 		return ui;
 	  }
 
-      bool	step()
-	  { 
-		model.step();
-		
-		for_each( m_surface_ui.first.begin(), m_surface_ui.first.end() 
-		        , [] ( ui_modules_t::first_type::const_reference ui ) { ui.first->update(); } );
-		
-		m_gl_view->invalidate();
-		
-        return true; // don't block idle connection
-	  }
+      // polls the solver thread at display rate
+      bool	on_display_timeout();
+
+      // picks the surface under a click of the gl view and shows the primitive in the statusbar
+      void  on_pick( const utk::ray< flat::coord_t, 3 >& ray, const flat::coord_t pixel_angle );
 
 	  
   	public:
 	  
 	  Controller(const Glib::RefPtr<Gtk::Builder>& builder );
 
-	  ~Controller() { delete m_gl_view;	
+	  ~Controller() { m_display_connection.disconnect();
+                      delete m_gl_view;	
                       m_surface_ui.first.clear();
                       m_surface_ui.second.clear();
                       m_solver_ui.first.clear();
@@ -184,8 +193,14 @@ namespace gtk
 	  void	set_model( const std::shared_ptr< SurfaceT >& surface
 			         , const std::shared_ptr< SolverT >&  solver )
 	  { 
+		std::unique_lock< std::recursive_mutex > lock( stop_iteration() );
+
+		// the drawables of the previous model are destroyed below
+		m_gl_view->gl_release_drawables();
+
 		// set up container for surface drawables
 		shared_surface_drawable.reset( new gl::SharedSurfaceDrawable( surface ) );
+		shared_surface_drawable->set_solver_thread( &m_solver_thread );
 		// set up surface_ui
 		shared_surface_drawable_ui.reset( new gtk::SurfaceDrawableUI( shared_surface_drawable ) );
 
@@ -207,6 +222,10 @@ namespace gtk
 	  template< class SolverT >
 	  void	set_solver( const std::shared_ptr< SolverT >&  solver )
       { 
+		std::unique_lock< std::recursive_mutex > lock( stop_iteration() );
+
+		m_gl_view->gl_release_drawables();
+
 		model.set_solver( solver );
         m_solver_ui  = add_ui( solver );
         m_solver_combo->set_active_text( SolverT::class_name() );
@@ -42,14 +42,36 @@ namespace gl
       typedef boost::signal<void()>	invalidate_signal;
 	  typedef boost::signal<void()>	remove_signal;
 
+	  // returned by data_generation if the drawing may change without notice
+	  static const size_t	UNKNOWN_GENERATION = size_t( -1 );
+
 	private:
 
       remove_signal					remove_drawable;
 	  invalidate_signal				invalidate_drawable;
 
+	  // display list of the last drawing - replayed while neither invalidate() was called nor the data changed
+	  GLuint	m_gl_list;
+	  bool		m_list_valid;
+	  size_t	m_list_invalidations;
+	  size_t	m_list_generation;
+
+	  size_t	m_invalidations;
+	  // data generation of the previous drawing - drawings changing every frame are not recorded
+	  size_t	m_last_generation;
+
+	  void	gl_delete_list()
+	  {
+		if( m_gl_list ) glDeleteLists( m_gl_list, 1 );
+		m_gl_list    = 0;
+		m_list_valid = false;
+	  }
+
 	public:
         
-	  Drawable()  {	}
+	  Drawable()  
+	  : m_gl_list( 0 ), m_list_valid( false ), m_list_invalidations( 0 ), m_list_generation( 0 )
+	  , m_invalidations( 0 ), m_last_generation( UNKNOWN_GENERATION )	{	}
 									
 	  virtual	~Drawable()
       { std::clog << "gl::Drawable::~Drawable\t|disconnecting drawable"
@@ -66,10 +88,53 @@ namespace gl
       void	invalidate()
       { 
         std::clog << "gl::Drawable::invalidate\t|invalidating drawable" << std::endl;
+		++m_invalidations;
 		invalidate_drawable();
 	  }
 
 	  virtual	void	gl_draw() = 0;
+
+	  // generation of the data drawn - the drawing is cached while it and the number of invalidations stay the same
+	  virtual	size_t	data_generation()	const	{ return UNKNOWN_GENERATION; }
+
+	  // draws through the display list cache if cached is set - all cached calls need the same gl context
+	  void	gl_render( const bool cached )
+	  {
+		const size_t generation = data_generation();
+
+		if( cached && m_list_valid && m_list_invalidations == m_invalidations && m_list_generation == generation )
+		{ glCallList( m_gl_list );
+		  return;
+		}
+
+		// record only what was drawn alike in the previous frame
+		const bool record = cached && generation != UNKNOWN_GENERATION && generation == m_last_generation 
+		                    && m_list_invalidations == m_invalidations;
+
+		m_last_generation    = generation;
+		m_list_invalidations = m_invalidations;
+		m_list_valid         = false;
+
+		if( !record )
+		{ // drawings changing without notice are never replayed
+		  if( cached && generation == UNKNOWN_GENERATION ) gl_delete_list();
+		  gl_draw();
+		  return;
+		}
+
+		if( !m_gl_list ) m_gl_list = glGenLists( 1 );
+
+		glNewList( m_gl_list, GL_COMPILE_AND_EXECUTE );
+		gl_draw();
+		glEndList();
+
+		m_list_generation = generation;
+		m_list_valid      = true;
+	  }
+
+	  // frees the gl objects of the drawing - needs the context it was cached in, drawing again recreates them
+	  // - drawables with gl objects of their own free them as well and call this
+	  virtual	void	gl_release()	{ gl_delete_list(); }
   };
 }
 
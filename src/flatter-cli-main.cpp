@@ -21,16 +21,39 @@
 
 # include "spring-solver.h"
 # include "mds-solver.h"
+# include "tiled-flattener.h"
+# include "session-format.h"
+# include "checkpoint-writer.h"
+# include "texture-rasterizer.h"
+
+# include "utk/log.h"
 
 # include <boost/program_options.hpp>
 
+# include <algorithm>
+# include <fstream>
+# include <iomanip>
+# include <sstream>
+
 # define CLI_FLATTER__GL_OUTPUT
 
+// needs egl - see the offscreen-renderer option of configure
+# if defined FLAT_OFFSCREEN_RENDERER
+#   define CLI_FLATTER__OFFSCREEN_OUTPUT
+# endif
+
 # if defined CLI_FLATTER__GL_OUTPUT
 #   include "gl-view.h"
 #   include "surface-drawable.h"
 # endif
 
+# if defined CLI_FLATTER__OFFSCREEN_OUTPUT
+#   include "offscreen-renderer.h"
+#   include "frame-recorder.h"
+#   include "surface-drawable.h"
+#   include "mmp-visualizer.h"
+# endif
+
 int main (int argc, char *argv[])
 {
   using namespace flat;
@@ -53,7 +76,13 @@ int main (int argc, char *argv[])
   const char export_dist_param[] = "export-distances";
   const char stride_x_param[] = "s_x";	
   const char stride_y_param[] = "s_y";
+  const char surface_binary_out_param[] = "surface-binary-out";
   typedef    size_t stride_type;
+  const char tile_size_param[]    = "tile-size";
+  const char tile_overlap_param[] = "tile-overlap";
+  const char tiled_out_param[]    = "tiled-out";
+  const char result_in_param[]    = "result-in";
+  const char result_out_param[]   = "result-out";
 
 	
   // solver
@@ -67,6 +96,12 @@ int main (int argc, char *argv[])
   const char ground_param[]      = "kg";
   const char friction_param[]    = "kf";
   typedef    double coeff_type;  
+  const char mds_iterations_param[] = "mds-iterations";
+  const char mds_tolerance_param[]  = "mds-tolerance";
+  const char mds_landmarks_param[]  = "mds-landmarks";
+  const char mds_weighting_param[]  = "mds-weighting";
+  const char mds_band_param[]       = "mds-band";
+  const char mds_pivots_param[]     = "mds-pivots";
 
   // main loop
   const char iterations_param[]  = "max-iterations";
@@ -74,6 +109,27 @@ int main (int argc, char *argv[])
 
   const char iteration_out_param[] = "iteration-out";
   const char session_out_param[]   = "session-out";
+  const char checkpoint_param[]    = "checkpoint";
+  const char checkpoint_interval_param[] = "checkpoint-interval";
+  const char resume_param[]        = "resume";
+  const char log_level_param[]     = "log-level";
+
+  // offscreen rendering
+  const char render_out_param[]       = "render-out";
+  const char render_interval_param[]  = "render-interval";
+  const char render_width_param[]     = "render-width";
+  const char render_height_param[]    = "render-height";
+  const char render_vertices_param[]  = "render-vertices";
+  const char render_edges_param[]     = "render-edges";
+  const char render_faces_param[]     = "render-faces";
+  const char render_geodesics_param[] = "render-geodesics";
+
+  // texture export
+  const char texture_out_param[]      = "texture-out";
+  const char texel_size_param[]       = "texel-size";
+  const char regular_alignment_param[] = "regular-alignment";
+  const char texel_outline_param[]    = "texel-outline";
+  const char block_outline_param[]    = "block-outline";
 
   po::options_description desc("Program options");
   desc.add_options()
@@ -85,6 +141,12 @@ int main (int argc, char *argv[])
     (export_dist_param, po::value< std::string >(), "specifies a file to which the distance matrix will be exported" )
     (stride_x_param, po::value< stride_type >(), "number of samples to skip during downsampling" )
 	(stride_y_param, po::value< stride_type >(), "number of samples to skip during downsampling" )
+    (surface_binary_out_param, po::value< std::string >(), "writes a binary copy of the text surface file for faster strided loading" )
+    (tile_size_param, po::value< stride_type >(), "flattens the binary surface file in tiles of this many (strided) samples per side" )
+    (tile_overlap_param, po::value< stride_type >()->default_value( 4 ), "number of samples shared by neighboring tiles" )
+    (tiled_out_param, po::value< std::string >(), "binary surface file the tiled flattening is streamed to" )
+    (result_in_param, po::value< std::string >(), "continues the flattening stored in the specified session file" )
+    (result_out_param, po::value< std::string >(), "stores the flattening and the solver state in the specified session file" )
 		
     (solver_param, po::value< solver_type >()->default_value( "spring" ), "determines which solver to use" )
     (stepsize_param, po::value< stepsize_type >(), "step size for spring solvers" )
@@ -92,10 +154,35 @@ int main (int argc, char *argv[])
     (dampening_param, po::value< coeff_type >(), "dampening coefficient for spring solvers" )
     (ground_param, po::value< coeff_type >(), "ground attraction coefficient for spring solvers" )
     (friction_param, po::value< coeff_type >(), "friction coefficient for spring solvers" )
+    (mds_iterations_param, po::value< iteration_type >(), "maximum number of mds iterations per solver step" )
+    (mds_tolerance_param, po::value< coeff_type >(), "relative stress decrease below which mds solvers end a step early" )
+    (mds_landmarks_param, po::value< iteration_type >(), "number of landmarks of the initial mds embedding (0 starts from the surface)" )
+    (mds_weighting_param, po::value< std::string >(), "pair weights of the general mds solver (equal, sammon or banded)" )
+    (mds_band_param, po::value< coeff_type >(), "distance up to which pairs are weighted by the banded scheme" )
+    (mds_pivots_param, po::value< iteration_type >(), "number of pivots every vertex is paired with by the general mds solver" )
 
     (iterations_param, po::value< iteration_type >()->default_value(100), "defines the maximum amount of solver iterations before the program is stopped.")
     (iteration_out_param/*, po::value< std::string >()*/, "if this is used iteration information will be written to standard output or an optional file." )
     (session_out_param/*, po::value< std::string >()*/, "if this is used session information will be written to standard output or an optional file." )
+    (checkpoint_param, po::value< std::string >(), "session file the solver state is written to periodically by a background thread" )
+    (checkpoint_interval_param, po::value< iteration_type >()->default_value( 100 ), "number of solver iterations between two checkpoints" )
+    (resume_param, "continues from the checkpoint if it exists - max-iterations then counts the iterations of all runs" )
+    (log_level_param, po::value< std::string >()->default_value( "info" ), "verbosity of the log - none, error, warning, info, debug or trace" )
+
+    (render_out_param, po::value< std::string >(), "renders frames without a window system to png files named by this prefix and the iteration" )
+    (render_interval_param, po::value< iteration_type >()->default_value( 0 ), "number of solver iterations between two rendered frames (0 renders the result only)" )
+    (render_width_param, po::value< stride_type >()->default_value( 640 ), "width of the rendered frames in pixels" )
+    (render_height_param, po::value< stride_type >()->default_value( 480 ), "height of the rendered frames in pixels" )
+    (render_vertices_param, po::value< std::string >()->default_value( "invisible" ), "vertex mode of the rendered surface" )
+    (render_edges_param, po::value< std::string >()->default_value( "solid" ), "edge mode of the rendered surface" )
+    (render_faces_param, po::value< std::string >()->default_value( "solid" ), "face mode of the rendered surface" )
+    (render_geodesics_param, po::value< size_t >(), "renders the geodesics from the specified vertex over the surface" )
+
+    (texture_out_param, po::value< std::string >(), "draws the texture onto the flattened surface and writes it to the specified png file" )
+    (texel_size_param, po::value< float >()->default_value( 3.f ), "width of a texel in the texture image in pixels" )
+    (regular_alignment_param, "takes the nearest texel instead of blending the four nearest ones" )
+    (texel_outline_param, "draws lines between the texels" )
+    (block_outline_param, "draws lines around the grid cells of the surface" )
     ;
   
   po::variables_map vm;
@@ -105,16 +192,28 @@ int main (int argc, char *argv[])
   //help
   if( vm.count("help") ) { std::cout << desc << std::endl; return 1; }
 
+  //log
+  utk::log::level_type log_level;
+  if( !utk::log::parse_level( vm[ log_level_param ].as<std::string>(), log_level ) )
+  { std::cerr << "ERROR - unknown log level \"" << vm[ log_level_param ].as<std::string>() << "\" specified." << std::endl;
+    return 0;
+  }
+  utk::log::set_threshold( log_level );
+
   
   std::cout << "surface options: ";
 
   if( vm.count( surface_file_param ) )  { std::cout << surface_file_param << " \"" << vm[ surface_file_param ].as<std::string>() << "\" "; }
   if( vm.count( generator_param ) )     { std::cout << generator_param << " \"" << vm[ generator_param ].as<std::string>() << "\" "; }
+  if( vm.count( result_in_param ) )     { std::cout << result_in_param << " \"" << vm[ result_in_param ].as<std::string>() << "\" "; }
+  if( vm.count( result_out_param ) )    { std::cout << result_out_param << " \"" << vm[ result_out_param ].as<std::string>() << "\" "; }
 
   if( vm.count( import_dist_param ) ) { std::cout << import_dist_param << " \"" << vm[ import_dist_param ].as<std::string>() << "\" "; }
   if( vm.count( export_dist_param ) ) { std::cout << export_dist_param << " \"" << vm[ export_dist_param ].as<std::string>() << "\" "; }
   if( vm.count( stride_x_param ) ) 	  { std::cout << stride_x_param << " \"" << vm[ stride_x_param ].as< stride_type >() << "\" "; }
   if( vm.count( stride_y_param ) ) 	  { std::cout << stride_y_param << " \"" << vm[ stride_y_param ].as< stride_type >() << "\" "; }
+  if( vm.count( tile_size_param ) )   { std::cout << tile_size_param << " \"" << vm[ tile_size_param ].as< stride_type >() << "\" "
+                                                  << tile_overlap_param << " \"" << vm[ tile_overlap_param ].as< stride_type >() << "\" "; }
   std::cout<<std::endl;
 
   std::cout << "solver options: "; 
@@ -124,12 +223,31 @@ int main (int argc, char *argv[])
   if( vm.count( dampening_param ) ) { std::cout << dampening_param << ' ' << vm[ dampening_param ].as<coeff_type>() << ' '; }
   if( vm.count( ground_param ) ) { std::cout << ground_param << ' ' << vm[ ground_param ].as<coeff_type>() << ' '; }
   if( vm.count( friction_param ) ) { std::cout << friction_param << ' ' << vm[ friction_param ].as<coeff_type>() << ' '; }
+  if( vm.count( mds_iterations_param ) ) { std::cout << mds_iterations_param << ' ' << vm[ mds_iterations_param ].as<iteration_type>() << ' '; }
+  if( vm.count( mds_tolerance_param ) ) { std::cout << mds_tolerance_param << ' ' << vm[ mds_tolerance_param ].as<coeff_type>() << ' '; }
+  if( vm.count( mds_landmarks_param ) ) { std::cout << mds_landmarks_param << ' ' << vm[ mds_landmarks_param ].as<iteration_type>() << ' '; }
+  if( vm.count( mds_weighting_param ) ) { std::cout << mds_weighting_param << ' ' << vm[ mds_weighting_param ].as<std::string>() << ' '; }
+  if( vm.count( mds_band_param ) )      { std::cout << mds_band_param << ' ' << vm[ mds_band_param ].as<coeff_type>() << ' '; }
+  if( vm.count( mds_pivots_param ) )    { std::cout << mds_pivots_param << ' ' << vm[ mds_pivots_param ].as<iteration_type>() << ' '; }
   std::cout << std::endl;
 
   std::cout << "main loop options: " << iterations_param << " \"" << vm[ iterations_param ].as<iteration_type>() << "\" ";
   if( vm.count( iteration_out_param ) ) { std::cout << iteration_out_param << " \"" << vm[ iteration_out_param ].as<std::string>() << "\" "; }
   if( vm.count( session_out_param ) ) { std::cout << session_out_param << " \"" << vm[ session_out_param ].as<std::string>() << "\" "; }
+  if( vm.count( checkpoint_param ) )  { std::cout << checkpoint_param << " \"" << vm[ checkpoint_param ].as<std::string>() << "\" "
+                                                  << checkpoint_interval_param << " \"" << vm[ checkpoint_interval_param ].as<iteration_type>() << "\" "; }
+  if( vm.count( resume_param ) )      { std::cout << resume_param << ' '; }
+  std::cout << log_level_param << " \"" << vm[ log_level_param ].as<std::string>() << "\" ";
   std::cout << std::endl;
+
+  if( vm.count( render_out_param ) )
+  { std::cout << "render options: " << render_out_param << " \"" << vm[ render_out_param ].as<std::string>() << "\" "
+              << render_interval_param << " \"" << vm[ render_interval_param ].as<iteration_type>() << "\" "
+              << render_width_param << " \"" << vm[ render_width_param ].as<stride_type>() << "\" "
+              << render_height_param << " \"" << vm[ render_height_param ].as<stride_type>() << "\" ";
+    if( vm.count( render_geodesics_param ) ) { std::cout << render_geodesics_param << " \"" << vm[ render_geodesics_param ].as<size_t>() << "\" "; }
+    std::cout << std::endl;
+  }
   
   //----| model
 
@@ -148,9 +266,157 @@ int main (int argc, char *argv[])
     distfile.close();
   }
 
+  //----| model - solver
+
+  solver_type solver_token = vm[ solver_param ].as<solver_type>();
+  std::cout << solver_param << ' ' << solver_token << std::endl;
+
+  // creates the solver for a surface - returns a null pointer after reporting an error
+  auto create_solver = [&]( const std::shared_ptr< surface_t >& surface ) -> std::shared_ptr< flat::Solver >
+  {
+    // spring solver
+    if( solver_token.find("spring") != std::string::npos )
+    {
+      bool no_inertia = solver_token.find("inertia") == std::string::npos;
+      bool subspace = solver_token.find("embed") == std::string::npos;
+
+      if( no_inertia && subspace )
+      {
+        typedef spring::SpringSolver< true, true >	solver_t;
+        solver_t* new_solver = new solver_t( surface );
+
+        if( vm.count( stepsize_param ) ) new_solver->integrator().set_stepsize( vm[ stepsize_param ].as<stepsize_type>() );
+        if( vm.count( stiffness_param ) )new_solver->force().set_stiffness( vm[ stiffness_param ].as<coeff_type>() );
+      
+        return std::shared_ptr< flat::Solver >( new_solver );
+      }else  
+      if( no_inertia )
+      {
+        typedef spring::SpringSolver< true, false >	solver_t;
+        solver_t* new_solver = new solver_t( surface );
+
+        if( vm.count( stepsize_param ) ) new_solver->integrator().set_stepsize( vm[ stepsize_param ].as<stepsize_type>() );
+        if( vm.count( stiffness_param ) )new_solver->force().set_stiffness( vm[ stiffness_param ].as<coeff_type>() );
+        if( vm.count( ground_param ) )   new_solver->force().set_ground_attraction( vm[ ground_param ].as<coeff_type>() );
+      
+        return std::shared_ptr< flat::Solver >( new_solver );
+      }else
+      if( subspace )
+      {
+        typedef spring::SpringSolver< false, true >	solver_t;
+        solver_t* new_solver = new solver_t( surface );
+
+        if( vm.count( stepsize_param ) ) new_solver->integrator().set_stepsize( vm[ stepsize_param ].as<stepsize_type>() );
+        if( vm.count( stiffness_param ) )new_solver->force().set_stiffness( vm[ stiffness_param ].as<coeff_type>() );
+        if( vm.count( dampening_param ) )new_solver->force().set_dampening( vm[ dampening_param ].as<coeff_type>() );
+        if( vm.count( friction_param ) ) new_solver->force().set_friction( vm[ friction_param ].as<coeff_type>() );
+      
+        return std::shared_ptr< flat::Solver >( new_solver );
+      }else
+      {
+        typedef spring::SpringSolver< false, false >	solver_t;
+        solver_t* new_solver = new solver_t( surface );
+
+        if( vm.count( stepsize_param ) ) new_solver->integrator().set_stepsize( vm[ stepsize_param ].as<stepsize_type>() );
+        if( vm.count( stiffness_param ) )new_solver->force().set_stiffness( vm[ stiffness_param ].as<coeff_type>() );
+        if( vm.count( dampening_param ) )new_solver->force().set_dampening( vm[ dampening_param ].as<coeff_type>() );      
+        if( vm.count( ground_param ) )   new_solver->force().set_ground_attraction( vm[ ground_param ].as<coeff_type>() );
+        if( vm.count( friction_param ) ) new_solver->force().set_friction( vm[ friction_param ].as<coeff_type>() );
+      
+        return std::shared_ptr< flat::Solver >( new_solver );
+      }
+    }else // mds solver
+    if( solver_token.find("mds") != std::string::npos )
+    {
+      bool equal_weights = solver_token.find("equal") != std::string::npos;
+
+      mds::Solver* new_solver;
+
+      if( equal_weights )
+        new_solver = new mds::EqualWeightSolver( surface );
+      else  
+      {
+        mds::GeneralSolver* general_solver = new mds::GeneralSolver( surface );
+        new_solver = general_solver;
+
+        if( vm.count( mds_weighting_param ) )
+        {
+          const std::string weighting_token = vm[ mds_weighting_param ].as<std::string>();
+
+          if( weighting_token == "sammon" )
+            general_solver->set_weighting( mds::GeneralSolver::SAMMON );
+          else if( weighting_token == "banded" )
+          {
+            if( !vm.count( mds_band_param ) || vm[ mds_band_param ].as<coeff_type>() <= 0 )
+            { std::cerr << "ERROR - banded weighting needs a positive \"" << mds_band_param << "\"." << std::endl;
+              delete general_solver;
+              return std::shared_ptr< flat::Solver >();
+            }
+            general_solver->set_weighting( mds::GeneralSolver::BANDED, vm[ mds_band_param ].as<coeff_type>() );
+          }else if( weighting_token != "equal" )
+          { std::cerr << "ERROR - unknown weighting \"" << weighting_token << "\" specified." << std::endl;
+            delete general_solver;
+            return std::shared_ptr< flat::Solver >();
+          }
+        }
+
+        if( vm.count( mds_pivots_param ) )  general_solver->set_pivots( vm[ mds_pivots_param ].as<iteration_type>() );
+      }
+
+      if( vm.count( mds_iterations_param ) ) new_solver->set_iterations( vm[ mds_iterations_param ].as<iteration_type>() );
+      if( vm.count( mds_tolerance_param ) )  new_solver->set_stress_tolerance( vm[ mds_tolerance_param ].as<coeff_type>() );
+      if( vm.count( mds_landmarks_param ) )  new_solver->set_landmarks( vm[ mds_landmarks_param ].as<iteration_type>() );
+
+      return std::shared_ptr< flat::Solver >( new_solver );
+    }else 
+    { std::cerr << "ERROR - no or unknown solver \"" << solver_token << "\" specified." << std::endl; 
+      return std::shared_ptr< flat::Solver >(); 
+    }
+  };
+
   //----| create surface
   std::shared_ptr<surface_t> surface;  
+
+  // describes the result in session files
+  flat::session::metadata   session_meta;
+  std::unique_ptr< flat::session::file >    result_in;
+  // iteration and squared distance error at every checkpoint
+  std::vector< double >     history;
+
+  // a resumed run continues from its checkpoint like from a result file
+  std::string result_in_path( vm.count( result_in_param ) ? vm[ result_in_param ].as< std::string >() : std::string() );
+
+  if( vm.count( resume_param ) )
+  {
+    if( !vm.count( checkpoint_param ) )
+    { std::cerr << "ERROR - \"" << resume_param << "\" needs a \"" << checkpoint_param << "\" file." << std::endl;
+      return 0;
+    }
+
+    if( std::ifstream( vm[ checkpoint_param ].as< std::string >().c_str() ) )
+      result_in_path = vm[ checkpoint_param ].as< std::string >();
+    else
+      UTK_LOG( INFO, "cli_flatter\t| no checkpoint \"" << vm[ checkpoint_param ].as< std::string >() << "\" yet - starting from the beginning" );
+  }
   
+  if( !result_in_path.empty() )
+  {
+    try
+    { result_in.reset( new flat::session::file( result_in_path ) );
+    }catch( const std::exception& e )
+    { std::cerr << "ERROR - " << e.what() << std::endl;
+      return 0;
+    }
+
+    // the distances are computed from the original locations, the result is restored after the solver is set up
+    flat::session::Generator     generator( *result_in );
+    flat::session::Triangulator  triangulator( *result_in );
+    flat::NoTransform            transform;
+    surface = surface_t::create_with_generator( generator, triangulator, transform, initial_distances );
+
+    session_meta = result_in->meta();
+    history.assign( result_in->history(), result_in->history() + 2 * result_in->history_size() );
+  }else
   if( vm.count( surface_file_param ) )
   {
     const stride_type default_stride = 80;
@@ -158,10 +424,41 @@ int main (int argc, char *argv[])
 	stride_type stride_y = vm.count( stride_y_param ) ? vm[stride_y_param].as<stride_type>() : default_stride;
 	  
     std::string path( vm[ surface_file_param ].as< std::string >() );
+
+    if( vm.count( surface_binary_out_param ) )
+    { flat::pdm::convert_to_binary( path, vm[ surface_binary_out_param ].as< std::string >() );
+      path = vm[ surface_binary_out_param ].as< std::string >();
+    }
+
+    // tiled flattening - the surface is never loaded as a whole
+    if( vm.count( tile_size_param ) )
+    {
+      if( !vm.count( tiled_out_param ) )
+      { std::cerr << "ERROR - tiled flattening needs an output file - use \"" << tiled_out_param << "\"." << std::endl;
+        return 0;
+      }
+
+      try
+      {
+        const flat::TiledFlattener flattener( path, { stride_x, stride_y }
+                                            , vm[ tile_size_param ].as< stride_type >(), vm[ tile_overlap_param ].as< stride_type >()
+                                            , vm[ iterations_param ].as< iteration_type >(), create_solver );
+        flattener( vm[ tiled_out_param ].as< std::string >() );
+      }catch( const std::exception& e )
+      { std::cerr << "ERROR - " << e.what() << std::endl;
+        return 0;
+      }
+
+      return true;
+    }
+
     flat::PdmFileReader<flat::stride_predicate> generator( path, flat::stride_predicate( { stride_x, stride_y } ) );
     flat::SimpleRectlinearTriangulator          triangulator( generator.vertex_field_size() );
     flat::CenterRescaleTransform                transform( utk::vec3b(true), utk::vec3b(true) );
     surface = surface_t::create_with_generator( generator, triangulator, transform, initial_distances );
+
+    // the full texture is decoded from the scan
+    session_meta.source = path;
   }else
   if( vm.count( generator_param ) )
   { 
@@ -187,83 +484,106 @@ int main (int argc, char *argv[])
     return 0;
   }
 
+  // the solvers move the vertices - keep the surface they started from for session files
+  std::vector< location_t > original_locations;
+  if( vm.count( result_out_param ) || vm.count( checkpoint_param ) )
+    original_locations = surface->geometry().locations();
+
   //----| model - solver
 
-  std::shared_ptr<flat::Solver> solver;  
+  std::shared_ptr<flat::Solver> solver( create_solver( surface ) );
+  if( !solver ) return 0;
 
-  solver_type solver_token = vm[ solver_param ].as<solver_type>();
-  std::cout << solver_param << ' ' << solver_token << std::endl;
-  
-  // spring solver
-  if( solver_token.find("spring") != std::string::npos )
+  # if defined CLI_FLATTER__OFFSCREEN_OUTPUT
+
+  //----| offscreen rendering
+
+  // the drawables use the context of the renderer and are destroyed before it
+  std::unique_ptr< gl::OffscreenRenderer >  renderer;
+  std::unique_ptr< mmp::Geodesics >         geodesics;
+  std::unique_ptr< gl::SurfaceDrawable >    surface_drawable;
+  std::unique_ptr< gl::GeodesicsDrawable >  geodesics_drawable;
+  // compresses the frames while the solver goes on
+  std::unique_ptr< flat::FrameRecorder >    recorder;
+
+  if( vm.count( render_out_param ) )
   {
-    bool no_inertia = solver_token.find("inertia") == std::string::npos;
-    bool subspace = solver_token.find("embed") == std::string::npos;
+    try
+    { renderer.reset( new gl::OffscreenRenderer( vm[ render_width_param ].as< stride_type >(), vm[ render_height_param ].as< stride_type >() ) );
+    }catch( const std::exception& e )
+    { std::cerr << "ERROR - " << e.what() << std::endl;
+      return 0;
+    }
 
-    if( no_inertia && subspace )
-    {
-      typedef spring::SpringSolver< true, true >	solver_t;
-      solver_t* new_solver = new solver_t( surface );
+    // flattening keeps the extent of the surface - the camera stays where it frames the original
+    const location_t center( ( surface->min_location() + surface->max_location() ) / coord_t( 2 ) );
+    renderer->look_at( center, std::max( coord_t( ( surface->max_location() - surface->min_location() ).length() / 2 ), coord_t( 1e-3 ) ) );
 
-      if( vm.count( stepsize_param ) ) new_solver->integrator().set_stepsize( vm[ stepsize_param ].as<stepsize_type>() );
-      if( vm.count( stiffness_param ) )new_solver->force().set_stiffness( vm[ stiffness_param ].as<coeff_type>() );
-      
-      solver.reset( new_solver );
-    }else  
-    if( no_inertia )
-    {
-      typedef spring::SpringSolver< true, false >	solver_t;
-      solver_t* new_solver = new solver_t( surface );
+    recorder.reset( new flat::FrameRecorder() );
 
-      if( vm.count( stepsize_param ) ) new_solver->integrator().set_stepsize( vm[ stepsize_param ].as<stepsize_type>() );
-      if( vm.count( stiffness_param ) )new_solver->force().set_stiffness( vm[ stiffness_param ].as<coeff_type>() );
-      if( vm.count( ground_param ) )   new_solver->force().set_ground_attraction( vm[ ground_param ].as<coeff_type>() );
-      
-      solver.reset( new_solver );
-    }else
-    if( subspace )
-    {
-      typedef spring::SpringSolver< false, true >	solver_t;
-      solver_t* new_solver = new solver_t( surface );
+    surface_drawable.reset( new gl::SurfaceDrawable( surface ) );
 
-      if( vm.count( stepsize_param ) ) new_solver->integrator().set_stepsize( vm[ stepsize_param ].as<stepsize_type>() );
-      if( vm.count( stiffness_param ) )new_solver->force().set_stiffness( vm[ stiffness_param ].as<coeff_type>() );
-      if( vm.count( dampening_param ) )new_solver->force().set_dampening( vm[ dampening_param ].as<coeff_type>() );
-      if( vm.count( friction_param ) ) new_solver->force().set_friction( vm[ friction_param ].as<coeff_type>() );
-      
-      solver.reset( new_solver );
-    }else
+    if( !surface_drawable->set_vertex_mode( vm[ render_vertices_param ].as< std::string >() )
+     || !surface_drawable->set_edge_mode( vm[ render_edges_param ].as< std::string >() )
+     || !surface_drawable->set_face_mode( vm[ render_faces_param ].as< std::string >() ) )
+    { std::cerr << "ERROR - unsupported surface render mode specified." << std::endl;
+      return 0;
+    }
+
+    renderer->add_drawable( surface_drawable.get() );
+
+    // the windows are propagated over the original surface and drawn over the flattened one
+    if( vm.count( render_geodesics_param ) )
     {
-      typedef spring::SpringSolver< false, false >	solver_t;
-      solver_t* new_solver = new solver_t( surface );
-
-      if( vm.count( stepsize_param ) ) new_solver->integrator().set_stepsize( vm[ stepsize_param ].as<stepsize_type>() );
-      if( vm.count( stiffness_param ) )new_solver->force().set_stiffness( vm[ stiffness_param ].as<coeff_type>() );
-      if( vm.count( dampening_param ) )new_solver->force().set_dampening( vm[ dampening_param ].as<coeff_type>() );      
-      if( vm.count( ground_param ) )   new_solver->force().set_ground_attraction( vm[ ground_param ].as<coeff_type>() );
-      if( vm.count( friction_param ) ) new_solver->force().set_friction( vm[ friction_param ].as<coeff_type>() );
-      
-      solver.reset( new_solver );
+      const size_t source = vm[ render_geodesics_param ].as< size_t >();
+
+      if( source >= surface->num_vertices() )
+      { std::cerr << "ERROR - the geodesics source " << source << " is no vertex of the surface." << std::endl;
+        return 0;
+      }
+
+      geodesics.reset( new mmp::Geodesics( *surface, source ) );
+      geodesics->propagate_paths();
+
+      geodesics_drawable.reset( new gl::GeodesicsDrawable( geodesics.get() ) );
+      renderer->add_drawable( geodesics_drawable.get() );
     }
-  }else // mds solver
-  if( solver_token.find("mds") != std::string::npos )
+  }
+
+  const iteration_type render_interval = vm[ render_interval_param ].as<iteration_type>();
+
+  // frames are named by the iteration so they sort in order
+  auto render_frame = [&]( const iteration_type iteration )
   {
-    bool equal_weights = solver_token.find("equal") != std::string::npos;
+    if( !renderer ) return;
 
-    if( equal_weights )
-    {
-      typedef mds::EqualWeightSolver	solver_t;
-      solver_t* new_solver = new solver_t( surface );
-      solver.reset( new_solver );
-    }else  
-    {
-      typedef mds::GeneralSolver	solver_t;
-      solver_t* new_solver = new solver_t( surface );
-      solver.reset( new_solver );
+    std::ostringstream path;
+    path << vm[ render_out_param ].as< std::string >() << std::setw( 6 ) << std::setfill( '0' ) << iteration << ".png";
+
+    try
+    { const std::vector< unsigned char >& pixels = renderer->render();
+
+      // every frame of a regression video is kept - waits for a buffer instead of dropping the frame
+      flat::FrameRecorder::frame* contents = recorder->acquire( renderer->width(), renderer->height(), true );
+      std::copy( pixels.begin(), pixels.end(), contents->pixels.begin() );
+      recorder->submit( contents, path.str() );
+    }catch( const std::exception& e )
+    { UTK_LOG( ERROR, "cli_flatter\t| frame of iteration " << iteration << " not rendered - " << e.what() );
     }
-  }else 
-  { std::cerr << "ERROR - no or unknown solver \"" << solver_token << "\" specified." << std::endl; 
-    return 0; 
+  };
+
+  # else
+
+  if( vm.count( render_out_param ) )
+  { std::cerr << "ERROR - cli_flatter was built without the offscreen renderer" << std::endl;
+    return 0;
+  }
+
+  # endif
+
+  if( result_in )
+  { result_in->restore_locations( *surface );
+    result_in->restore_solver( solver_token, *solver );
   }
 
   //----| export distance matrix
@@ -281,32 +601,105 @@ int main (int argc, char *argv[])
   //max_iterations
   iteration_type max_iterations = vm[ iterations_param ].as<iteration_type>();
 
+  // resumed runs stop at max_iterations in total, all others do max_iterations more
+  const iteration_type first_iteration = session_meta.iteration;
+  const iteration_type last_iteration  = vm.count( resume_param ) ? std::max( first_iteration, max_iterations ) 
+                                                                   : first_iteration + max_iterations;
+
   const bool iteration_out = vm.count( iteration_out_param );
+
+  //checkpoints
+  const iteration_type checkpoint_interval = vm[ checkpoint_interval_param ].as<iteration_type>();
+
+  std::unique_ptr< flat::session::CheckpointWriter >  checkpoints;
+  if( vm.count( checkpoint_param ) )
+    checkpoints.reset( new flat::session::CheckpointWriter( vm[ checkpoint_param ].as< std::string >() ) );
+
+  // copies everything a session file holds - the copy is cheap compared to writing it
+  auto take_snapshot = [&]( const iteration_type iteration ) -> std::unique_ptr< flat::session::snapshot >
+  {
+    session_meta.name         = surface->get_name();
+    session_meta.solver       = solver_token;
+    session_meta.field_size   = surface->vertices_size();
+    session_meta.texture_size = surface->texture().size;
+    session_meta.iteration    = iteration;
+
+    if( history.empty() || history[ history.size() - 2 ] != iteration )
+    { history.push_back( iteration );
+      history.push_back( surface->get_squared_distance_error().first );
+    }
+
+    return std::unique_ptr< flat::session::snapshot >( new flat::session::snapshot( session_meta, *surface, original_locations, solver->get_state(), history ) );
+  };
     
   std::time_t it_start_time = std::clock();
 
-  if( iteration_out )
-    for( size_t iteration = 0; iteration < max_iterations; ++iteration )
+  for( iteration_type iteration = first_iteration; iteration < last_iteration; ++iteration )
+  {
+    if( iteration_out )
     {
       auto total_sqr_error = surface->get_squared_distance_error();
       std::cout << iteration << '\t' << total_sqr_error.first << " (" << total_sqr_error.second << ')' << std::endl;
-      solver->step();
     }
-  else
-    for( size_t iteration = 0; iteration < max_iterations; ++iteration )
-      solver->step();
+
+    # if defined CLI_FLATTER__OFFSCREEN_OUTPUT
+    if( render_interval && ( iteration - first_iteration ) % render_interval == 0 )
+      render_frame( iteration );
+    # endif
+
+    solver->step();
+
+    // the last iteration is stored below
+    if( checkpoints && checkpoint_interval && ( iteration + 1 ) % checkpoint_interval == 0 && iteration + 1 < last_iteration )
+      checkpoints->submit( take_snapshot( iteration + 1 ) );
+  }
     
   double it_time = (std::clock() - it_start_time)/double(CLOCKS_PER_SEC);
+
+  if( checkpoints || vm.count( result_out_param ) )
+  {
+    std::unique_ptr< flat::session::snapshot > result( take_snapshot( last_iteration ) );
+
+    if( vm.count( result_out_param ) )
+      flat::session::write( vm[ result_out_param ].as< std::string >(), *result );
+
+    if( checkpoints )
+    { checkpoints->submit( std::move( result ) );
+      checkpoints->flush();
+    }
+  }
     
   if( vm.count( session_out_param ) ) 
   {
     auto total_sqr_error = surface->get_squared_distance_error();
-    std::cout << max_iterations <<  '\t' << total_sqr_error.first << " (" << total_sqr_error.second << ')' << '\t' << it_time << std::endl;
+    std::cout << last_iteration <<  '\t' << total_sqr_error.first << " (" << total_sqr_error.second << ')' << '\t' << it_time << std::endl;
+  }
+
+  # if defined CLI_FLATTER__OFFSCREEN_OUTPUT
+  render_frame( last_iteration );
+  # endif
+
+  if( vm.count( texture_out_param ) )
+  {
+    flat::TextureRasterizer::options options;
+    options.weighted_alignment = !vm.count( regular_alignment_param );
+    options.texel_outline      = vm.count( texel_outline_param );
+    options.block_outline      = vm.count( block_outline_param );
+    options.texel_size         = vm[ texel_size_param ].as< float >();
+
+    try
+    { flat::TextureRasterizer( *surface, options ).write_png( vm[ texture_out_param ].as< std::string >() );
+    }catch( const std::exception& e )
+    { UTK_LOG( ERROR, "cli_flatter\t| texture image not written - " << e.what() );
+    }
   }
 
   # if defined CLI_FLATTER__GL_OUTPUT
   
   //----| OpenGL output
+
+  // rendering to files needs no window
+  if( vm.count( render_out_param ) ) return true;
   
     // init gtkmm
   Gtk::Main kit(argc, argv);
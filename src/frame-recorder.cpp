@@ -0,0 +1,145 @@
+//           frame-recorder.cpp
+//  Copyright  2011  Peter Urban
+//  <s9peurba@stud.uni-saarland.de>
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+
+# include "frame-recorder.h"
+
+# include "png-writer.h"
+
+# include "utk/log.h"
+
+# include <algorithm>
+# include <cassert>
+
+using namespace flat;
+
+FrameRecorder::FrameRecorder( const size_t num_buffers, const size_t num_threads )
+: m_writing( 0 ), m_stop( false ), m_recorded( 0 ), m_dropped( 0 )
+{
+  assert( num_buffers );
+
+  for( size_t b = 0; b < num_buffers; ++b )
+  { m_frames.push_back( std::unique_ptr< frame >( new frame ) );
+    m_free.push_back( m_frames.back().get() );
+  }
+
+  const size_t threads = num_threads ? num_threads : std::max( 1u, std::thread::hardware_concurrency() / 2 );
+
+  for( size_t t = 0; t < threads; ++t )
+    m_threads.push_back( std::thread( [this]() { run(); } ) );
+}
+
+FrameRecorder::~FrameRecorder()
+{
+  {
+    std::lock_guard< std::mutex > lock( m_mutex );
+    m_stop = true;
+  }
+  m_condition.notify_all();
+
+  std::for_each( m_threads.begin(), m_threads.end(), []( std::thread& thread ) { thread.join(); } );
+
+  UTK_LOG( INFO, "flat::FrameRecorder::~FrameRecorder\t| " << m_recorded << " frames recorded " << m_dropped << " dropped" );
+}
+
+FrameRecorder::frame*   FrameRecorder::acquire( const size_t width, const size_t height, const bool wait )
+{
+  std::unique_lock< std::mutex > lock( m_mutex );
+
+  if( wait )
+    m_condition.wait( lock, [this]() { return !m_free.empty(); } );
+
+  if( m_free.empty() )
+  {
+    if( !m_dropped++ )
+      UTK_LOG( WARNING, "flat::FrameRecorder::acquire\t| dropping frames - the disk is slower than the renderer" );
+    return 0;
+  }
+
+  frame* contents = m_free.back();
+  m_free.pop_back();
+  lock.unlock();
+
+  // the buffers keep their capacity, so recording at a fixed size allocates nothing
+  contents->width  = width;
+  contents->height = height;
+  contents->pixels.resize( 3 * width * height );
+
+  return contents;
+}
+
+void    FrameRecorder::submit( frame* contents, const std::string& path )
+{
+  assert( contents );
+
+  contents->path = path;
+  {
+    std::lock_guard< std::mutex > lock( m_mutex );
+    m_queue.push_back( contents );
+  }
+  m_condition.notify_all();
+}
+
+void    FrameRecorder::flush()
+{
+  std::unique_lock< std::mutex > lock( m_mutex );
+  m_condition.wait( lock, [this]() { return m_queue.empty() && !m_writing; } );
+}
+
+size_t  FrameRecorder::recorded()
+{
+  std::lock_guard< std::mutex > lock( m_mutex );
+  return m_recorded;
+}
+
+size_t  FrameRecorder::dropped()
+{
+  std::lock_guard< std::mutex > lock( m_mutex );
+  return m_dropped;
+}
+
+void    FrameRecorder::run()
+{
+  std::unique_lock< std::mutex > lock( m_mutex );
+
+  for( ;; )
+  {
+    m_condition.wait( lock, [this]() { return !m_queue.empty() || m_stop; } );
+
+    // the queued frames are written even when stopping
+    if( m_queue.empty() ) return;
+
+    frame* contents = m_queue.front();
+    m_queue.pop_front();
+    ++m_writing;
+    lock.unlock();
+
+    bool written = true;
+    try
+    { write_png( contents->path, contents->width, contents->height, contents->pixels.data(), true );
+    }catch( const std::exception& e )
+    { UTK_LOG( ERROR, "flat::FrameRecorder\t| " << e.what() );
+      written = false;
+    }
+
+    lock.lock();
+    --m_writing;
+    if( written ) ++m_recorded;
+    m_free.push_back( contents );
+    m_condition.notify_all();
+  }
+}
@@ -0,0 +1,96 @@
+/***************************************************************************
+ *            frame-recorder.h
+ *
+ *  Copyright  2011  Peter Urban
+ *  <s9peurba@stud.uni-saarland.de>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+# pragma once
+
+# include <condition_variable>
+# include <deque>
+# include <memory>
+# include <mutex>
+# include <string>
+# include <thread>
+# include <vector>
+
+namespace flat
+{
+  // compresses and writes frames to png files on a pool of background threads
+  // - frames are copied into a fixed ring of buffers that are reused once written
+  // - acquire hands out no buffer while all are queued or being written, the caller
+  //   either drops the frame or waits for the disk
+  class FrameRecorder
+  {
+    public:
+
+      struct frame
+      {
+        size_t  width;
+        size_t  height;
+        // 8 bit rgb rows, bottom row first as read by glReadPixels
+        std::vector< unsigned char >    pixels;
+        std::string     path;
+      };
+
+    private:
+
+      std::vector< std::unique_ptr< frame > >   m_frames;
+
+      std::mutex                m_mutex;
+      std::condition_variable   m_condition;
+
+      std::vector< frame* >     m_free;
+      std::deque< frame* >      m_queue;
+      size_t    m_writing;
+      bool      m_stop;
+
+      size_t    m_recorded;
+      size_t    m_dropped;
+
+      std::vector< std::thread >    m_threads;
+
+      void  run();
+
+      FrameRecorder( const FrameRecorder& );
+      FrameRecorder&    operator=( const FrameRecorder& );
+
+    public:
+
+      // num_threads 0 uses half of the cores
+      FrameRecorder( const size_t num_buffers = 8, const size_t num_threads = 0 );
+
+      // writes the queued frames before the threads end
+      ~FrameRecorder();
+
+      // a buffer for a frame of width x height pixels - null if wait is not set
+      // and every buffer is taken, the frame then counts as dropped
+      frame*    acquire( const size_t width, const size_t height, const bool wait = false );
+
+      // queues the acquired frame for writing to path
+      void      submit( frame* contents, const std::string& path );
+
+      // blocks until all submitted frames are written
+      void      flush();
+
+      size_t    recorded();
+      size_t    dropped();
+  };
+}
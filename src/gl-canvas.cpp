@@ -20,6 +20,8 @@
 # include "gl-canvas.h"
 # include "gl-tools.h"
 
+# include <chrono>
+
 using namespace gtk;
 
 flat::coord_t	GLCanvas::cam_dist_step = 0.1;
@@ -120,7 +122,9 @@ bool GLPixmapRenderTarget::configure( const size_t width, const size_t height )
 GLCanvas::GLCanvas( BaseObjectType* cobject, const Glib::RefPtr<Gtk::Builder>& builder )
 : Gtk::DrawingArea( cobject ), 
   cam_dist( 10. ), cam_center( 0. ), cam_inertial(), 
-  m_show_origin( false ), m_show_pivot( true )
+  m_show_origin( false ), m_show_pivot( true ),
+  m_content_transformation_valid( false ),
+  m_redraw_requested( false ), m_rendering( GLRenderTarget::WINDOW ), m_frame_time( 0. ), m_frames( 0 )
 { 
   # if defined DBG_FLAT_GLCANVAS
   std::clog << "flat::GLCanvas::GLCanvas" <<std::endl;
@@ -142,59 +146,14 @@ GLCanvas::GLCanvas( BaseObjectType* cobject, const Glib::RefPtr<Gtk::Builder>& b
 
 void GLCanvas::gl_initialize_context()
 {
-  glClearColor(.2, .2, .2, 1.);
-  glClearDepth(1.0);
-  
-  glDepthFunc( GL_LEQUAL );
-  glEnable(GL_DEPTH_TEST);
-  
-  glEnable( GL_BLEND );
-  glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-
-  glEnable( GL_LINE_SMOOTH );
-
-  //glDisable( GL_CULL_FACE );
-  //glCullFace(GL_BACK);
-
-  glEnable(GL_POLYGON_OFFSET_FILL);
-  glPolygonOffset (1., 1.);
-
-  //glEnable( GL_LIGHTING );
-
-  glShadeModel( GL_SMOOTH );
-
-  glEnable( GL_COLOR_MATERIAL );
-
-  glLightModeli( GL_LIGHT_MODEL_COLOR_CONTROL, GL_SEPARATE_SPECULAR_COLOR );
-  
-  glEnable( GL_LIGHT0 );
-
-  // create light components
-  GLfloat ambientLight[]  =	{ 0.15f, 0.15f, 0.15f, 1.f };
-  GLfloat diffuseLight[]  =	{   .7f,   .7f,   .7f, 1.f };
-  GLfloat specularLight[] = {   .2f,   .2f,   .2f, 1.f };
-  
-  GLfloat position[] 	  = {   0.f,   0.f, -10.0f, 1.f };
-
-  // assign created components to GL_LIGHT0
-  glLightfv( GL_LIGHT0, GL_AMBIENT, ambientLight );
-  glLightfv( GL_LIGHT0, GL_DIFFUSE, diffuseLight );
-  glLightfv( GL_LIGHT0, GL_SPECULAR, specularLight );
-  glLightfv( GL_LIGHT0, GL_POSITION, position );
-
+  gl::InitializeContext();
   
   gl::PrintError();
 }
 
 void GLCanvas::gl_setup_view( const float width, const float height )
 {
-  glViewport(0, 0, width, height);
-
-  glMatrixMode( GL_PROJECTION );
-  glLoadIdentity();
-  gluPerspective( 40.f, width/float(height), 0.001f, 100.f );
-  glMatrixMode( GL_MODELVIEW );
-  glLoadIdentity();
+  gl::SetupView( width, height );
 }
 
 bool GLCanvas::on_configure_event( GdkEventConfigure* event )
@@ -217,6 +176,11 @@ void GLCanvas::gl_render_scene()
   
   gl::InvTrafo( cam_inertial ); // -> gl_setup_view
 
+  glGetDoublev( GL_MODELVIEW_MATRIX, m_content_modelview );
+  glGetDoublev( GL_PROJECTION_MATRIX, m_content_projection );
+  glGetIntegerv( GL_VIEWPORT, m_content_viewport );
+  m_content_transformation_valid = true;
+
   // draw viewing pivot
   if( get_pivot_visibility() )
   { glPushMatrix();
@@ -235,20 +199,44 @@ void GLCanvas::gl_render_scene()
 
 }
 
+bool	GLCanvas::on_render_tick()
+{
+  // the timer ends with the requests
+  if( !m_redraw_requested ) return false;
+
+  m_redraw_requested = false;
+  Gtk::DrawingArea::queue_draw();
+  return true;
+}
+
+void	GLCanvas::measure_frame( const double seconds )
+{
+  m_frame_time = m_frames ? .9 * m_frame_time + .1 * seconds : seconds;
+  ++m_frames;
+}
+
 bool 	GLCanvas::render_to_window()
 {
   # if defined DBG_FLAT_GLCANVAS
   std::clog << "GLCanvas::render_to_window\t\t|" << std::endl;
   # endif
     
+  const auto start = std::chrono::steady_clock::now();
+
   m_active_target->gl_begin_context();
 
+    m_rendering = m_active_target->get_type();
+
     gl_render_scene();
 
+    m_frame_rendered_signal( get_width(), get_height() );
+
     m_active_target->gl_finish();
   
   m_active_target->gl_end_context();
 
+  measure_frame( std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count() );
+
   // integrate into GLPixmapRenderTarget
   if( m_active_target->get_type() == GLRenderTarget::PIXMAP )
   {
@@ -279,6 +267,8 @@ bool 	GLCanvas::render_to_pixmap()
   pix_target->configure(get_width(),get_height());
   pix_target->gl_begin_context();
 
+    m_rendering = GLRenderTarget::PIXMAP;
+
     gl_render_scene();
 
     pix_target->gl_finish();
@@ -317,9 +307,29 @@ bool GLCanvas::on_button_press_event( GdkEventButton* event )
   old_mouse_pos.x() = event->x;
   old_mouse_pos.y() = event->y;
 
+  if( event->button == 2 ) pick( event->x, event->y );
+
   // don't block
   return false;
 }
+
+void	GLCanvas::pick( const double x, const double y )
+{
+  if( !m_content_transformation_valid ) return;
+
+  // window rows count from the top, gl rows from the bottom
+  const double row = m_content_viewport[3] - y;
+
+  location_t near, far, next_far;
+  gluUnProject( x, row, 0., m_content_modelview, m_content_projection, m_content_viewport, &near[0], &near[1], &near[2] );
+  gluUnProject( x, row, 1., m_content_modelview, m_content_projection, m_content_viewport, &far[0], &far[1], &far[2] );
+  gluUnProject( x + 1., row, 1., m_content_modelview, m_content_projection, m_content_viewport, &next_far[0], &next_far[1], &next_far[2] );
+
+  const coord_t depth = utk::length( far - near );
+  if( !( depth > 0 ) ) return;
+
+  m_pick_signal( utk::ray< coord_t, 3 >( near, far ), utk::length( next_far - far ) / depth );
+}
  
 bool GLCanvas::on_motion_notify_event(GdkEventMotion* event)
 {
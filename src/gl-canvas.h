@@ -33,8 +33,10 @@
 
 # include "common.h"
 # include "utk/inertial.h"
+# include "utk/ray.h"
 
 # include <array>
+# include <functional>
 # include <boost/signals.hpp>
 
 namespace gtk
@@ -76,12 +78,15 @@ namespace gtk
 
 	  void gl_end_context() { m_drawable->gl_end(); }
 
+	  // the context exists once the target is configured
+	  bool has_context()	const	{ return m_context; }
+
+	  // swapping implies a flush - waiting for the gl would also wait for pending frame read backs
 	  void gl_finish() 
 	  { 
 		assert( m_drawable );
-		glFinish();
 		if( m_drawable->is_double_buffered() ) m_drawable->swap_buffers();
-  		else glFlush();
+  		else glFinish();
 	  }
 	  
 	  virtual bool configure( const size_t width, const size_t height) = 0;
@@ -125,6 +130,11 @@ namespace gtk
 	  
 	  typedef boost::signal<void()>	content_request_signal;
 	  typedef boost::signal< void( const Glib::RefPtr<Gdk::Pixmap>& ) >	pixmap_update_signal;
+	  // emitted in the context after the scene is drawn and before the buffers are swapped
+	  typedef boost::signal< void( const size_t width, const size_t height ) >	frame_rendered_signal;
+	  // emitted for a click of the middle button - the ray runs from the near to the far plane through the pixel
+	  // clicked in the coordinates the content is drawn in, pixel_angle is the size of a pixel per unit distance
+	  typedef boost::signal< void( const utk::ray< coord_t, 3 >& ray, const coord_t pixel_angle ) >	pick_signal;
 	  
 	private:
 
@@ -136,12 +146,40 @@ namespace gtk
 
 	  pixmap_update_signal 	 m_pixmap_update_signal;
 
+	  frame_rendered_signal	 m_frame_rendered_signal;
+
+	  pick_signal			 m_pick_signal;
+
+	  // transformation of the content in the last frame - picking unprojects with it, so it matches what is seen
+	  GLdouble	m_content_modelview[16];
+	  GLdouble	m_content_projection[16];
+	  GLint		m_content_viewport[4];
+	  bool		m_content_transformation_valid;
+
+	  void	pick( const double x, const double y );
+
 	  std::array< std::shared_ptr< GLRenderTarget >, 2 > m_targets;
       
 	  std::shared_ptr< GLRenderTarget >	m_active_target;
 
 	  Glib::RefPtr< Gdk::Pixmap >	  m_pixmap;
 
+	  // redraw requests are coalesced to at most one redraw per tick of the render timer
+	  static const unsigned	render_interval = 16;
+
+	  bool				m_redraw_requested;
+	  sigc::connection	m_render_timer;
+
+	  // type of the target rendered to - the window context keeps display lists between frames
+	  GLRenderTarget::types_t	m_rendering;
+
+	  // running average of the time spent rendering a frame
+	  double	m_frame_time;
+	  size_t	m_frames;
+
+	  bool	on_render_tick();
+	  void	measure_frame( const double seconds );
+
 	  //used by render target
   	  void gl_initialize_context();
 	  void gl_setup_view( const float width, const float height );
@@ -173,7 +211,7 @@ namespace gtk
 	  GLCanvas( BaseObjectType* cobject
 		      , const Glib::RefPtr<Gtk::Builder>& builder );
 
-	  ~GLCanvas()	{		}
+	  ~GLCanvas()	{ m_render_timer.disconnect(); }
 
 	  void 	set_render_target( const GLRenderTarget::types_t target_type )
 	  {
@@ -194,8 +232,30 @@ namespace gtk
 
 	  bool render_to_window();
 	  bool render_to_pixmap();
+
+	  // calls function with the context of the active target current - not at all before the target is configured
+	  void	gl_invoke( const std::function< void() >& function )
+	  {
+		if( !m_active_target->has_context() ) return;
+
+		m_active_target->gl_begin_context();
+		function();
+		m_active_target->gl_end_context();
+	  }
 	  
-	  void	request_redraw()	{ Gtk::DrawingArea::queue_draw(); }
+	  void	request_redraw()
+	  { 
+		m_redraw_requested = true;
+		if( !m_render_timer.connected() )
+		  m_render_timer = Glib::signal_timeout().connect( sigc::mem_fun( *this, &GLCanvas::on_render_tick ), render_interval );
+	  }
+
+	  bool	is_rendering_to_window()	const	{ return m_rendering == GLRenderTarget::WINDOW; }
+
+	  // in seconds
+	  double	get_frame_time()	const	{ return m_frame_time; }
+	  // number of frames rendered so far
+	  size_t	get_frame_count()	const	{ return m_frames; }
 	  
 	  void	set_origin_visibility( const bool show )
 	  { 
@@ -226,6 +286,12 @@ namespace gtk
 	  boost::signals::connection connect_pixmap_observer( pixmap_update_signal::slot_type observer )
 	  { return m_pixmap_update_signal.connect( observer ); }
 
+	  boost::signals::connection connect_frame_observer( frame_rendered_signal::slot_type observer )
+	  { return m_frame_rendered_signal.connect( observer ); }
+
+	  boost::signals::connection connect_pick_observer( pick_signal::slot_type observer )
+	  { return m_pick_signal.connect( observer ); }
+
   };
   
 } // of namespace flat
\ No newline at end of file
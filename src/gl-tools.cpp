@@ -42,6 +42,60 @@ void	gl::PrintError()
 			  << "message: " << gluErrorString(code) << std::endl;
 }
 
+void	gl::InitializeContext()
+{
+  glClearColor(.2, .2, .2, 1.);
+  glClearDepth(1.0);
+  
+  glDepthFunc( GL_LEQUAL );
+  glEnable(GL_DEPTH_TEST);
+  
+  glEnable( GL_BLEND );
+  glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+
+  glEnable( GL_LINE_SMOOTH );
+
+  //glDisable( GL_CULL_FACE );
+  //glCullFace(GL_BACK);
+
+  glEnable(GL_POLYGON_OFFSET_FILL);
+  glPolygonOffset (1., 1.);
+
+  //glEnable( GL_LIGHTING );
+
+  glShadeModel( GL_SMOOTH );
+
+  glEnable( GL_COLOR_MATERIAL );
+
+  glLightModeli( GL_LIGHT_MODEL_COLOR_CONTROL, GL_SEPARATE_SPECULAR_COLOR );
+  
+  glEnable( GL_LIGHT0 );
+
+  // create light components
+  GLfloat ambientLight[]  =	{ 0.15f, 0.15f, 0.15f, 1.f };
+  GLfloat diffuseLight[]  =	{   .7f,   .7f,   .7f, 1.f };
+  GLfloat specularLight[] = {   .2f,   .2f,   .2f, 1.f };
+  
+  GLfloat position[] 	  = {   0.f,   0.f, -10.0f, 1.f };
+
+  // assign created components to GL_LIGHT0
+  glLightfv( GL_LIGHT0, GL_AMBIENT, ambientLight );
+  glLightfv( GL_LIGHT0, GL_DIFFUSE, diffuseLight );
+  glLightfv( GL_LIGHT0, GL_SPECULAR, specularLight );
+  glLightfv( GL_LIGHT0, GL_POSITION, position );
+}
+
+void	gl::SetupView( const GLfloat width, const GLfloat height )
+{
+  glViewport(0, 0, width, height);
+
+  glMatrixMode( GL_PROJECTION );
+  glLoadIdentity();
+  gluPerspective( 40.f, width/float(height), 0.001f, 100.f );
+  glMatrixMode( GL_MODELVIEW );
+  glLoadIdentity();
+}
+
 void	gl::DrawCoords( GLfloat size )
 { 
   //std::cerr<<"uv::gl::glDrawCoords\t|axis length "<<s<<std::endl;
@@ -124,6 +124,12 @@ namespace gl
 
   void	PrintError();
 
+  // state and lights shared by all views of the surfaces
+  void	InitializeContext();
+
+  // viewport and perspective projection of a view of width x height pixels
+  void	SetupView( const GLfloat width, const GLfloat height );
+
   // draws a coordinate system of size s x s x s 
   void	    	DrawCoords( GLfloat );		
     
@@ -18,6 +18,7 @@
 
 
 #include <cassert>
+#include <algorithm>
 #include <iostream>
 
 #include "common.h"
@@ -29,7 +30,7 @@ gtk::GLView::GLView( BaseObjectType* cobject, const Glib::RefPtr<Gtk::Builder>&
 {
   m_builder->get_widget_derived( "gl_canvas" , m_canvas );
   get_canvas()->connect_content_provider( std::bind( std::mem_fun( &GLView::gl_draw_content ), this ) );
-  m_record_frames_connection = get_canvas()->connect_pixmap_observer ( std::bind( std::mem_fun( &GLView::on_record_frame), this ) );
+  m_record_frames_connection = get_canvas()->connect_frame_observer( [this]( const size_t width, const size_t height ) { on_record_frame( width, height ); } );
   m_record_frames_connection.block();
   // get control widgets
 
@@ -61,10 +62,18 @@ void   save_pixmap( const Glib::RefPtr<Gdk::Pixmap>& pixmap, const std::string&
   pixbuf->save( filename, format );
 }
 
-void gtk::GLView::on_record_frame( /*const Glib::RefPtr<Gdk::Pixmap>& pixmap*/ )
+void gtk::GLView::on_record_frame( const size_t width, const size_t height )
 {
-  std::clog << "gtk::GLView::on_record_frame\t|" << " file " << m_record_filename() << std::endl;
-  save_pixmap( m_canvas->get_pixmap(), m_record_filename(), m_record_filename.extension );
+  m_pixel_reader.gl_read( width, height, [this]( const unsigned char* rgb, const size_t width, const size_t height ) { record_frame( rgb, width, height ); } );
+}
+
+void gtk::GLView::record_frame( const unsigned char* rgb, const size_t width, const size_t height )
+{
+  flat::FrameRecorder::frame* contents = m_recorder->acquire( width, height );
+  if( !contents ) return;
+
+  std::copy( rgb, rgb + 3 * width * height, contents->pixels.begin() );
+  m_recorder->submit( contents, m_record_filename() );
 }
 
 void gtk::GLView::on_save_frame_as_clicked()
@@ -87,17 +96,36 @@ void gtk::GLView::on_record_frames_toggled()
     fcd.add_button( Gtk::Stock::OPEN, Gtk::RESPONSE_OK );
 	if( fcd.run() == Gtk::RESPONSE_OK )
 	{
-	  m_canvas->set_render_target( GLRenderTarget::PIXMAP );
+      if( !m_recorder ) m_recorder.reset( new flat::FrameRecorder() );
       m_record_filename = Filename( fcd.get_filename(), "frame", 0, "png" );
 	  m_record_frames_connection.unblock();
+	  m_canvas->request_redraw();
 	}else m_record_frames_toggle->set_active( false );
   }else
   {
 	m_record_frames_connection.block();
-	m_canvas->set_render_target( GLRenderTarget::WINDOW );
+	// the last frames are still in the buffer objects - they are freed until the next recording
+	m_canvas->gl_invoke( [this]() 
+	{ m_pixel_reader.gl_flush( [this]( const unsigned char* rgb, const size_t width, const size_t height ) { record_frame( rgb, width, height ); } );
+	  m_pixel_reader.gl_release(); } );
+
+	std::clog << "gtk::GLView::on_record_frames_toggled\t|"
+	          << " recorded " << m_recorder->recorded() << " dropped " << m_recorder->dropped() << " frames so far" << std::endl;
   }
 }
 
+gtk::GLView::~GLView()
+{
+  gl_release_drawables();
+  m_canvas->gl_invoke( [this]() { m_pixel_reader.gl_release(); } );
+}
+
+void gtk::GLView::gl_release_drawables()
+{
+  m_canvas->gl_invoke( [this]()
+  { std::for_each( flat::View< gl::Drawable >::begin(), flat::View< gl::Drawable >::end(), []( gl::Drawable* d ) { d->gl_release(); } ); } );
+}
+
 void gtk::GLView::on_block_renderer_clicked() 
 {
   m_block_renderer = !m_block_renderer;
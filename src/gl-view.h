@@ -26,6 +26,8 @@
 # include "view.h"
 # include "gl-canvas.h"
 # include "drawable.h"
+# include "pixel-reader.h"
+# include "frame-recorder.h"
 
 # include <boost/lexical_cast.hpp>
 
@@ -88,6 +90,10 @@ namespace gtk
       
 	  boost::signals::connection m_record_frames_connection;
 	  Filename					 m_record_filename;
+
+	  // frames are read back by the gl and written on background threads
+	  gl::PixelReader			 m_pixel_reader;
+	  std::unique_ptr< flat::FrameRecorder >	m_recorder;
 	  
 	  void	on_origin_toggled();
 	  void	on_pivot_toggled();    
@@ -96,16 +102,26 @@ namespace gtk
 	  void  on_save_frame_as_clicked();
       void  on_block_renderer_clicked();
       
-	  void  on_record_frame( /*const Glib::RefPtr<Gdk::Pixmap>& pixmap*/ );
+	  void  on_record_frame( const size_t width, const size_t height );
+	  // copies a frame read back into the recorder - drops it if the recorder has no free buffer
+	  void  record_frame( const unsigned char* rgb, const size_t width, const size_t height );
 	  
 	  void  gl_draw_content()
-	  { std::for_each( flat::View< gl::Drawable >::begin(), flat::View< gl::Drawable >::end(), std::mem_fun( &gl::Drawable::gl_draw ) ); }
+	  { 
+		const bool cached = m_canvas->is_rendering_to_window();
+		std::for_each( flat::View< gl::Drawable >::begin(), flat::View< gl::Drawable >::end(), [cached]( gl::Drawable* d ) { d->gl_render( cached ); } );
+	  }
 
 	public:
 	  
 	  GLView( BaseObjectType* cobject, const Glib::RefPtr<Gtk::Builder>& builder );
 		
-	  ~GLView()	{	}
+	  // frees the gl objects of the drawables and of the frame read back
+	  ~GLView();
+
+	  // frees the gl objects of all drawables - call it before drawables are destroyed,
+	  // the ones drawn again recreate them
+	  void	gl_release_drawables();
 
 	  //void 			clear()	{ m_canvas->clear(); }
 
@@ -0,0 +1,575 @@
+/***************************************************************************
+ *            he-indexed-mesh.h
+ *
+ *  Copyright  2010  Peter Urban
+ *  <s9peurba@stud.uni-saarland.de>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+# pragma once
+
+# include "he-mesh.h"
+
+# include <vector>
+# include <boost/iterator/counting_iterator.hpp>
+# include <boost/iterator/iterator_facade.hpp>
+# include <boost/property_map/property_map.hpp>
+
+//# define DBG_HE_INDEXED_MESH_APPEND_HALF_EDGE_FACE
+
+namespace he
+{
+  namespace indexed
+  {
+    // selects the storage a property tag is looked up in
+    template< typename Tag > struct property_kind                   { typedef typename Tag::kind type; };
+    template<> struct property_kind< vertex_location_t >            { typedef vertex_location_t type; };
+    template<> struct property_kind< boost::edge_index_t >          { typedef boost::edge_index_t type; };
+
+    // lvalue property map to one tagged member of a vector of boost properties
+    template< typename PropertiesT, typename Tag >
+    class member_property_map
+    : public boost::put_get_helper< typename boost::mpl::if_< boost::is_const< PropertiesT >
+                                                            , const typename boost::property_value< typename boost::remove_const< PropertiesT >::type, Tag >::type&
+                                                            , typename boost::property_value< PropertiesT, Tag >::type& >::type
+                                  , member_property_map< PropertiesT, Tag > >
+    {
+        PropertiesT*    m_properties;
+
+      public:
+
+        typedef std::size_t                 key_type;
+        typedef typename boost::property_value< typename boost::remove_const< PropertiesT >::type, Tag >::type  value_type;
+        typedef typename boost::mpl::if_< boost::is_const< PropertiesT >, const value_type&, value_type& >::type reference;
+        typedef boost::lvalue_property_map_tag  category;
+
+        member_property_map( PropertiesT* properties )  : m_properties( properties )  {   }
+
+        reference   operator[]( const key_type& key )   const
+        { return boost::get_property_value( m_properties[ key ], Tag() ); }
+    };
+  }
+
+  // a half-edge mesh storing all primitives in flat arrays indexed by their descriptors
+  // - offers the interface of he::Mesh without the boost graph
+  // - property maps to the location and custom properties are invalidated when vertices are created
+  template< template<class> class VertexHandleT
+		  ,	template<class> class EdgeHandleT
+  		  ,	template<class> class FaceHandleT
+  		  ,	class CustomVertexProperties = boost::no_property
+  		  ,	class CustomEdgeProperties 	 = boost::no_property
+          , class CustomGraphProperties  = boost::no_property
+  		  >
+  class IndexedMesh
+  {
+	public: // type definitions
+
+      typedef IndexedMesh<VertexHandleT,EdgeHandleT,FaceHandleT,CustomVertexProperties,CustomEdgeProperties,CustomGraphProperties> type;
+
+	  typedef std::size_t 			index_t;
+
+      // marks a missing half-edge
+      static const index_t  null_index = index_t( -1 );
+
+      //----| primitive descriptors - the position in the primitive arrays
+
+	  typedef index_t   vertex_descriptor;
+	  typedef index_t   edge_descriptor;
+
+      struct impl_face_type
+	  {
+          typedef std::size_t  face_index_t;
+          edge_descriptor edge;
+		  face_index_t	  index;
+          impl_face_type() = default;
+		  impl_face_type( const edge_descriptor& e, const face_index_t& i )	: edge( e ), index( i )	{	}
+          bool    operator== ( const impl_face_type& other )    const   { return index == other.index; }
+	  };
+
+      typedef impl_face_type    face_descriptor;
+
+	  //----| preinstalled primitive properties
+	  typedef he::vertex_location_t vertex_location_t;
+
+	  // vertex properties ( default location property )
+	  typedef boost::property< vertex_location_t, location_t, CustomVertexProperties >	vertex_properties;
+	  // edge properties ( the edge index is the descriptor and not stored )
+	  typedef boost::property< boost::edge_index_t, index_t, CustomEdgeProperties > 	edge_properties;
+	  // graph properties
+      typedef CustomGraphProperties	graph_properties;
+
+      typedef std::vector<face_descriptor>  face_vector_t;
+
+      // size types
+
+   	  typedef index_t   vertices_size_type;
+   	  typedef index_t   edges_size_type;
+	  typedef size_t    faces_size_type;
+
+	  // primitive handles
+
+	  typedef VertexHandleT< type >	    vertex_handle;
+	  typedef EdgeHandleT  < type >	    edge_handle;
+	  typedef FaceHandleT  < type >	    face_handle;
+
+	  friend class VertexHandleT< type >;
+	  friend class EdgeHandleT  < type >;
+	  friend class FaceHandleT  < type >;
+
+	  // iterators
+
+      // walks the list of half-edges leaving a vertex
+      class out_edge_iterator
+      : public boost::iterator_facade< out_edge_iterator, const index_t, boost::forward_traversal_tag >
+      {
+          friend class boost::iterator_core_access;
+
+          const index_t*    m_next_out;
+          index_t           m_edge;
+
+          void  increment()     { m_edge = m_next_out[ m_edge ]; }
+
+          bool  equal( const out_edge_iterator& o ) const   { return m_edge == o.m_edge; }
+
+          const index_t&    dereference()   const   { return m_edge; }
+
+        public:
+
+          out_edge_iterator() : m_next_out( 0 ), m_edge( null_index ) {   }
+
+          out_edge_iterator( const index_t* next_out, const index_t edge ) : m_next_out( next_out ), m_edge( edge )   {   }
+      };
+
+	  typedef boost::counting_iterator< index_t >   vertex_iterator;
+	  typedef boost::counting_iterator< index_t >   edge_iterator;
+	  typedef typename face_vector_t::iterator      face_iterator;
+
+	  // iterator handles
+
+	  typedef DefaultPrimitiveIterator<type,vertex_iterator,vertex_handle>	vertex_handle_iterator;
+	  typedef DefaultPrimitiveIterator<type,edge_iterator,edge_handle>		edge_handle_iterator;
+	  typedef DefaultPrimitiveIterator<type,out_edge_iterator,edge_handle>	out_edge_handle_iterator;
+	  typedef DefaultPrimitiveIterator<type,face_iterator,face_handle>		face_handle_iterator;
+
+      // property map types for a property tag
+
+      template< typename Tag, typename Kind = typename indexed::property_kind< Tag >::type > struct property_map;
+
+      template< typename Tag > struct property_map< Tag, vertex_location_t >
+      {
+        typedef boost::iterator_property_map< location_t*, boost::identity_property_map, location_t, location_t& >  type;
+        typedef boost::iterator_property_map< const location_t*, boost::identity_property_map, location_t, const location_t& >  const_type;
+
+        static type         create( IndexedMesh& mesh )        { return type( mesh.m_locations.data() ); }
+        static const_type   create( const IndexedMesh& mesh )  { return const_type( mesh.m_locations.data() ); }
+      };
+
+      template< typename Tag > struct property_map< Tag, boost::edge_index_t >
+      {
+        typedef boost::identity_property_map    type;
+        typedef boost::identity_property_map    const_type;
+
+        static type         create( const IndexedMesh& )   { return type(); }
+      };
+
+      template< typename Tag > struct property_map< Tag, boost::vertex_property_tag >
+      {
+        typedef indexed::member_property_map< CustomVertexProperties, Tag >         type;
+        typedef indexed::member_property_map< const CustomVertexProperties, Tag >   const_type;
+
+        static type         create( IndexedMesh& mesh )        { return type( mesh.m_vertex_properties.data() ); }
+        static const_type   create( const IndexedMesh& mesh )  { return const_type( mesh.m_vertex_properties.data() ); }
+      };
+
+      template< typename Tag > struct property_map< Tag, boost::edge_property_tag >
+      {
+        typedef indexed::member_property_map< CustomEdgeProperties, Tag >         type;
+        typedef indexed::member_property_map< const CustomEdgeProperties, Tag >   const_type;
+
+        static type         create( IndexedMesh& mesh )        { return type( mesh.m_edge_properties.data() ); }
+        static const_type   create( const IndexedMesh& mesh )  { return const_type( mesh.m_edge_properties.data() ); }
+      };
+
+	protected:
+
+	  // vertex arrays
+
+	  std::vector< location_t >             m_locations;
+	  std::vector< CustomVertexProperties > m_vertex_properties;
+      // first and last half-edge leaving the vertex
+	  std::vector< index_t >                m_first_out;
+	  std::vector< index_t >                m_last_out;
+
+      // half-edge arrays
+
+	  std::vector< vertex_descriptor >      m_source;
+	  std::vector< edge_descriptor >        m_next;
+      // equal to the half-edge itself if no opposite edge exists
+	  std::vector< edge_descriptor >        m_opposite;
+	  std::vector< index_t >                m_face;
+      // next half-edge with the same source vertex
+	  std::vector< edge_descriptor >        m_next_out;
+	  std::vector< CustomEdgeProperties >   m_edge_properties;
+
+	  face_vector_t	m_face_vec;
+
+      graph_properties  m_graph_properties;
+
+      size_t        m_num_full_edges;
+
+      // changed by location writes and by modifications of the triangulation
+	  mutable size_t    m_location_generation;
+      size_t            m_topology_generation;
+
+	protected:
+
+      struct append_return_type
+	  {
+		face_descriptor	face;
+		edge_descriptor	edge_ab, edge_bc, edge_ca;
+	  };
+
+      edge_descriptor       append_half_edge( const vertex_descriptor& source, const CustomEdgeProperties& properties )
+      {
+        const edge_descriptor edge = m_source.size();
+
+        m_source.push_back( source );
+        m_next.push_back( null_index );
+        m_opposite.push_back( edge );
+        m_face.push_back( m_face_vec.size() );
+        m_next_out.push_back( null_index );
+        m_edge_properties.push_back( properties );
+        return edge;
+      }
+
+      void                  link_out_edge( const edge_descriptor& edge )
+      {
+        const vertex_descriptor source = m_source[ edge ];
+
+        if( m_last_out[ source ] == null_index )
+          m_first_out[ source ] = edge;
+        else
+          m_next_out[ m_last_out[ source ] ] = edge;
+        m_last_out[ source ] = edge;
+      }
+
+      void                  link_opposite( const edge_descriptor& edge )
+      {
+        const std::pair< edge_descriptor, bool > op = find_edge( m_source[ m_next[ edge ] ], m_source[ edge ] );
+
+        if( op.second )
+        {
+          m_opposite[ edge ] = op.first;
+          m_opposite[ op.first ] = edge;
+        }else ++m_num_full_edges;
+      }
+
+      append_return_type	append_half_edge_face( const vertex_descriptor& a, const vertex_descriptor& b, const vertex_descriptor& c,
+	  											   const edge_properties& ab_prop, const edge_properties& bc_prop, const edge_properties& ca_prop );
+
+      std::pair< edge_descriptor, bool >    find_edge( const vertex_descriptor& source, const vertex_descriptor& target ) const
+      {
+        for( edge_descriptor edge = m_first_out[ source ]; edge != null_index; edge = m_next_out[ edge ] )
+          if( m_source[ m_next[ edge ] ] == target )
+            return { edge, true };
+        return { null_index, false };
+      }
+
+	public:
+
+	  IndexedMesh( vertices_size_type vertex_count = 0
+                 , const graph_properties& properties = graph_properties() )
+	  : m_locations( vertex_count ), m_vertex_properties( vertex_count )
+      , m_first_out( vertex_count, null_index ), m_last_out( vertex_count, null_index )
+      , m_graph_properties( properties ), m_num_full_edges( 0 )
+      , m_location_generation( 0 ), m_topology_generation( 0 ) {   }
+
+	  // property map accessors
+
+	  template<typename Tag>  typename property_map<Tag>::type
+      get_property_map()
+      { return property_map<Tag>::create( *this ); }
+
+	  template<typename Tag>  typename property_map<Tag>::const_type
+      get_property_map()	    const
+      { return property_map<Tag>::create( *this ); }
+
+	  template<typename Tag>  typename boost::property_value< graph_properties, Tag >::type&
+      get_graph_property()
+      { return boost::get_property_value( m_graph_properties, Tag() ); }
+
+	  template<typename Tag>  const typename boost::property_value< graph_properties, Tag >::type&
+      get_graph_property()    const
+      { return boost::get_property_value( m_graph_properties, Tag() ); }
+
+      // vertex and edge descriptors are both indices - the tag selects the primitive
+	  template<typename Tag>
+	  typename boost::property_traits< typename property_map<Tag>::const_type >::value_type
+      get( const index_t& descriptor )	const
+      { return get_property_map<Tag>()[ descriptor ]; }
+
+	  template<typename Tag>
+      void	put( const index_t& descriptor
+               , const typename boost::property_traits< typename property_map<Tag>::type >::value_type& value ) const
+      { const_cast< type& >( *this ).template get_property_map<Tag>()[ descriptor ] = value; }
+
+	  // primitive access - used by the handles
+
+	  const location_t&     location( const vertex_descriptor& vertex )   const   { return m_locations[ vertex ]; }
+
+	  void                  set_location( const vertex_descriptor& vertex, const location_t& location )  const
+      { const_cast< type& >( *this ).m_locations[ vertex ] = location;
+        ++m_location_generation;
+      }
+
+	  // writes the locations of all vertices in descriptor order - counts as a single location change
+	  template< typename LocationIterator >
+	  void                  set_locations( LocationIterator locations )  const
+      { std::copy_n( locations, m_locations.size(), const_cast< type& >( *this ).m_locations.begin() );
+        ++m_location_generation;
+      }
+
+	  // generation counters - derived geometry is up to date while they are unchanged
+	  // - writes through a location property map are not counted
+	  const size_t&         location_generation()   const   { return m_location_generation; }
+	  const size_t&         topology_generation()   const   { return m_topology_generation; }
+
+	  vertex_descriptor     source( const edge_descriptor& edge ) const   { return m_source[ edge ]; }
+
+	  vertex_descriptor     target( const edge_descriptor& edge ) const   { return m_source[ m_next[ edge ] ]; }
+
+	  edge_descriptor       next( const edge_descriptor& edge )   const   { return m_next[ edge ]; }
+
+	  edge_descriptor       opposite( const edge_descriptor& edge )   const   { return m_opposite[ edge ]; }
+
+	  const face_descriptor&    face( const edge_descriptor& edge )   const   { return m_face_vec[ m_face[ edge ] ]; }
+
+	  index_t               index( const edge_descriptor& edge )  const   { return edge; }
+
+	  std::pair< out_edge_iterator, out_edge_iterator >
+        out_edges( const vertex_descriptor& vertex )  const
+      { return { out_edge_iterator( m_next_out.data(), m_first_out[ vertex ] ), out_edge_iterator( m_next_out.data(), null_index ) }; }
+
+	  // query number of primitives
+
+	  const vertices_size_type	num_vertices()	const	{ return m_locations.size(); }
+
+	  const edges_size_type		num_edges()		const	{ return m_source.size(); }
+
+	  const edges_size_type&	num_full_edges()const	{ return m_num_full_edges; }
+
+	  const faces_size_type		num_faces()		const	{ return m_face_vec.size(); }
+
+	  // iterator interface
+
+	  std::pair< vertex_handle_iterator, vertex_handle_iterator >
+		vertex_handles()    const
+      { return vertex_handle_iterator::create_range( std::make_pair( vertex_iterator( 0 ), vertex_iterator( num_vertices() ) ), *this ); }
+
+	  std::pair< edge_handle_iterator, edge_handle_iterator >
+		edge_handles()	    const
+      { return edge_handle_iterator::create_range( std::make_pair( edge_iterator( 0 ), edge_iterator( num_edges() ) ), *this ); }
+
+	  std::pair< out_edge_handle_iterator, out_edge_handle_iterator >
+		out_edge_handles( const vertex_descriptor& vertex )	const
+	  { return out_edge_handle_iterator::create_range( out_edges( vertex ), *this ); }
+
+	  std::pair< face_handle_iterator, face_handle_iterator >
+		face_handles()	const
+      { auto it_pair = std::make_pair( const_cast< face_vector_t* >( &m_face_vec )->begin()
+                                     , const_cast< face_vector_t* >( &m_face_vec )->end()
+                                     );
+        return face_handle_iterator::create_range( it_pair, *this );
+      }
+
+	  // mesh modification
+
+	  void	clear()
+      {
+        m_locations.clear();
+        m_vertex_properties.clear();
+        m_first_out.clear();
+        m_last_out.clear();
+        clear_edges();
+	  }
+
+	  void	clear_edges()
+      {
+        m_source.clear();
+        m_next.clear();
+        m_opposite.clear();
+        m_face.clear();
+        m_next_out.clear();
+        m_edge_properties.clear();
+	    m_face_vec.clear();
+        std::fill( m_first_out.begin(), m_first_out.end(), null_index );
+        std::fill( m_last_out.begin(), m_last_out.end(), null_index );
+        m_num_full_edges = 0;
+        ++m_topology_generation;
+	  }
+
+	  vertex_handle	    create_vertex( const typename type::vertex_properties& p = typename type::vertex_properties() )
+	  {
+        m_locations.push_back( p.m_value );
+        m_vertex_properties.push_back( p.m_base );
+        m_first_out.push_back( null_index );
+        m_last_out.push_back( null_index );
+        ++m_topology_generation;
+
+        const vertex_handle nv( m_locations.size() - 1, *this );
+
+		# if defined DBG_HE_MESH_CREATE_VERTEX
+        std::clog << "he::IndexedMesh::create_vertex\t|"
+                  <<" descriptor #" << nv.descriptor()
+                  <<" location " << nv.location() << std::endl;
+		# endif
+
+        return nv;
+      }
+
+      struct create_face_return_type
+	  { face_handle	face;
+		edge_handle edge_ab, edge_bc, edge_ca;
+	  };
+
+	  create_face_return_type		create_face( const vertex_descriptor& a,
+			  							         const vertex_descriptor& b,
+			  								     const vertex_descriptor& c,
+			  								     const typename type::edge_properties& ab_prop = typename type::edge_properties(),
+			  								     const typename type::edge_properties& bc_prop = typename type::edge_properties(),
+			  								     const typename type::edge_properties& ca_prop = typename type::edge_properties() )
+	  {
+        append_return_type added = append_half_edge_face(a,b,c,ab_prop,bc_prop,ca_prop);
+
+        return { face_handle( added.face   , *this)
+		  	   , edge_handle( added.edge_ab, *this)
+			   , edge_handle( added.edge_bc, *this)
+			   , edge_handle( added.edge_ca, *this)
+	  		   };
+	  }
+
+	  // creates the faces of an indexed triangle list ( three vertex descriptors per face )
+	  // - opposite edges are resolved in one pass instead of a search per half-edge
+	  // - the mesh must not have faces yet
+	  void  create_faces( const std::vector< vertex_descriptor >& triangles );
+
+	  vertex_handle     vertex(const vertex_descriptor& d)	const	{ return vertex_handle(d,*this); }
+
+	  std::pair<edge_handle,bool>	edge( const vertex_descriptor& source, const vertex_descriptor& target ) const
+      {
+        const std::pair< edge_descriptor, bool > edge = find_edge( source, target );
+
+        return { edge_handle( edge.first, *this ), edge.second };
+	  }
+  }; //IndexedMesh
+
+}//he
+
+//------------------------------------------------------------------------------
+// IMPLEMENTATION ==============================================================
+
+template< template<class> class V, template<class> class E, template<class> class F, class VProp, class EProp, class GProp	>
+const typename he::IndexedMesh<V,E,F,VProp,EProp,GProp>::index_t  he::IndexedMesh<V,E,F,VProp,EProp,GProp>::null_index;
+
+template< template<class> class V, template<class> class E, template<class> class F, class VProp, class EProp, class GProp	>
+typename he::IndexedMesh<V,E,F,VProp,EProp,GProp>::append_return_type
+  he::IndexedMesh<V,E,F,VProp,EProp,GProp>::append_half_edge_face( const vertex_descriptor& a, const vertex_descriptor& b, const vertex_descriptor& c
+	  		 											         , const edge_properties& ab_prop, const edge_properties& bc_prop, const edge_properties& ca_prop )
+{
+  // add half edges surrounding the face
+  const edge_descriptor ab = append_half_edge( a, ab_prop.m_base );
+  const edge_descriptor bc = append_half_edge( b, bc_prop.m_base );
+  const edge_descriptor ca = append_half_edge( c, ca_prop.m_base );
+
+  m_next[ ab ] = bc;
+  m_next[ bc ] = ca;
+  m_next[ ca ] = ab;
+
+  // create the face object
+  const face_descriptor	f( ab, m_face_vec.size() );
+  m_face_vec.push_back( f );
+
+  // connect to opposite edges before the new edges are reachable from their source
+  link_opposite( ab );
+  link_opposite( bc );
+  link_opposite( ca );
+
+  link_out_edge( ab );
+  link_out_edge( bc );
+  link_out_edge( ca );
+  ++m_topology_generation;
+
+  # if defined DBG_HE_INDEXED_MESH_APPEND_HALF_EDGE_FACE
+
+  std::clog << "he::IndexedMesh::append_half_edge_face\t| a-b " << edge_handle( ab, *this ) << std::endl;
+  std::clog << "he::IndexedMesh::append_half_edge_face\t| b-c " << edge_handle( bc, *this ) << std::endl;
+  std::clog << "he::IndexedMesh::append_half_edge_face\t| c-a " << edge_handle( ca, *this ) << std::endl;
+
+  # endif
+
+  return { f, ab, bc, ca };
+}
+
+template< template<class> class V, template<class> class E, template<class> class F, class VProp, class EProp, class GProp	>
+void	he::IndexedMesh<V,E,F,VProp,EProp,GProp>::create_faces( const std::vector< vertex_descriptor >& triangles )
+{
+  assert( triangles.size() % 3 == 0 );
+  assert( !num_edges() );
+
+  const edge_descriptor first_edge = num_edges();
+  const EProp properties = EProp();
+
+  m_source.reserve( first_edge + triangles.size() );
+  m_next.reserve( first_edge + triangles.size() );
+  m_opposite.reserve( first_edge + triangles.size() );
+  m_face.reserve( first_edge + triangles.size() );
+  m_next_out.reserve( first_edge + triangles.size() );
+  m_edge_properties.reserve( first_edge + triangles.size() );
+  m_face_vec.reserve( m_face_vec.size() + triangles.size() / 3 );
+
+  for( auto vertex = triangles.begin(); vertex != triangles.end(); vertex += 3 )
+  {
+    const edge_descriptor ab = append_half_edge( vertex[0], properties );
+    const edge_descriptor bc = append_half_edge( vertex[1], properties );
+    const edge_descriptor ca = append_half_edge( vertex[2], properties );
+
+    m_next[ ab ] = bc;
+    m_next[ bc ] = ca;
+    m_next[ ca ] = ab;
+
+    m_face_vec.push_back( face_descriptor( ab, m_face_vec.size() ) );
+  }
+
+  // the half-edges are stored in triangle order - their endpoints follow from the triangle list
+  std::vector< size_t > opposite_index;
+  const size_t pairs = find_opposite_edges( triangles.size(), num_vertices()
+                                          , [&triangles]( const size_t i ) 
+                                            { return std::make_pair( triangles[i], triangles[ i - i % 3 + ( i + 1 ) % 3 ] ); }
+                                          , opposite_index );
+
+  for( size_t i = 0; i < opposite_index.size(); ++i )
+    m_opposite[ first_edge + i ] = first_edge + opposite_index[i];
+
+  m_num_full_edges += triangles.size() - pairs;
+
+  for( edge_descriptor edge = first_edge; edge != num_edges(); ++edge )
+    link_out_edge( edge );
+  ++m_topology_generation;
+
+  UTK_LOG( DEBUG, "he::IndexedMesh::create_faces\t| " << triangles.size() / 3 << " faces - " << pairs << " opposite pairs" );
+}
@@ -30,7 +30,10 @@
 # include <boost/graph/graph_traits.hpp>
 # include <boost/graph/adjacency_list.hpp>
 
+# include <numeric>
+
 # include "utk/ray.h"
+# include "utk/log.h"
 
 //# define DBG_HE_MESH_APPEND_HALF_EDGE_FACE
 
@@ -41,6 +44,68 @@ namespace he
   using flat::angle_t;
   using flat::area_t;
   using flat::distance_t;
+
+  //----| preinstalled primitive properties - shared by all mesh backends
+  struct vertex_location_t  { typedef boost::vertex_property_tag kind; };
+  struct edge_hds_t 		{ typedef boost::edge_property_tag kind; };
+
+  // finds the opposite pairs among a number of half-edges in linear time
+  // - endpoints( i ) returns the source and target vertex of the i-th half-edge
+  // - the edges are radix sorted by their vertex pair, so opposite edges end up next to each other
+  // - opposite[i] is set to the index of the opposite half-edge or to i, the number of pairs is returned
+  template< typename EndpointsF >
+  size_t  find_opposite_edges( const size_t num_edges, const size_t num_vertices, EndpointsF endpoints, std::vector< size_t >& opposite )
+  {
+    std::vector< size_t > low( num_edges ), high( num_edges );
+
+    for( size_t i = 0; i < num_edges; ++i )
+    { const auto ends = endpoints( i );
+      low[i]  = std::min( ends.first, ends.second );
+      high[i] = std::max( ends.first, ends.second );
+    }
+
+    // stable counting sort of the edge indices in input by the given vertex key
+    auto sort_by = [num_vertices]( const std::vector< size_t >& key, const std::vector< size_t >& input, std::vector< size_t >& output )
+    {
+      std::vector< size_t > position( num_vertices + 1, 0 );
+
+      for( size_t i = 0; i < input.size(); ++i )
+        ++position[ key[ input[i] ] + 1 ];
+      std::partial_sum( position.begin(), position.end(), position.begin() );
+
+      for( size_t i = 0; i < input.size(); ++i )
+        output[ position[ key[ input[i] ] ]++ ] = input[i];
+    };
+
+    std::vector< size_t > order( num_edges ), sorted( num_edges );
+
+    for( size_t i = 0; i < num_edges; ++i )
+      order[i] = i;
+    sort_by( high, order, sorted );
+    sort_by( low, sorted, order );
+
+    opposite.resize( num_edges );
+    for( size_t i = 0; i < num_edges; ++i )
+      opposite[i] = i;
+
+    size_t pairs = 0;
+
+    // runs of edges between the same vertices - earlier edges are paired first
+    for( size_t begin = 0, end = 0; begin < num_edges; begin = end )
+    {
+      while( end < num_edges && low[ order[end] ] == low[ order[begin] ] && high[ order[end] ] == high[ order[begin] ] ) ++end;
+
+      for( size_t i = begin; i < end; ++i )
+        for( size_t j = i + 1; j < end && opposite[ order[i] ] == order[i]; ++j )
+          if( opposite[ order[j] ] == order[j] && endpoints( order[i] ).first != endpoints( order[j] ).first )
+          {
+            opposite[ order[i] ] = order[j];
+            opposite[ order[j] ] = order[i];
+            ++pairs;
+          }
+    }
+    return pairs;
+  }
   
   // primitive iterator handles
 
@@ -148,8 +213,8 @@ namespace he
       typedef impl_face_type    face_descriptor;
 	  
 	  //----| preinstalled primitive properties
-	  struct vertex_location_t  { typedef boost::vertex_property_tag kind; };
-	  struct edge_hds_t 		{ typedef boost::edge_property_tag kind; };
+	  typedef he::vertex_location_t vertex_location_t;
+	  typedef he::edge_hds_t        edge_hds_t;
 
 	  struct HDS // the half edge data structure
 	  {	vertex_descriptor	source_vertex;
@@ -177,6 +242,12 @@ namespace he
       // face storage type - later accessed from half-edge datastructure
       typedef std::vector<face_descriptor>  face_vector_t;
 
+      // property map types for a property tag
+      template< typename Tag > struct property_map
+      { typedef typename boost::property_map< graph_t, Tag >::type        type;
+        typedef typename boost::property_map< graph_t, Tag >::const_type  const_type;
+      };
+
       // size types
 
    	  typedef typename boost::graph_traits<graph_t>::vertices_size_type vertices_size_type;
@@ -217,6 +288,10 @@ namespace he
 	  size_t		m_num_half_edges;
       size_t        m_num_full_edges;
 
+      // changed by location writes and by modifications of the triangulation
+	  mutable size_t    m_location_generation;
+      size_t            m_topology_generation;
+
 	protected:
 
       struct append_return_type
@@ -233,9 +308,10 @@ namespace he
 	  Mesh() = default;
 	  
 	  Mesh( vertices_size_type vertex_count = 0
-          , const graph_properties& graph_properties = graph_properties() )
-	  : m_graph( vertex_count, graph_properties )
-      , m_face_vec(), m_num_half_edges( 0 ), m_num_full_edges( 0 ) {   }
+          , const graph_properties& properties = graph_properties() )
+	  : m_graph( vertex_count, properties )
+      , m_face_vec(), m_num_half_edges( 0 ), m_num_full_edges( 0 )
+      , m_location_generation( 0 ), m_topology_generation( 0 ) {   }
 
 
       graph_t&           get_graph()       { return m_graph; }
@@ -289,6 +365,48 @@ namespace he
                , const typename boost::property_traits< typename boost::property_map<graph_t,Tag>::type >::value_type& value ) const
       { boost::put( Tag(), m_graph, edge, value ); }
 
+	  // primitive access - used by the handles
+
+	  const HDS&            hds( const edge_descriptor& edge )    const
+      { return get_property_map< edge_hds_t >()[ edge ]; }
+
+	  const location_t&     location( const vertex_descriptor& vertex )   const
+      { return get_property_map< vertex_location_t >()[ vertex ]; }
+
+	  void                  set_location( const vertex_descriptor& vertex, const location_t& location )  const
+      { put< vertex_location_t >( vertex, location );
+        ++m_location_generation;
+      }
+
+	  // writes the locations of all vertices in descriptor order - counts as a single location change
+	  template< typename LocationIterator >
+	  void                  set_locations( LocationIterator locations )  const
+      { for( vertex_descriptor vertex = 0; vertex < num_vertices(); ++vertex, ++locations )
+          put< vertex_location_t >( vertex, *locations );
+        ++m_location_generation;
+      }
+
+	  // generation counters - derived geometry is up to date while they are unchanged
+	  // - writes through a location property map are not counted
+	  const size_t&         location_generation()   const   { return m_location_generation; }
+	  const size_t&         topology_generation()   const   { return m_topology_generation; }
+
+	  vertex_descriptor     source( const edge_descriptor& edge ) const   { return hds( edge ).source_vertex; }
+
+	  vertex_descriptor     target( const edge_descriptor& edge ) const   { return boost::target( edge, m_graph ); }
+
+	  edge_descriptor       next( const edge_descriptor& edge )   const   { return hds( edge ).next_edge; }
+
+	  edge_descriptor       opposite( const edge_descriptor& edge )   const   { return hds( edge ).opposite_edge; }
+
+	  const face_descriptor&    face( const edge_descriptor& edge )   const   { return hds( edge ).face; }
+
+	  index_t               index( const edge_descriptor& edge )  const   { return get< boost::edge_index_t >( edge ); }
+
+	  std::pair< out_edge_iterator, out_edge_iterator >
+        out_edges( const vertex_descriptor& vertex )  const
+      { return boost::out_edges( vertex, m_graph ); }
+
 	  // query number of primitives
 
 	  const vertices_size_type	num_vertices()	const	{ return boost::num_vertices(m_graph); }
@@ -327,17 +445,20 @@ namespace he
 	  void	clear()										
       { m_graph.clear();
 	    m_face_vec.clear();
+        ++m_topology_generation;
 	  }
 
 	  void	clear_edges()										
       {
         boost::remove_edge_if( [] ( const edge_descriptor& ) { return true; }, m_graph );
 	    m_face_vec.clear();
+        ++m_topology_generation;
 	  } 
       
 	  vertex_handle	    create_vertex( const typename type::vertex_properties& p = typename type::vertex_properties() )
 	  { 
         const vertex_handle nv( boost::add_vertex( p , type::m_graph ), *this );
+        ++m_topology_generation;
 
 		# if defined DBG_HE_MESH_CREATE_VERTEX
         std::clog << "he::Mesh::create_vertex\t|"
@@ -369,6 +490,11 @@ namespace he
 	  		   };
 	  }
 
+	  // creates the faces of an indexed triangle list ( three vertex descriptors per face )
+	  // - opposite edges are resolved in one pass instead of a search per half-edge
+	  // - the mesh must not have faces yet
+	  void  create_faces( const std::vector< vertex_descriptor >& triangles );
+
 	  vertex_handle     vertex(const vertex_descriptor& d)	const	{ return vertex_handle(d,*this); }
 
 	  std::pair<edge_handle,bool>	edge( const vertex_descriptor& source, const vertex_descriptor& target ) const	
@@ -411,8 +537,6 @@ namespace he
 	  PrimitiveSlot( const Descriptor& primitive_descriptor, const Storage& storage )
 	  : m_storage( storage ), m_descriptor( primitive_descriptor )	{  }
 
-  	  virtual		~PrimitiveSlot()		{	}
-
 	  operator 		 Descriptor& ()			{ return m_descriptor; }
 
 	  operator const Descriptor& ()	const	{ return m_descriptor; }
@@ -441,7 +565,7 @@ namespace he
   	  typedef typename Storage::out_edge_iterator 		 out_edge_iterator;
   	  typedef typename Storage::out_edge_handle_iterator out_edge_handle_iterator;
 	  
-	  typedef typename boost::property_map<typename Storage::graph_t, typename Storage::vertex_location_t>::const_type	
+	  typedef typename Storage::template property_map< typename Storage::vertex_location_t >::const_type	
 																				const_location_map_t;
 	  
 	  typedef typename boost::property_traits< const_location_map_t >::value_type 		location_t;
@@ -456,14 +580,14 @@ namespace he
 	  {	}
 
 	  const location_t&		location()	const	
-	  { return this->mesh().template get_property_map< typename Storage::vertex_location_t >()[ this->descriptor() ]; }
+	  { return this->mesh().location( this->descriptor() ); }
       
 	  void					set_location( const location_t& location )		
-	  { this->mesh().template put< typename Storage::vertex_location_t >( this->descriptor(), location ); }
+	  { this->mesh().set_location( this->descriptor(), location ); }
 
       std::pair< out_edge_iterator, out_edge_iterator > 
 		out_edges()   const
-      { return boost::out_edges( this->descriptor(), this->mesh().get_graph() ); }
+      { return this->mesh().out_edges( this->descriptor() ); }
 
       std::pair< out_edge_handle_iterator, out_edge_handle_iterator > 
 		out_edge_handles()   const
@@ -510,16 +634,11 @@ namespace he
    	  typedef typename Storage::face_descriptor	face_descriptor;
 	  typedef typename Storage::face_handle		face_handle;
 
-	  // type of location stored in the graph
-	  typedef typename boost::property_map< typename Storage::graph_t, typename Storage::vertex_location_t >::type::value_type
+	  // type of location stored in the mesh
+	  typedef typename boost::property_traits< typename Storage::template property_map< typename Storage::vertex_location_t >::const_type >::value_type
 												location_t;
-	  // type of half edge data structure
-	  typedef typename boost::property_map< typename Storage::graph_t, typename Storage::edge_hds_t >::const_type 			
-	  											hds_map_t;
-	  typedef typename hds_map_t::value_type	hds_t;
-	  typedef typename hds_map_t::reference		hds_ref_t;
 	  // type of edge index
-	  typedef typename boost::property_traits< typename boost::property_map< typename Storage::graph_t, boost::edge_index_t >::type >::value_type
+	  typedef typename boost::property_traits< typename Storage::template property_map< boost::edge_index_t >::const_type >::value_type
 												index_t;
 
   	  friend std::ostream&	operator<<( std::ostream& os, const DefaultEdgeHandle<Storage>& eh )
@@ -533,36 +652,28 @@ namespace he
 		return os;
 	  }
 	  
-	private:
-	  
-	  // half-edge data structure
-	  hds_t	m_he;
-	  
 	public:
 		  
 	  DefaultEdgeHandle( const edge_descriptor& edge, const Storage& mesh )
-	  : PrimitiveSlot<edge_descriptor,Storage>( edge, mesh ),
-	    m_he( mesh.template get<typename Storage::edge_hds_t>( edge ) )	{ 	}
+	  : PrimitiveSlot<edge_descriptor,Storage>( edge, mesh )	{ 	}
 	  
-	  vertex_handle	source()    const	{ return vertex_handle( m_he.source_vertex, this->mesh() ); }
+	  vertex_handle	source()    const	{ return vertex_handle( this->mesh().source( this->descriptor() ), this->mesh() ); }
 
-	  vertex_handle	target()	const	{ return vertex_handle( next().source().descriptor() , this->mesh() ); }
+	  vertex_handle	target()	const	{ return vertex_handle( this->mesh().target( this->descriptor() ), this->mesh() ); }
 	  
-	  edge_handle	next()		const	{ return edge_handle( m_he.next_edge, this->mesh() ); }
+	  edge_handle	next()		const	{ return edge_handle( this->mesh().next( this->descriptor() ), this->mesh() ); }
       
   	  edge_handle	previous()	const   { return next().next(); }
 	  
 	  std::pair< edge_handle, bool >	opposite()	const   
       { 
-		edge_handle opp( m_he.opposite_edge, this->mesh() );
+		edge_handle opp( this->mesh().opposite( this->descriptor() ), this->mesh() );
 	    return { opp, this->operator!=( opp ) };  
 	  }
       
-	  face_handle   face()	const	{ return face_handle( m_he.face, this->mesh()); }
+	  face_handle   face()	const	{ return face_handle( this->mesh().face( this->descriptor() ), this->mesh()); }
       
-      index_t   	index()	const	{ return this->mesh().get< boost::edge_index_t>( this->descriptor() ); }
-
-	  hds_ref_t     hds()	const	{ return m_he; }
+      index_t   	index()	const	{ return this->mesh().index( this->descriptor() ); }
 	  
 	  location_t    vector()const	{ return target().location() - source().location(); }
 
@@ -697,7 +808,59 @@ typename he::Mesh<V,E,F,VProp,EProp,GProp>::append_return_type
   # endif
 
   m_face_vec.push_back(f);
+  ++m_topology_generation;
 
   return { f, ab.first, bc.first, ca.first };
 }
 
+template< template<class> class V, template<class> class E, template<class> class F, class VProp, class EProp, class GProp	>
+void	he::Mesh<V,E,F,VProp,EProp,GProp>::create_faces( const std::vector< vertex_descriptor >& triangles )
+{
+  assert( triangles.size() % 3 == 0 );
+  assert( !num_edges() );
+
+  auto hds_map = get_property_map< edge_hds_t >();
+
+  std::vector< edge_descriptor >  edges;
+  edges.reserve( triangles.size() );
+  m_face_vec.reserve( m_face_vec.size() + triangles.size() / 3 );
+
+  for( auto vertex = triangles.begin(); vertex != triangles.end(); vertex += 3 )
+  {
+    const vertex_descriptor& a = vertex[0];
+    const vertex_descriptor& b = vertex[1];
+    const vertex_descriptor& c = vertex[2];
+
+    const edge_descriptor ab = boost::add_edge( a, b, boost::property<edge_hds_t, HDS, edge_properties>( HDS(), edge_properties( m_num_half_edges++ ) ), m_graph ).first;
+    const edge_descriptor bc = boost::add_edge( b, c, boost::property<edge_hds_t, HDS, edge_properties>( HDS(), edge_properties( m_num_half_edges++ ) ), m_graph ).first;
+    const edge_descriptor ca = boost::add_edge( c, a, boost::property<edge_hds_t, HDS, edge_properties>( HDS(), edge_properties( m_num_half_edges++ ) ), m_graph ).first;
+
+    const face_descriptor f( ab, m_face_vec.size() );
+
+    // opposite edges are marked missing until all faces exist
+    hds_map[ab] = { a, bc, ab, f };
+    hds_map[bc] = { b, ca, bc, f };
+    hds_map[ca] = { c, ab, ca, f };
+
+    m_face_vec.push_back( f );
+
+    edges.push_back( ab );
+    edges.push_back( bc );
+    edges.push_back( ca );
+  }
+
+  // the half-edges are stored in triangle order - their endpoints follow from the triangle list
+  std::vector< size_t > opposite_index;
+  const size_t pairs = find_opposite_edges( edges.size(), num_vertices()
+                                          , [&triangles]( const size_t i ) 
+                                            { return std::make_pair( triangles[i], triangles[ i - i % 3 + ( i + 1 ) % 3 ] ); }
+                                          , opposite_index );
+
+  for( size_t i = 0; i < edges.size(); ++i )
+    hds_map[ edges[i] ].opposite_edge = edges[ opposite_index[i] ];
+
+  m_num_full_edges += edges.size() - pairs;
+  ++m_topology_generation;
+
+  UTK_LOG( DEBUG, "he::Mesh::create_faces\t| " << triangles.size() / 3 << " faces - " << pairs << " opposite pairs" );
+}
@@ -19,6 +19,7 @@
 
 #include "image-export-dialog.h"
 #include "surface.h"
+#include "texture-rasterizer.h"
 
 gtk::ImageExportDialog::ImageExportDialog(BaseObjectType* cobject, const Glib::RefPtr<Gtk::Builder>& uibuilder)
 				  : Gtk::FileChooserDialog(cobject)
@@ -44,17 +45,15 @@ void gtk::ImageExportDialog::on_response(int response_id)
   hide();
 }
 
-void gtk::ImageExportDialog::write(const std::shared_ptr<flat::PointCloud>& surface)	const
+void gtk::ImageExportDialog::write(const std::shared_ptr<flat::Surface>& surface)	const
 {
   assert( !Gtk::FileChooserDialog::get_filename().empty() );
 
-  /* TO DO : make dynamic
-  assert( dynamic_cast<QuadSurface*>( surface.get() ) );
-  std::dynamic_pointer_cast<QuadSurface>(surface)
-	->write_png_file( Gtk::FileChooserDialog::get_filename(),
-					  weighted_alignment_radiobutton->get_active(),
-					  texel_outline_checkbutton->get_active(),
-					  block_outline_checkbutton->get_active(),
-					  texel_size_spinbutton->get_value()
-					 );*/
+  flat::TextureRasterizer::options options;
+  options.weighted_alignment = get_weighted_alignment();
+  options.texel_outline      = get_texel_outline_visibility();
+  options.block_outline      = get_block_outline_visibility();
+  options.texel_size         = get_texel_size();
+
+  flat::TextureRasterizer( *surface, options ).write_png( Gtk::FileChooserDialog::get_filename() );
 }
@@ -62,12 +62,13 @@ namespace gtk
       bool	get_weighted_alignment()					const	{ return weighted_alignment_radiobutton->get_active(); }
       bool	get_regular_alignment()						const	{ return regular_alignment_radiobutton->get_active(); }
 
-      bool	get_texel_outline_visibility()				const	{ return texel_outline_checkbutton; }
-      bool	get_block_outline_visibility()				const	{ return block_outline_checkbutton; }
+      bool	get_texel_outline_visibility()				const	{ return texel_outline_checkbutton->get_active(); }
+      bool	get_block_outline_visibility()				const	{ return block_outline_checkbutton->get_active(); }
 
       float	get_texel_size()							const	{ return texel_size_spinbutton->get_value(); }
     
-	  void	write( const std::shared_ptr<flat::PointCloud>& )  	const;
+	  // draws the texture onto the flattened surface and writes it to the chosen png file
+	  void	write( const std::shared_ptr<flat::Surface>& )  	const;
   };
 }
 
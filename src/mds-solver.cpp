@@ -19,137 +19,509 @@
 
 # include "mds-solver.h"
 
-# include <boost/accumulators/accumulators.hpp>
-# include <boost/accumulators/statistics/min.hpp>
-# include <boost/accumulators/statistics/max.hpp>
+# include "utk/math.h"
+# include "utk/log.h"
+
+# include <numeric>
+# include <queue>
 
 using namespace mds;
 
+void mds::Solver::copy_locations_to_configuration()
+{
+  for( auto its = get_surface()->vertex_handles(); its.first != its.second; its.first++ )
+  { 
+    X( its.first->descriptor(), 0 ) = its.first->location()[0];
+	X( its.first->descriptor(), 1 ) = its.first->location()[1];
+  }
+}
+
+void mds::Solver::copy_configuration_to_locations()  const
+{
+  for( auto its = get_surface()->vertex_handles(); its.first != its.second; its.first++ )
+    its.first->set_location( location_t( X( its.first->descriptor(), 0 ), X( its.first->descriptor(), 1 ), 0. ) );
+}
+
+void mds::Solver::geodesic_row( const size_t source, std::vector< energy_type >& row )  const
+{
+  const std::shared_ptr< Surface >& surface = get_surface();
+  const size_t n = X.size1();
+
+  row.assign( n, std::numeric_limits< energy_type >::infinity() );
+  row[ source ] = 0;
+
+  if( surface->initial_distances.neighborhood & Surface::distance_function::ALL )
+  { 
+    for( size_t i = 0; i < n; i++ ) 
+      if( i != source ) row[i] = surface->initial_distances( source, i );
+    return;
+  }
+
+  if( m_adjacency.empty() )
+  { 
+    m_adjacency.resize( n );
+
+    const std::vector< Surface::vertex_pair > pairs( std::move( surface->neighbors() ) );
+    for( auto pair = pairs.begin(); pair != pairs.end(); ++pair )
+    { 
+      const energy_type length = ( surface->initial_distances.neighborhood & Surface::distance_function::NEIGHBORS )
+                               ? surface->initial_distances( pair->first, pair->second ) 
+                               : surface->distance( pair->first, pair->second );
+      m_adjacency[ pair->first  ].push_back( { pair->second, length } );
+      m_adjacency[ pair->second ].push_back( { pair->first,  length } );
+    }
+  }
+
+  // dijkstra
+  typedef std::pair< energy_type, size_t > entry;
+  std::priority_queue< entry, std::vector< entry >, std::greater< entry > > queue;
+  queue.push( { 0., source } );
+  
+  while( !queue.empty() )
+  { 
+    const entry top = queue.top();
+    queue.pop();
+    if( top.first > row[ top.second ] ) continue;
+    
+    for( auto it = m_adjacency[ top.second ].begin(); it != m_adjacency[ top.second ].end(); ++it )
+      if( top.first + it->second < row[ it->first ] )
+        queue.push( { row[ it->first ] = top.first + it->second, it->first } );
+  }
+  
+  // disconnected vertices fall back to the euclidean distance
+  for( size_t i = 0; i < n; i++ ) 
+    if( !std::isfinite( row[i] ) ) row[i] = surface->distance( source, i );
+}
+
+void mds::Solver::sample_landmarks( const size_t k
+                                  , std::vector< size_t >& landmarks
+                                  , std::vector< std::vector< energy_type > >& rows ) const
+{
+  const size_t n = X.size1();
+
+  landmarks.assign( 1, 0 );
+  rows.resize( k );
+
+  std::vector< energy_type > nearest( n, std::numeric_limits< energy_type >::infinity() );
+  
+  for( size_t l = 0; l < k; l++ )
+  {
+    geodesic_row( landmarks[l], rows[l] );
+    if( l + 1 == k ) break;
+    
+    for( size_t i = 0; i < n; i++ ) nearest[i] = std::min( nearest[i], rows[l][i] );
+    landmarks.push_back( std::max_element( nearest.begin(), nearest.end() ) - nearest.begin() );
+  }
+}
+
+void mds::Solver::landmark_embedding()
+{
+  using boost::numeric::ublas::vector;
+  using boost::numeric::ublas::inner_prod;
+  using boost::numeric::ublas::norm_2;
+
+  const size_t n = X.size1();
+  const size_t k = std::min( std::max( get_landmarks(), size_t( 3 ) ), n );
+
+  UTK_LOG( INFO, "mds::Solver::landmark_embedding\t| " << k << " landmarks" );
+
+  std::time_t start_time = std::clock();
+
+  std::vector< size_t >                       landmarks;
+  std::vector< std::vector< energy_type > >   rows;
+  sample_landmarks( k, landmarks, rows );
+
+  // double centered squared landmark distances - B = -1/2 J D² J
+  matrix< energy_type > B( k, k );
+  vector< energy_type > mean( k );
+  mean.clear();
+
+  for( size_t i = 0; i < k; i++ )
+    for( size_t j = 0; j < k; j++ )
+      mean( j ) += ( B( i, j ) = utk::sqr( .5 * ( rows[i][ landmarks[j] ] + rows[j][ landmarks[i] ] ) ) ) / k;
+
+  const energy_type total_mean = std::accumulate( mean.begin(), mean.end(), energy_type( 0 ) ) / k;
+
+  energy_type shift = 0; // gershgorin bound - makes the shifted matrix positive semidefinite
+  for( size_t i = 0; i < k; i++ )
+  { 
+    energy_type row_sum = 0;
+    for( size_t j = 0; j < k; j++ )
+      row_sum += std::fabs( B( i, j ) = -.5 * ( B( i, j ) - mean( i ) - mean( j ) + total_mean ) );
+    shift = std::max( shift, row_sum );
+  }
+
+  // two dominant eigenpairs by power iteration on B + shift I with deflation
+  std::array< vector< energy_type >, 2 > eigenvectors;
+  std::array< energy_type, 2 >           eigenvalues;
+
+  for( size_t e = 0; e < 2; e++ )
+  {
+    vector< energy_type >& v = eigenvectors[e];
+    v.resize( k );
+    for( size_t i = 0; i < k; i++ ) v( i ) = uniform_real< energy_type >() - .5;
+    v /= norm_2( v );
+
+    energy_type lambda = 0;
+    for( size_t iteration = 0; iteration < 1000; iteration++ )
+    { 
+      vector< energy_type > w( prod( B, v ) + shift * v );
+      if( e > 0 ) w -= inner_prod( eigenvectors[0], w ) * eigenvectors[0];
+      
+      lambda = norm_2( w );
+      if( lambda <= 0 ) break;
+      w /= lambda;
+
+      const energy_type change = norm_2( w - v );
+      v.swap( w );
+      if( change < 1e-10 ) break;
+    }
+    eigenvalues[e] = lambda - shift;
+  }
+  
+  // place all vertices by distance-based triangulation
+  for( size_t a = 0; a < n; a++ )
+    for( size_t e = 0; e < 2; e++ )
+    { 
+      X( a, e ) = 0;
+      if( eigenvalues[e] <= 0 ) continue;
+      
+      energy_type x = 0;
+      for( size_t l = 0; l < k; l++ )
+        x += eigenvectors[e]( l ) * ( utk::sqr( rows[l][a] ) - mean( l ) );
+      X( a, e ) = -.5 * x / std::sqrt( eigenvalues[e] );
+    }
+
+  std::time_t end_time = std::clock();
+  UTK_LOG( INFO, "mds::Solver::landmark_embedding\t| complete - eigenvalues " 
+                 << eigenvalues[0] << ", " << eigenvalues[1]
+                 << " after " << ( end_time - start_time )/double( CLOCKS_PER_SEC ) );
+}
+
 void mds::Solver::step()
 { 
-  std::clog << "flat::SimpleMDSSolver::step" << std::endl << std::flush;
+  UTK_LOG( TRACE, "mds::Solver::step" );
+
+  // X stays resident during the inner iterations - the mesh is read and written once
+  if( m_pending_initialization )
+  { 
+    landmark_embedding();
+    m_pending_initialization = false;
+  }else
+    copy_locations_to_configuration();
+
+  energy_type previous_stress = std::numeric_limits< energy_type >::infinity();
+  size_t      iteration = 0;
+
+  while( iteration++ < get_iterations() )
+  {
+    m_stress = mds_step();
+
+    // stop early if the update did not reduce the stress significantly
+    if( previous_stress - m_stress <= get_stress_tolerance() * m_stress ) break;
 
-  //TODO: allow n iterations at once - save X copies
-  mds_step();
+    previous_stress = m_stress;
+  }
   
   // copy locations back to the mesh
-  std::clog <<"flat::SimpleMDSSolver::step\t|copying locations back... " 
-  //        << std::endl << X 
-            << std::endl;
+  UTK_LOG( TRACE, "mds::Solver::step\t|copying locations back... " );
 
-  for( auto its = get_surface()->vertex_handles(); its.first != its.second; its.first++ )
-    its.first->set_location( location_t( X( its.first->descriptor(), 0 ), X( its.first->descriptor(), 1 ), 0. ) );
+  copy_configuration_to_locations();
 
-  std::clog <<"flat::MDSEqualWeightSolver::step"
-			<<"\t|complete" << std::endl << std::flush;
+  UTK_LOG( DEBUG, "mds::Solver::step"
+                  << "\t|complete - " << std::min( iteration, get_iterations() ) << " iterations"
+                  << " stress " << get_stress() );
 }
 
-void EqualWeightSolver::mds_step()
+energy_type EqualWeightSolver::mds_step()
 {
-  std::clog << "flat::MDSEqualWeightSolver::mds_step\t| computing equal-weights solution..."
-			<< std::endl;
+  UTK_LOG( TRACE, "mds::EqualWeightSolver::mds_step\t| computing equal-weights solution..." );
 
   const std::shared_ptr< Surface >& surface = get_surface();
 
+  // the configuration of the previous iteration
+  const matrix< solver_coord_t > Z( X );
+  
+  energy_type stress = 0;
+
   // set all elements X to zero
-  X = boost::numeric::ublas::scalar_matrix< coord_t >( X.size1(), X.size2(), 0. );  
+  X = boost::numeric::ublas::scalar_matrix< solver_coord_t >( X.size1(), X.size2(), 0. );  
   
   for( size_t i = 0; i < X.size1(); i++ ) 
     for( size_t j = i + 1; j < X.size1(); j++ )
 	{ 
-	  const coord_t     rd = surface->initial_distances( i, j ) / surface->distance( i, j );
-	  const location_t 	dij_rd = ( surface->vertex( i ).location() - surface->vertex( j ).location() ) * rd / X.size1() ;
+      const solver_coord_t     dx = Z( i, 0 ) - Z( j, 0 );
+      const solver_coord_t     dy = Z( i, 1 ) - Z( j, 1 );
+      const solver_distance_t  d  = std::hypot( dx, dy );
+      
+      stress += utk::sqr( d - surface->initial_distances( i, j ) );
+
+      if( d <= 0 ) continue;
+
+	  const solver_coord_t     rd = surface->initial_distances( i, j ) / d / X.size1();
 
-      X( i, 0 ) += dij_rd[ 0 ];
-	  X( i, 1 ) += dij_rd[ 1 ];
+      X( i, 0 ) += dx * rd;
+	  X( i, 1 ) += dy * rd;
       
-	  X( j, 0 ) -= dij_rd[ 0 ];
-      X( j, 1 ) -= dij_rd[ 1 ];
+	  X( j, 0 ) -= dx * rd;
+      X( j, 1 ) -= dy * rd;
 	}
   
-  std::clog << "flat::MDSEqualWeightSolver::mds_step" << "\t| complete"	<< std::endl;
+  UTK_LOG( TRACE, "mds::EqualWeightSolver::mds_step" << "\t| complete - stress " << stress );
+
+  return stress;
 }
 
-symmetric_matrix< coord_t, upper >  mds::GeneralSolver::create_V()  const
+symmetric_matrix< solver_coord_t, upper >  mds::GeneralSolver::create_V()  const
 {
-  std::clog << "flat::MDSGeneralSolver::create_V" << "\t| computing matrix V ..."//<<std::endl<<V
-			<< std::endl << std::flush;
-  symmetric_matrix< coord_t, upper > V( X.size1(), X.size1() );
+  UTK_LOG( DEBUG, "mds::GeneralSolver::create_V" << "\t| computing matrix V ..." );
+  symmetric_matrix< solver_coord_t, upper > V( boost::numeric::ublas::scalar_matrix< solver_coord_t >( X.size1(), X.size1(), 0. ) );
 
-  for( Surface::vertex_descriptor i = 0; i < X.size1(); i++ )
-  {
-    distance_t vsum = 0;
-	for( Surface::vertex_descriptor j = 0; j < X.size1(); ++j )
-      if( i != j ) vsum += V( i, j ) = - W( i, j );
-	V( i, i ) = -vsum;
-  }
-  std::clog << "flat::MDSGeneralSolver::create_V" << "\t| complete - V " << std::endl 
-            ;//<< V << std::endl;
+  for_each_pair( [ &V ]( const size_t i, const size_t j, const solver_distance_t, const weight_type w )
+                 { 
+                   V( i, j ) -= w;
+                   V( i, i ) += w;
+                   V( j, j ) += w;
+                 } );
+
+  UTK_LOG( DEBUG, "mds::GeneralSolver::create_V" << "\t| complete" );
   return V;
 }
 
+void mds::GeneralSolver::create_sparse_V()
+{
+  const size_t n = X.size1();
+
+  sparse_laplacian& V = m_laplacian;
+
+  V.row_begin.assign( n + 1, 0 );
+  V.diagonal.assign( n, 0 );
+
+  for( auto pair = m_pairs.begin(); pair != m_pairs.end(); ++pair )
+  { 
+    ++V.row_begin[ pair->first + 1 ];
+    ++V.row_begin[ pair->second + 1 ];
+  }
+
+  std::partial_sum( V.row_begin.begin(), V.row_begin.end(), V.row_begin.begin() );
+
+  V.columns.resize( V.row_begin[n] );
+  V.values.resize( V.row_begin[n] );
+
+  std::vector< size_t > fill( V.row_begin.begin(), V.row_begin.end() - 1 );
+
+  for( auto pair = m_pairs.begin(); pair != m_pairs.end(); ++pair )
+  { 
+    V.columns[ fill[ pair->first ] ] = pair->second;
+    V.values [ fill[ pair->first ]++ ] = -pair->weight;
+    V.columns[ fill[ pair->second ] ] = pair->first;
+    V.values [ fill[ pair->second ]++ ] = -pair->weight;
+
+    V.diagonal[ pair->first ]  += pair->weight;
+    V.diagonal[ pair->second ] += pair->weight;
+  }
+
+  UTK_LOG( DEBUG, "mds::GeneralSolver::create_sparse_V" << "\t| " << V.columns.size() << " off-diagonal entries" );
+}
+
+void mds::GeneralSolver::solve_sparse( const matrix< solver_coord_t >& BX )
+{
+  const size_t n = X.size1();
+  const sparse_laplacian& V = m_laplacian;
+
+  // residual reduction the iteration stops at - about the precision of the solver type
+  const energy_type tolerance = 100 * std::numeric_limits< solver_coord_t >::epsilon();
+
+  std::vector< solver_coord_t > x( n ), r( n ), z( n ), p( n ), q( n );
+
+  auto multiply = [ &V, n ]( const std::vector< solver_coord_t >& in, std::vector< solver_coord_t >& out )
+                  { 
+                    for( size_t i = 0; i < n; i++ )
+                    { 
+                      energy_type sum = V.diagonal[i] * in[i];
+                      for( size_t e = V.row_begin[i]; e < V.row_begin[ i + 1 ]; e++ )
+                        sum += V.values[e] * in[ V.columns[e] ];
+                      out[i] = sum;
+                    }
+                  };
+
+  auto precondition = [ &V, n ]( const std::vector< solver_coord_t >& in, std::vector< solver_coord_t >& out )
+                      { 
+                        for( size_t i = 0; i < n; i++ )
+                          out[i] = V.diagonal[i] > 0 ? in[i] / V.diagonal[i] : in[i];
+                      };
+
+  auto dot = [ n ]( const std::vector< solver_coord_t >& a, const std::vector< solver_coord_t >& b )
+             { 
+               energy_type sum = 0;
+               for( size_t i = 0; i < n; i++ ) sum += energy_type( a[i] ) * b[i];
+               return sum;
+             };
+
+  auto center = [ n ]( std::vector< solver_coord_t >& v )
+                { 
+                  const energy_type mean = std::accumulate( v.begin(), v.end(), energy_type( 0 ) ) / n;
+                  for( size_t i = 0; i < n; i++ ) v[i] -= mean;
+                };
+
+  size_t iterations = 0;
+
+  for( size_t k = 0; k < X.size2(); k++ )
+  { 
+    energy_type b_norm = 0;
+    for( size_t i = 0; i < n; i++ )
+    { 
+      x[i] = X( i, k );
+      b_norm += utk::sqr( energy_type( BX( i, k ) ) );
+    }
+    b_norm = std::sqrt( b_norm );
+
+    // the previous configuration is a close start
+    center( x );
+    multiply( x, q );
+    for( size_t i = 0; i < n; i++ ) r[i] = BX( i, k ) - q[i];
+
+    precondition( r, z );
+    p = z;
+    energy_type rz = dot( r, z );
+
+    for( size_t step = 0; step < n && std::sqrt( dot( r, r ) ) > tolerance * b_norm; step++, iterations++ )
+    { 
+      multiply( p, q );
+      const energy_type pq = dot( p, q );
+      if( pq <= 0 ) break;
+
+      const energy_type alpha = rz / pq;
+      for( size_t i = 0; i < n; i++ )
+      { 
+        x[i] += alpha * p[i];
+        r[i] -= alpha * q[i];
+      }
+
+      precondition( r, z );
+      const energy_type rz_next = dot( r, z );
+      const energy_type beta    = rz_next / rz;
+      rz = rz_next;
+
+      for( size_t i = 0; i < n; i++ ) p[i] = z[i] + beta * p[i];
+    }
+
+    // rounding leaves a drift along the constant vector the laplacian does not see
+    center( x );
+    for( size_t i = 0; i < n; i++ ) X( i, k ) = x[i];
+  }
+
+  UTK_LOG( TRACE, "mds::GeneralSolver::solve_sparse" << "\t| " << iterations << " conjugate gradient iterations" );
+}
+
 void mds::GeneralSolver::initialize_weights()
 {
   const std::shared_ptr< Surface >& surface = get_surface();
 
-  //W.resize( get_surface()->num_vertices(), get_surface()->num_vertices(), false );
-  W = boost::numeric::ublas::scalar_matrix< coord_t >( get_surface()->num_vertices(), get_surface()->num_vertices(), 0. );  
+  m_pairs.clear();
 
   // comment out to enable sparse sampling
   //surface->initial_distances.compute_distances( surface, Surface::distance_function::ALL );
   
-  if( surface->initial_distances.neighborhood & Surface::distance_function::ALL )
-  for(size_t i=0; i < W.size1(); i++)  
+  const bool complete = surface->initial_distances.neighborhood & Surface::distance_function::ALL;
+
+  m_all_pairs = complete && get_weighting() != BANDED && get_pivots() == 0;
+
+  if( m_all_pairs )
+  { 
+    UTK_LOG( INFO, "mds::GeneralSolver::initialize_weights\t| "
+                   << "using all-to-all pairs with weighting " << get_weighting() );
+  }else
+  if( complete && get_weighting() == BANDED )
   { 
-      std::clog << "mds::GeneralSolver::initialize_weights\t| "
-                << "using equal weights(all-to-all)"
-                << std::endl;
-    //W( i, i ) = 0;
-    for(size_t j= i + 1; j < X.size1(); j++)
-      W( i, j ) = 1.; // weight_type( X.size1() - 1 );
+    for( size_t i = 0; i < X.size1(); i++ )  
+      for( size_t j = i + 1; j < X.size1(); j++ )
+        if( weight( surface->initial_distances( i, j ) ) > 0 )
+          m_pairs.push_back( { i, j, surface->initial_distances( i, j ), weight( surface->initial_distances( i, j ) ) } );
+    
+    UTK_LOG( INFO, "mds::GeneralSolver::initialize_weights\t| "
+                   << "using " << m_pairs.size() << " pairs within band " << get_band() );
   }else
-  if( surface->initial_distances.neighborhood & Surface::distance_function::NEIGHBORS )
+  if( surface->initial_distances.neighborhood & ( Surface::distance_function::NEIGHBORS | Surface::distance_function::ALL ) )
   {
-    std::clog << "mds::GeneralSolver::initialize_weights\t| "
-              << "using direct neighborhood"
-              << std::endl;
-
     const std::vector< Surface::vertex_pair > pairs( std::move( surface->neighbors() ) );
-    const size_t n = pairs.size();
-	  
-    std::for_each( pairs.begin(), pairs.end()
-                 , [ &W, &n ]( const Surface::vertex_pair& pair )
-                   { W( pair.first, pair.second ) = weight_type(1)/n;
-                     //std::cout << "pair " << pair.first << " " << pair.second << std::endl << std::flush;
-                   }
-                 );
-    /*for(size_t i=0; i < W.size1(); i++)  
+
+    m_pairs.reserve( pairs.size() + get_pivots() * X.size1() );
+
+    for( auto pair = pairs.begin(); pair != pairs.end(); ++pair )
     { 
-      weight_type sum = 0;
-      for(size_t j= 0; j < W.size2(); j++) sum += W(i,j);
-      for(size_t j= 0; j < W.size2(); j++) W(i,j) /= sum;  
-    }*/
-  }
+      const solver_distance_t distance = surface->initial_distances( pair->first, pair->second );
+      m_pairs.push_back( { pair->first, pair->second, distance, weight( distance ) } );
+    }
 
-  std::cout << "weights " << W << std::endl;
+    // sparse long-range pairs - every vertex to each pivot
+    if( get_pivots() > 0 )
+    { 
+      std::vector< size_t >                       pivots;
+      std::vector< std::vector< energy_type > >   rows;
+      sample_landmarks( std::min( get_pivots(), X.size1() ), pivots, rows );
+
+      // neighbors of every vertex - their pairs with a pivot exist already
+      std::vector< std::vector< size_t > > neighbors( X.size1() );
+      for( auto pair = pairs.begin(); pair != pairs.end(); ++pair )
+      { 
+        neighbors[ pair->first ].push_back( pair->second );
+        neighbors[ pair->second ].push_back( pair->first );
+      }
+
+      std::vector< bool > paired( X.size1(), false );
+      std::vector< bool > neighbor( X.size1(), false );
+      for( size_t p = 0; p < pivots.size(); p++ )
+      { 
+        const std::vector< size_t >& pivot_neighbors = neighbors[ pivots[p] ];
+        for( auto it = pivot_neighbors.begin(); it != pivot_neighbors.end(); ++it ) neighbor[ *it ] = true;
+
+        paired[ pivots[p] ] = true;
+        for( size_t i = 0; i < X.size1(); i++ )
+        { 
+          // the landmark rows hold energy_type - narrow explicitly for single precision solvers
+          const solver_distance_t distance = solver_distance_t( rows[p][i] );
+          if( !paired[i] && !neighbor[i] && weight( distance ) > 0 )
+            m_pairs.push_back( { std::min( i, pivots[p] ), std::max( i, pivots[p] ), distance, weight( distance ) } );
+        }
+
+        for( auto it = pivot_neighbors.begin(); it != pivot_neighbors.end(); ++it ) neighbor[ *it ] = false;
+      }
+    }
+
+    UTK_LOG( INFO, "mds::GeneralSolver::initialize_weights\t| "
+                   << "using direct neighborhood and " << get_pivots() << " pivots - " << m_pairs.size() << " pairs" );
+  }
 }
 
 void mds::GeneralSolver::initialize_static_matrices()
 {
   initialize_weights();
 
-  const boost::numeric::ublas::scalar_matrix< coord_t > regularizer( X.size1(), X.size1(), 1. );
-
   std::time_t start_time = std::clock();
+
+  if( !m_all_pairs )
+  { 
+    create_sparse_V();
+
+    m_initialized = true;
+
+    UTK_LOG( INFO, "mds::GeneralSolver::initialize_static_matrices\t|"
+                   << " sparse laplacian completed in " << ( std::clock() - start_time )/double( CLOCKS_PER_SEC ) );
+    return;
+  }
+
+  const boost::numeric::ublas::scalar_matrix< solver_coord_t > regularizer( X.size1(), X.size1(), 1. );
+
   # if defined FLAT_MDS_GENERAL_SOLVER_USE_INVERSE
   //----|initialize moore penrose inverse of matrix V 
     
-  Vinv = pseudoinverse< coord_t >( create_V() + regularizer );
+  Vinv = pseudoinverse< solver_coord_t >( create_V() + regularizer );
   Vinv -= regularizer;
 
   # else  //----|initialize V matrix 
 
-  symmetric_matrix< coord_t, upper > V( create_V() );
+  symmetric_matrix< solver_coord_t, upper > V( create_V() );
   V += regularizer;
   //std::cout<< "V  " << V << std::endl;
   L = cholesky_decomposition( V );
@@ -157,78 +529,60 @@ void mds::GeneralSolver::initialize_static_matrices()
   //std::cout<< "LL " << prod( trans(L), L ) << std::endl;
   # endif
 
+  m_initialized = true;
+
   std::time_t end_time = std::clock();
-  std::clog << "mds::GeneralSolver::initialize_static_matrices\t"
-            << " completed in" << ( end_time - start_time )/double( CLOCKS_PER_SEC )
-            << std::endl;
+  UTK_LOG( INFO, "mds::GeneralSolver::initialize_static_matrices\t|"
+                 << " completed in " << ( end_time - start_time )/double( CLOCKS_PER_SEC ) );
 }
 
-void mds::GeneralSolver::mds_step()
+energy_type mds::GeneralSolver::mds_step()
 {
-  std::clog << "flat::MDSSolver::mds_step"
-			<< "\t|computing (general weight) solution..."
-			<< std::endl;
+  UTK_LOG( TRACE, "mds::GeneralSolver::mds_step"
+                  << "\t|computing (general weight) solution..." );
   
   using namespace boost::numeric::ublas;
 
-  using namespace boost::accumulators;
-  accumulator_set< distance_t, features< tag::min, tag::max > > disp_acc;
-	
-  // X - vertex locations
-  std::clog << "flat::MDSSolver::mds_step" << "\t| copying surface locations ..." << std::endl;
+  if( !m_initialized ) initialize_static_matrices();
 
-  std::pair< Surface::vertex_handle_iterator
-           , Surface::vertex_handle_iterator > its = get_surface()->vertex_handles();
-  
-  for( size_t i = 0; its.first != its.second; its.first++, i++ )
-  { 
-    X( i, 0 ) = its.first->location()[0];
-	X( i, 1 ) = its.first->location()[1];
-  }
-  //std::clog <<"flat::MDSSolver::step\t|X "
-  //		  <<std::endl<<X<<std::endl<<std::flush;
-  
-  // D - distance matrix
-  std::clog << "flat::MDSSolver::mds_step" << "\t| computing distance matrix D ..."	<< std::endl;
-
-symmetric_matrix< distance_t, upper > D( X.size1(), X.size1() );
-  for(size_t i = 0; i < X.size1(); i++)
-  {	D(i,i) = 0.;
-	for(size_t j = i + 1; j < X.size1(); j++)
-	  disp_acc( std::fabs( D(i,j) = get_surface()->distance(i,j) ) );
-  }
+  energy_type stress = 0;
 
-  //set_max_displacement( max( disp_acc) );
+  // BX - the B matrix ( built from the distances of the configuration X ) applied to X
+  matrix< solver_coord_t > BX( scalar_matrix< solver_coord_t >( X.size1(), X.size2(), 0. ) ); 
   
-  std::clog << "flat::MDSSolver::mds_step"
-			<< "\t| distance matrix complete "//- max displacement " << max_displacement() //<< std::endl<<D
-            << std::endl << std::flush;
+  for_each_pair( [ this, &BX, &stress ]( const size_t i, const size_t j, const solver_distance_t delta, const weight_type w )
+                 { 
+                   const solver_distance_t d = configuration_distance( i, j );
 
-  // B - Matrix 
-  symmetric_matrix<coord_t,upper> B( X.size1(), X.size1() ); 
-  for(size_t i=0; i<X.size1();i++)
-  {
-    coord_t bsum = 0.f;// vsum = 0.f;
-	for(size_t j=0; j<X.size1();j++)
-      if(i!=j)
-	  { 
-        B(i,j) = ( D(i,j)>0.f ? - W(i,j) * get_surface()->initial_distances(i,j) / D(i,j) : 0.f );
-		bsum += B(i,j);
-	  }
-	B(i,i) = -bsum;
-  }
+                   stress += w * utk::sqr( d - delta );
+
+                   if( d <= 0 ) return;
+
+                   const solver_coord_t b = w * delta / d;
+                   for( size_t k = 0; k < X.size2(); k++ )
+                   { 
+                     const solver_coord_t bx = b * ( X( i, k ) - X( j, k ) );
+                     BX( i, k ) += bx;
+                     BX( j, k ) -= bx;
+                   }
+                 } );
   
+  if( !m_all_pairs )
+  { 
+    solve_sparse( BX );
+    return stress;
+  }
+
   # if defined FLAT_MDS_GENERAL_SOLVER_USE_INVERSE
   // solve with inverse matrix
 
-  matrix<coord_t> T ( prod( B, X ) );
-  X = prod( Vinv, T );
+  X = prod( Vinv, BX );
 
   #else // solve directly
 
-  //matrix<coord_t> T(prod( B, X ));
-  //matrix<coord_t> Y( solve( L, T , lower_tag() ) );
-  X = solve( L, /*Y=*/solve( L, prod( B, X ) , lower_tag() ), lower_tag() );
+  X = solve( trans( L ), /*Y=*/solve( L, BX, lower_tag() ), upper_tag() );
   
   # endif
+
+  return stress;
 }
@@ -29,6 +29,8 @@
 # include "surface.h"
 # include "solver.h"
 
+# include <limits>
+
 
 //# define FLAT_MDS_GENERAL_SOLVER_USE_INVERSE
 
@@ -46,14 +48,47 @@ namespace mds
   using boost::numeric::ublas::upper;
   using boost::numeric::ublas::lower;
   using boost::numeric::ublas::lower_tag;
+  using boost::numeric::ublas::upper_tag;
 
   class Solver : public flat::Solver 
   {
+      // number of updates of X per call to step()
+      size_t        m_iterations;
+      // relative stress decrease below which step() stops iterating early
+      energy_type   m_stress_tolerance;
+      // stress of the configuration before the last update
+      energy_type   m_stress;
+      // number of landmarks of the initial embedding - zero starts from the surface locations
+      size_t        m_landmarks;
+      // true until the configuration has been seeded with the initial embedding
+      bool          m_pending_initialization;
+      // neighborhood graph weighted with the initial distances - built on demand by geodesic_row
+      mutable std::vector< std::vector< std::pair< size_t, energy_type > > > m_adjacency;
+
+      // seeds X with a classical mds of the landmark rows of the distance matrix
+      void  landmark_embedding();
+
+      void  copy_locations_to_configuration();
+      void  copy_configuration_to_locations()   const;
+
     protected:
      
-      matrix<coord_t> X;
+      matrix<solver_coord_t> X;
     
-	  virtual void	mds_step() = 0;
+      // updates X once and returns the stress of the configuration it started from
+	  virtual energy_type	mds_step() = 0;
+
+      solver_distance_t    configuration_distance( const size_t i, const size_t j )  const
+      { return std::hypot( X( i, 0 ) - X( j, 0 ), X( i, 1 ) - X( j, 1 ) ); }
+
+      // distances from source to all vertices - taken from the distance matrix if it is complete
+      // and approximated by shortest paths in the neighborhood graph otherwise
+      void  geodesic_row( const size_t source, std::vector< energy_type >& row )  const;
+
+      // farthest point sampling of k vertices together with their geodesic rows
+      void  sample_landmarks( const size_t k
+                            , std::vector< size_t >& landmarks
+                            , std::vector< std::vector< energy_type > >& rows ) const;
 
     public:  
       
@@ -61,6 +96,9 @@ namespace mds
       
 	  Solver( const std::shared_ptr< Surface >& surface )
 	  : flat::Solver( surface )
+      , m_iterations( 1 ), m_stress_tolerance( 0 )
+      , m_stress( std::numeric_limits< energy_type >::infinity() )
+      , m_landmarks( 0 ), m_pending_initialization( false )
       { 
         X.resize( surface->num_vertices(), 2, false ); 
       }
@@ -69,16 +107,57 @@ namespace mds
       {
         flat::Solver::set_surface( surface );
         X.resize( surface->num_vertices(), 2, false );
+        m_stress = std::numeric_limits< energy_type >::infinity();
+        m_pending_initialization = m_landmarks > 0;
+        m_adjacency.clear();
       }
       
 	  void	step();
+
+      // the configuration X row by row
+      std::vector< double >	get_state()	const	{ return std::vector< double >( X.data().begin(), X.data().end() ); }
+
+      // continues from the configuration - a pending landmark embedding is dropped
+      void  set_state( const double* state, const size_t size )
+      {
+        assert( size == X.size1() * X.size2() );
+        std::copy( state, state + size, X.data().begin() );
+        m_pending_initialization = false;
+      }
+
+      const size_t&     get_iterations()    const   { return m_iterations; }
+
+      void  set_iterations( const size_t iterations )
+      { 
+        assert( iterations > 0 );
+        m_iterations = iterations;
+      }
+
+      const energy_type&    get_stress_tolerance()  const   { return m_stress_tolerance; }
+
+      void  set_stress_tolerance( const energy_type tolerance )
+      { 
+        assert( tolerance >= 0 );
+        m_stress_tolerance = tolerance;
+      }
+
+      const energy_type&    get_stress()    const   { return m_stress; }
+
+      const size_t&     get_landmarks() const   { return m_landmarks; }
+
+      // the next step starts from a landmark mds embedding instead of the surface locations
+      void  set_landmarks( const size_t landmarks )
+      { 
+        m_landmarks = landmarks;
+        m_pending_initialization = landmarks > 0;
+      }
   };
   
   class EqualWeightSolver : public Solver
   {
     protected:
 
-      void	mds_step();
+      energy_type	mds_step();
   
     public:  
       
@@ -100,41 +179,127 @@ namespace mds
 
   class GeneralSolver : public Solver
   {
+    public:
+     
+      typedef solver_coord_t weight_type;
+
+      // EQUAL - 1, SAMMON - 1/d², BANDED - 1 for pairs closer than the band, others are dropped
+      typedef enum { EQUAL = 0, SAMMON = 1, BANDED = 2 } weighting_type;
+
     protected:
 
-      // weight matrix
-      symmetric_matrix< coord_t, upper > W;
+      struct weighted_pair
+      { 
+        size_t              first, second;
+        solver_distance_t   distance;
+        weight_type         weight;
+      };
+      
+      weighting_type    m_weighting;
+      solver_distance_t m_band;
+      // number of pivot vertices every vertex is paired with in addition to its neighbors
+      size_t            m_pivots;
+
+      // true if all pairs take part - their weights are computed on the fly
+      bool                          m_all_pairs;
+      // the weighted pairs otherwise
+      std::vector< weighted_pair >  m_pairs;
+
+      // false until initialize_static_matrices has run for the current settings
+      bool              m_initialized;
+
+      weight_type   weight( const solver_distance_t distance )  const
+      { 
+        switch( m_weighting )
+        {
+          case SAMMON:  return distance > 0 ? weight_type( 1 ) / utk::sqr( distance ) : 0;
+          case BANDED:  return distance <= m_band ? 1 : 0;
+          default:      return 1;
+        }
+      }
+
+      // calls f( i, j, distance, weight ) for every weighted pair
+      template< typename F >
+      void  for_each_pair( F f )  const
+      { 
+        const Surface::distance_function& distances = get_surface()->initial_distances;
+        if( m_all_pairs )
+        { 
+          for( size_t i = 0; i < X.size1(); i++ )
+            for( size_t j = i + 1; j < X.size1(); j++ )
+              f( i, j, distances( i, j ), weight( distances( i, j ) ) );
+        }else
+          for( auto pair = m_pairs.begin(); pair != m_pairs.end(); ++pair )
+            f( pair->first, pair->second, pair->distance, pair->weight );
+      }
+
+      symmetric_matrix< solver_coord_t, upper > create_V() const;
+
+      // the weighted laplacian V of the sparse pairs - off-diagonal entries in compressed rows
+      struct sparse_laplacian
+      {
+        std::vector< size_t >           row_begin;
+        std::vector< size_t >           columns;
+        std::vector< solver_coord_t >   values;
+        std::vector< solver_coord_t >   diagonal;
+      };
 
-      symmetric_matrix< coord_t, upper > create_V() const;
+      // used instead of L or Vinv unless all pairs take part
+      sparse_laplacian  m_laplacian;
+
+      void create_sparse_V();
+
+      // solves V X = BX by jacobi preconditioned conjugate gradients starting from the current X
+      // - the columns of BX sum to zero, so the system is consistent and X is kept centered
+      void solve_sparse( const matrix< solver_coord_t >& BX );
       
       # if defined FLAT_MDS_GENERAL_SOLVER_USE_INVERSE
-      matrix<coord_t> Vinv;      // pseudo inverse of V matrix 
+      matrix<solver_coord_t> Vinv;      // pseudo inverse of V matrix 
       # else
-      triangular_matrix< coord_t, lower > L; // cholesky decomposition of V
+      triangular_matrix< solver_coord_t, lower > L; // cholesky decomposition of V
       # endif
       
-	  void mds_step();
+	  energy_type mds_step();
 
       void initialize_weights();
       void initialize_static_matrices();
       
     public:
      
-      typedef coord_t weight_type;
-
       static std::string    class_name()    { return "MDSSolver (general weights)"; }
       
       GeneralSolver( const std::shared_ptr< Surface >& surface )
 	  : Solver( surface )
-      { 
-        initialize_static_matrices(); 
-      }
+      , m_weighting( EQUAL ), m_band( 0 ), m_pivots( 0 ), m_all_pairs( false ), m_initialized( false )
+      {   }
 
       virtual void set_surface( const std::shared_ptr< Surface >& surface )
       {
         Solver::set_surface( surface );
 
-        initialize_static_matrices();
+        m_initialized = false;
+      }
+
+      const weighting_type&     get_weighting() const   { return m_weighting; }
+      const solver_distance_t&  get_band()      const   { return m_band; }
+
+      // the weights are rebuilt before the next step
+      void  set_weighting( const weighting_type weighting, const solver_distance_t band = 0 )
+      { 
+        assert( weighting != BANDED || band > 0 );
+        m_weighting = weighting;
+        m_band = band;
+        m_initialized = false;
+      }
+
+      const size_t&     get_pivots()    const   { return m_pivots; }
+
+      // pairs every vertex with the given number of far apart pivots in addition to its neighbors
+      // - with a complete distance matrix this replaces the all-to-all pairs
+      void  set_pivots( const size_t pivots )
+      { 
+        m_pivots = pivots;
+        m_initialized = false;
       }
   };  
 }
@@ -0,0 +1,278 @@
+/***************************************************************************
+ *            mesh-geometry.h
+ *
+ *  Copyright  2011  Peter Urban
+ *  <s9peurba@stud.uni-saarland.de>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+# pragma once
+
+# include "common.h"
+
+# include "utk/parallel.h"
+
+# include <limits>
+# include <vector>
+
+namespace flat
+{
+  // per vertex and per face geometry of a triangle mesh computed in parallel over flat arrays
+  // - the results are cached until the location or topology generation of the mesh changes
+  // - the vertex part ( locations and bounding box ) is updated independently of the face part
+  template< class MeshT >
+  class MeshGeometry
+  {
+    public:
+
+      typedef MeshT                               mesh_type;
+      typedef typename MeshT::vertex_descriptor   vertex_descriptor;
+
+      typedef std::pair< location_t, location_t > bounding_box_type;
+
+    private:
+
+      const mesh_type&  m_mesh;
+
+      // the mesh generations the cached arrays belong to
+      mutable size_t    m_vertex_generation;
+      mutable size_t    m_face_generation;
+      mutable size_t    m_topology_generation;
+      mutable bool      m_valid_vertices;
+      mutable bool      m_valid_faces;
+      mutable bool      m_valid_topology;
+
+      //----| topology
+
+      // three vertices per face in face index order
+      mutable std::vector< vertex_descriptor >  m_face_vertices;
+      // corners ( 3 * face + i ) grouped by vertex
+      mutable std::vector< size_t >             m_corner_offsets;
+      mutable std::vector< size_t >             m_corners;
+      mutable std::vector< char >               m_boundary;
+
+      //----| vertex geometry
+
+      mutable std::vector< location_t > m_locations;
+      mutable bounding_box_type         m_bounding_box;
+
+      //----| face geometry
+
+      mutable std::vector< location_t > m_face_normals;
+      mutable std::vector< area_t >     m_face_areas;
+      mutable std::vector< angle_t >    m_corner_angles;
+      mutable std::vector< angle_t >    m_vertex_angles;
+      mutable std::vector< area_t >     m_vertex_areas;
+      mutable std::vector< angle_t >    m_angle_defects;
+
+      void  update_topology()   const;
+      void  update_vertices()   const;
+      void  update_faces()      const;
+
+      void  validate_topology() const
+      { if( !m_valid_topology || m_topology_generation != m_mesh.topology_generation() ) update_topology(); }
+
+      void  validate_vertices() const
+      { if( !m_valid_vertices || m_vertex_generation != m_mesh.location_generation() ) update_vertices(); }
+
+      void  validate_faces()    const
+      { validate_topology();
+        validate_vertices();
+        if( !m_valid_faces || m_face_generation != m_mesh.location_generation() ) update_faces();
+      }
+
+    public:
+
+      MeshGeometry( const mesh_type& mesh )
+      : m_mesh( mesh ), m_vertex_generation( 0 ), m_face_generation( 0 ), m_topology_generation( 0 )
+      , m_valid_vertices( false ), m_valid_faces( false ), m_valid_topology( false )   {   }
+
+      // drops all cached results - needed after writes through a location property map
+      void  invalidate()    const   { m_valid_vertices = m_valid_faces = m_valid_topology = false; }
+
+      //----| per vertex
+
+      const std::vector< location_t >&  locations()     const   { validate_vertices(); return m_locations; }
+
+      const bounding_box_type&          bounding_box()  const   { validate_vertices(); return m_bounding_box; }
+
+      // sum of the inner angles at the vertex
+      const std::vector< angle_t >&     vertex_angles() const   { validate_faces(); return m_vertex_angles; }
+
+      // area of the faces around the vertex
+      const std::vector< area_t >&      vertex_areas()  const   { validate_faces(); return m_vertex_areas; }
+
+      // 2 pi minus the vertex angle - zero at the boundary
+      const std::vector< angle_t >&     angle_defects() const   { validate_faces(); return m_angle_defects; }
+
+      bool  is_boundary( const vertex_descriptor vertex )   const   { validate_topology(); return m_boundary[ vertex ]; }
+
+      //----| per face ( in face index order )
+
+      const std::vector< vertex_descriptor >&   face_vertices() const   { validate_topology(); return m_face_vertices; }
+
+      const std::vector< location_t >&  face_normals()  const   { validate_faces(); return m_face_normals; }
+
+      const std::vector< area_t >&      face_areas()    const   { validate_faces(); return m_face_areas; }
+  };
+}
+
+//------------------------------------------------------------------------------
+// IMPLEMENTATION ==============================================================
+
+template< class MeshT >
+void  flat::MeshGeometry< MeshT >::update_topology()   const
+{
+  const size_t num_vertices = m_mesh.num_vertices();
+  const size_t num_faces    = m_mesh.num_faces();
+  const size_t num_edges    = m_mesh.num_edges();
+
+  m_face_vertices.resize( 3 * num_faces );
+
+  for( auto face = m_mesh.face_handles(); num_faces && face.first != face.second; ++face.first )
+  {
+    const size_t index = face.first->descriptor().index;
+    for( size_t i = 0; i < 3; ++i )
+      m_face_vertices[ 3 * index + i ] = face.first->vertex( i ).descriptor();
+  }
+
+  // group the corners by vertex - corners keep the face order
+  m_corner_offsets.assign( num_vertices + 1, 0 );
+
+  for( size_t corner = 0; corner < m_face_vertices.size(); ++corner )
+    ++m_corner_offsets[ m_face_vertices[ corner ] + 1 ];
+  std::partial_sum( m_corner_offsets.begin(), m_corner_offsets.end(), m_corner_offsets.begin() );
+
+  std::vector< size_t > position( m_corner_offsets.begin(), m_corner_offsets.end() - 1 );
+  m_corners.resize( m_face_vertices.size() );
+
+  for( size_t corner = 0; corner < m_face_vertices.size(); ++corner )
+    m_corners[ position[ m_face_vertices[ corner ] ]++ ] = corner;
+
+  // a vertex is on the boundary if one of its out edges has no opposite
+  m_boundary.assign( num_vertices, false );
+
+  for( auto edge = m_mesh.edge_handles(); num_edges && edge.first != edge.second; ++edge.first )
+    if( !edge.first->opposite().second )
+      m_boundary[ edge.first->source().descriptor() ] = true;
+
+  m_topology_generation = m_mesh.topology_generation();
+  m_valid_topology = true;
+  m_valid_faces = false;
+}
+
+template< class MeshT >
+void  flat::MeshGeometry< MeshT >::update_vertices()   const
+{
+  const size_t num_vertices = m_mesh.num_vertices();
+
+  m_locations.resize( num_vertices );
+
+  utk::parallel_for( 0, num_vertices, [this]( const size_t begin, const size_t end )
+  {
+    for( size_t v = begin; v < end; ++v )
+      m_locations[v] = m_mesh.location( v );
+  } );
+
+  const bounding_box_type empty( location_t(  std::numeric_limits<coord_t>::infinity() )
+                               , location_t( -std::numeric_limits<coord_t>::infinity() ) );
+
+  m_bounding_box = utk::parallel_reduce( 0, num_vertices, empty
+                                       , [this, &empty]( const size_t begin, const size_t end )
+                                         {
+                                           bounding_box_type box( empty );
+                                           for( size_t v = begin; v < end; ++v )
+                                             for( size_t i = 0; i < 3; ++i )
+                                             { box.first[i]  = std::min( box.first[i], m_locations[v][i] );
+                                               box.second[i] = std::max( box.second[i], m_locations[v][i] );
+                                             }
+                                           return box;
+                                         }
+                                       , []( const bounding_box_type& a, const bounding_box_type& b )
+                                         {
+                                           bounding_box_type box( a );
+                                           for( size_t i = 0; i < 3; ++i )
+                                           { box.first[i]  = std::min( box.first[i], b.first[i] );
+                                             box.second[i] = std::max( box.second[i], b.second[i] );
+                                           }
+                                           return box;
+                                         } );
+
+  m_vertex_generation = m_mesh.location_generation();
+  m_valid_vertices = true;
+}
+
+template< class MeshT >
+void  flat::MeshGeometry< MeshT >::update_faces()  const
+{
+  const size_t num_faces    = m_face_vertices.size() / 3;
+  const size_t num_vertices = m_locations.size();
+
+  m_face_normals.resize( num_faces );
+  m_face_areas.resize( num_faces );
+  m_corner_angles.resize( 3 * num_faces );
+
+  utk::parallel_for( 0, num_faces, [this]( const size_t begin, const size_t end )
+  {
+    for( size_t f = begin; f < end; ++f )
+    {
+      const location_t* corner[] = { &m_locations[ m_face_vertices[ 3 * f     ] ]
+                                   , &m_locations[ m_face_vertices[ 3 * f + 1 ] ]
+                                   , &m_locations[ m_face_vertices[ 3 * f + 2 ] ] };
+
+      const location_t normal = cross( *corner[1] - *corner[0], *corner[2] - *corner[1] );
+
+      m_face_areas[f]   = utk::length( normal ) / 2;
+      m_face_normals[f] = normal / utk::length( normal );
+
+      // inner angle between the two edges leaving the corner
+      for( size_t i = 0; i < 3; ++i )
+      {
+        const location_t first = *corner[ ( i + 2 ) % 3 ] - *corner[i];
+        const location_t last  = *corner[ ( i + 1 ) % 3 ] - *corner[i];
+
+        m_corner_angles[ 3 * f + i ] = std::acos( dot( first, last ) / ( utk::length( first ) * utk::length( last ) ) );
+      }
+    }
+  } );
+
+  m_vertex_angles.resize( num_vertices );
+  m_vertex_areas.resize( num_vertices );
+  m_angle_defects.resize( num_vertices );
+
+  utk::parallel_for( 0, num_vertices, [this]( const size_t begin, const size_t end )
+  {
+    for( size_t v = begin; v < end; ++v )
+    {
+      angle_t angle = 0;
+      area_t  area  = 0;
+
+      for( size_t c = m_corner_offsets[v]; c < m_corner_offsets[v + 1]; ++c )
+      { angle += m_corner_angles[ m_corners[c] ];
+        area  += m_face_areas[ m_corners[c] / 3 ];
+      }
+
+      m_vertex_angles[v] = angle;
+      m_vertex_areas[v]  = area;
+      m_angle_defects[v] = m_boundary[v] ? 0 : 2 * M_PI - angle;
+    }
+  } );
+
+  m_face_generation = m_mesh.location_generation();
+  m_valid_faces = true;
+}
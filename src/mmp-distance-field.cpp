@@ -0,0 +1,294 @@
+//           mmp-distance-field.cpp
+//  Copyright  2011  Peter Urban
+//  <s9peurba@stud.uni-saarland.de>
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+
+# include "mmp-distance-field.h"
+
+# include "png-writer.h"
+
+# include "utk/log.h"
+# include "utk/parallel.h"
+
+# include <algorithm>
+# include <chrono>
+# include <cmath>
+# include <limits>
+
+using namespace mmp;
+
+const float   DistanceField::BORDER = .75f;
+
+namespace
+{
+  // rows sampled by one thread at a time
+  const size_t  BAND_ROWS = 16;
+
+  // relative tolerance of the test whether a pseudosource sees a point through its window
+  const coord_t CONE_TOLERANCE = 1e-9;
+
+  coord_t   cross( const location2d_t& a, const location2d_t& b )
+  { return a[0] * b[1] - a[1] * b[0]; }
+}
+
+DistanceField::DistanceField( const Geodesics& geodesics, const size_t width, const size_t height )
+: m_geodesics( geodesics ), m_width( width ), m_height( height )
+, m_distances( width * height, std::numeric_limits< float >::infinity() ), m_max_distance( 0 )
+{ assert( width > 0 && height > 0 ); }
+
+void    DistanceField::collect_faces()
+{
+  using mmp::LEFT;
+  using mmp::RIGHT;
+
+  const Geodesics::surface_type& surface = m_geodesics.get_surface();
+
+  m_faces.resize( surface.num_faces() );
+  m_windows.clear();
+
+  m_bands.assign( ( m_height + BAND_ROWS - 1 ) / BAND_ROWS, std::vector< size_t >() );
+
+  for( auto face_it = surface.face_handles(); face_it.first != face_it.second; ++face_it.first )
+  {
+    const size_t index = face_it.first->descriptor().index;
+    face_record& face  = m_faces[ index ];
+
+    coord_t min_row = std::numeric_limits< coord_t >::infinity();
+    coord_t max_row = -min_row;
+
+    for( size_t i = 0; i < 3; ++i )
+    {
+      const Geodesics::surface_type::vertex_handle vertex = face_it.first->vertex( i );
+
+      face.corners[i] = vertex.location();
+      face.labels[i]  = m_geodesics.query_distance( vertex.descriptor() );
+
+      const vertex_texture_coord_t::type& texture_coordinate = vertex.texture_coordinate();
+      face.texels[i] = location2d_t( texture_coordinate[0] * m_width, texture_coordinate[1] * m_height );
+
+      min_row = std::min( min_row, face.texels[i][1] );
+      max_row = std::max( max_row, face.texels[i][1] );
+    }
+
+    // the paths of the windows on the edges of a face cross it
+    face.first_window = m_windows.size();
+
+    for( size_t i = 0; i < 3; ++i )
+    {
+      const Geodesics::edge_handle edge = face_it.first->edge( i );
+
+      window_record record;
+      record.origin = edge.source().location();
+      record.x_axis = edge.vector() / edge.length();
+
+      const location_t to_opposite = edge.next().target().location() - record.origin;
+      record.y_axis = to_opposite - record.x_axis * utk::dot( to_opposite, record.x_axis );
+      record.y_axis /= utk::length( record.y_axis );
+
+      for( auto win_it = m_geodesics.edge_windows( edge.descriptor() ); win_it.first != win_it.second; ++win_it.first )
+      {
+        const Window& window = **win_it.first;
+
+        record.pseudosource = window.pseudosource();
+        record.bounds[0]    = window.bound<  LEFT >();
+        record.bounds[1]    = window.bound< RIGHT >();
+        record.subpath      = window.subpath();
+
+        // pseudosources on the edge see no face point the vertices do not
+        if( record.pseudosource[1] > 0 ) m_windows.push_back( record );
+      }
+    }
+
+    face.end_window = m_windows.size();
+
+    // texel rows whose centers lie at most BORDER texels outside the face
+    const long first_row = std::max( 0l, long( std::floor( min_row - .5 - BORDER ) ) );
+    const long last_row  = std::min( long( m_height ) - 1, long( std::ceil( max_row - .5 + BORDER ) ) );
+
+    for( long band = first_row / long( BAND_ROWS ); band <= last_row / long( BAND_ROWS ); ++band )
+      m_bands[ band ].push_back( index );
+  }
+}
+
+distance_t  DistanceField::face_distance( const face_record& face, const location_t& point )  const
+{
+  distance_t distance = std::numeric_limits< distance_t >::infinity();
+
+  for( size_t i = 0; i < 3; ++i )
+    distance = std::min( distance, face.labels[i] + utk::length( point - face.corners[i] ) );
+
+  for( size_t w = face.first_window; w < face.end_window; ++w )
+  {
+    const window_record& window = m_windows[w];
+
+    const location_t    offset = point - window.origin;
+    const location2d_t  from_ps( utk::dot( offset, window.x_axis ) - window.pseudosource[0]
+                               , utk::dot( offset, window.y_axis ) - window.pseudosource[1] );
+
+    const location2d_t  to_left ( window.bounds[0] - window.pseudosource[0], -window.pseudosource[1] );
+    const location2d_t  to_right( window.bounds[1] - window.pseudosource[0], -window.pseudosource[1] );
+
+    // the point lies between the rays from the pseudosource through both window bounds
+    const coord_t tolerance = CONE_TOLERANCE * utk::length( from_ps ) * ( utk::length( to_left ) + utk::length( to_right ) );
+
+    if( cross( to_left, from_ps ) >= -tolerance && cross( from_ps, to_right ) >= -tolerance )
+      distance = std::min( distance, window.subpath + utk::length( from_ps ) );
+  }
+
+  return distance;
+}
+
+void    DistanceField::sample_band( const size_t band, std::vector< float >& coverage )
+{
+  const size_t first_row = band * BAND_ROWS;
+  const size_t end_row   = std::min( m_height, first_row + BAND_ROWS );
+
+  const std::vector< size_t >& faces = m_bands[ band ];
+
+  for( auto face_it = faces.begin(); face_it != faces.end(); ++face_it )
+  {
+    const face_record& face = m_faces[ *face_it ];
+
+    const location2d_t& a = face.texels[0];
+    const location2d_t  ab = face.texels[1] - a;
+    const location2d_t  ac = face.texels[2] - a;
+
+    const coord_t area = cross( ab, ac );
+    if( area == 0 ) continue;
+
+    // barycentric coordinate i times heights[i] is the distance from the edge opposite corner i in texels
+    const coord_t heights[3] = { std::fabs( area ) / utk::length( face.texels[2] - face.texels[1] )
+                               , std::fabs( area ) / utk::length( ac )
+                               , std::fabs( area ) / utk::length( ab ) };
+
+    coord_t min_column = std::numeric_limits< coord_t >::infinity(), max_column = -min_column;
+    coord_t min_row    = min_column, max_row = max_column;
+
+    for( size_t i = 0; i < 3; ++i )
+    { min_column = std::min( min_column, face.texels[i][0] ); max_column = std::max( max_column, face.texels[i][0] );
+      min_row    = std::min( min_row,    face.texels[i][1] ); max_row    = std::max( max_row,    face.texels[i][1] );
+    }
+
+    const size_t begin_column = size_t( std::max( 0l, long( std::floor( min_column - .5 - BORDER ) ) ) );
+    const size_t end_column   = size_t( std::max( 0l, std::min( long( m_width ), long( std::ceil( max_column - .5 + BORDER ) ) + 1 ) ) );
+    const size_t begin_row    = std::max( first_row, size_t( std::max( 0l, long( std::floor( min_row - .5 - BORDER ) ) ) ) );
+    const size_t end_row_face = std::min( end_row, size_t( std::max( 0l, long( std::ceil( max_row - .5 + BORDER ) ) + 1 ) ) );
+
+    for( size_t row = begin_row; row < end_row_face; ++row )
+      for( size_t column = begin_column; column < end_column; ++column )
+      {
+        const location2d_t from_a( column + .5 - a[0], row + .5 - a[1] );
+
+        coord_t barycentric[3];
+        barycentric[1] = cross( from_a, ac ) / area;
+        barycentric[2] = cross( ab, from_a ) / area;
+        barycentric[0] = 1 - barycentric[1] - barycentric[2];
+
+        const coord_t inside = std::min( barycentric[0] * heights[0], std::min( barycentric[1] * heights[1], barycentric[2] * heights[2] ) );
+
+        // a texel belongs to the face its center lies deepest in
+        const size_t texel = row * m_width + column;
+        if( inside < -BORDER || inside <= coverage[ texel ] ) continue;
+
+        coverage[ texel ] = inside;
+
+        // texels outside take the nearby face point
+        coord_t sum = 0;
+        for( size_t i = 0; i < 3; ++i ) sum += barycentric[i] = std::max( coord_t( 0 ), barycentric[i] );
+
+        const location_t point = ( face.corners[0] * barycentric[0] + face.corners[1] * barycentric[1] + face.corners[2] * barycentric[2] ) / sum;
+
+        m_distances[ texel ] = face_distance( face, point );
+      }
+  }
+}
+
+void    DistanceField::sample()
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  collect_faces();
+
+  std::fill( m_distances.begin(), m_distances.end(), std::numeric_limits< float >::infinity() );
+
+  std::vector< float > coverage( m_distances.size(), -std::numeric_limits< float >::infinity() );
+
+  utk::parallel_for( 0, m_bands.size(), [this, &coverage]( const size_t begin, const size_t end )
+  {
+    for( size_t band = begin; band < end; ++band )
+      sample_band( band, coverage );
+  }, 1 );
+
+  m_max_distance = utk::parallel_reduce( 0, m_distances.size(), distance_t( 0 ), [this]( const size_t begin, const size_t end )
+  {
+    distance_t max_distance = 0;
+    for( size_t texel = begin; texel < end; ++texel )
+      if( std::isfinite( m_distances[ texel ] ) ) max_distance = std::max< distance_t >( max_distance, m_distances[ texel ] );
+    return max_distance;
+  }, []( const distance_t a, const distance_t b ) { return std::max( a, b ); } );
+
+  UTK_LOG( INFO, "mmp::DistanceField::sample\t| " << m_width << 'x' << m_height << " texels from "
+                 << m_windows.size() << " windows in "
+                 << std::chrono::duration_cast< std::chrono::milliseconds >( std::chrono::steady_clock::now() - start ).count() << " ms" );
+}
+
+void    DistanceField::rgb( std::vector< unsigned char >& texels, const distance_t isoline_spacing )  const
+{
+  texels.resize( 3 * m_distances.size() );
+
+  const distance_t scale = m_max_distance > 0 ? 1 / m_max_distance : 0;
+
+  // a texel is on an isoline if one crosses the way to its right or upper neighbor
+  auto level = [isoline_spacing]( const float distance ) { return std::floor( distance / isoline_spacing ); };
+
+  utk::parallel_for( 0, m_height, [&]( const size_t begin, const size_t end )
+  {
+    for( size_t row = begin; row < end; ++row )
+      for( size_t column = 0; column < m_width; ++column )
+      {
+        const size_t texel = row * m_width + column;
+        const float  distance = m_distances[ texel ];
+        unsigned char* color = &texels[ 3 * texel ];
+
+        if( !std::isfinite( distance ) )
+        { color[0] = color[1] = color[2] = 0;
+          continue;
+        }
+
+        if( isoline_spacing > 0 )
+        {
+          const bool isoline = ( column + 1 < m_width  && std::isfinite( m_distances[ texel + 1 ] )       && level( m_distances[ texel + 1 ] ) != level( distance ) )
+                            || ( row + 1    < m_height && std::isfinite( m_distances[ texel + m_width ] ) && level( m_distances[ texel + m_width ] ) != level( distance ) );
+          if( isoline )
+          { color[0] = 255; color[1] = 204; color[2] = 0;
+            continue;
+          }
+        }
+
+        color[0] = color[1] = color[2] = (unsigned char)( 38 + 217 * std::min< distance_t >( 1, distance * scale ) );
+      }
+  }, 64 );
+}
+
+void    DistanceField::write_png( const std::string& path, const distance_t isoline_spacing )  const
+{
+  std::vector< unsigned char > texels;
+  rgb( texels, isoline_spacing );
+
+  UTK_LOG( INFO, "mmp::DistanceField::write_png\t| file \"" << path << "\" size " << m_width << 'x' << m_height );
+
+  flat::write_png( path, m_width, m_height, texels.data(), true );
+}
@@ -0,0 +1,114 @@
+/***************************************************************************
+ *            mmp-distance-field.h
+ *
+ *  Copyright  2011  Peter Urban
+ *  <s9peurba@stud.uni-saarland.de>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+# pragma once
+
+# include "mmp-geodesics.h"
+
+# include <string>
+# include <vector>
+
+namespace mmp
+{
+  // geodesic distances of a propagation sampled over the texture coordinates of its surface
+  // - a texel takes the distance of the face point at its center, the shortest path through the
+  //   windows on the face edges whose pseudosource sees the point, or straight from a face vertex
+  // - texels up to BORDER texels outside a face take the distance of the nearest face point,
+  //   so filtering does not blend in the empty texels between the faces
+  // - texels of no face and points the propagation has not reached yet are infinite
+  // - the rows are sampled on concurrent threads
+  class DistanceField
+  {
+    public:
+
+      // texels outside a face that still belong to it
+      static const float    BORDER;
+
+    private:
+
+      // a window seen from the face its paths cross - coordinates along and across its edge
+      struct window_record
+      {
+        location_t  origin;
+        location_t  x_axis;
+        location_t  y_axis;
+        ps_t        pseudosource;
+        coord_t     bounds[2];
+        distance_t  subpath;
+      };
+
+      struct face_record
+      {
+        location_t      corners[3];
+        distance_t      labels[3];
+        location2d_t    texels[3];
+        // windows [ first_window, end_window ) of m_windows
+        size_t          first_window;
+        size_t          end_window;
+      };
+
+      const Geodesics&  m_geodesics;
+
+      size_t    m_width;
+      size_t    m_height;
+
+      std::vector< face_record >    m_faces;
+      std::vector< window_record >  m_windows;
+
+      // faces overlapping each band of rows
+      std::vector< std::vector< size_t > >  m_bands;
+
+      std::vector< float >  m_distances;
+      distance_t            m_max_distance;
+
+      void          collect_faces();
+
+      void          sample_band( const size_t band, std::vector< float >& coverage );
+
+      distance_t    face_distance( const face_record& face, const location_t& point )   const;
+
+    public:
+
+      DistanceField( const Geodesics& geodesics, const size_t width, const size_t height );
+
+      size_t        width()         const   { return m_width; }
+      size_t        height()        const   { return m_height; }
+
+      // samples the windows of the propagation as they are now
+      void          sample();
+
+      // distances row by row, the first row at texture coordinate t = 0
+      const std::vector< float >&   distances()     const   { return m_distances; }
+
+      // largest finite distance of the latest sample
+      distance_t    max_distance()  const   { return m_max_distance; }
+
+      // 8 bit rgb texels in the row order of distances - grey from dark at the source to white at the
+      // largest distance, black outside the faces, with a line every isoline_spacing unless it is zero
+      void          rgb( std::vector< unsigned char >& texels, const distance_t isoline_spacing )  const;
+
+      // writes the rgb texels top row first, so texture coordinate t points up like in the gl view
+      // - throws std::runtime_error if the file can not be written
+      void          write_png( const std::string& path, const distance_t isoline_spacing )  const;
+  };
+}
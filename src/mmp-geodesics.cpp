@@ -22,6 +22,8 @@
 # include "mmp-utilities.h"
 # include "mmp-trim_ac.h"
 
+# include "utk/log.h"
+
 # include <boost/lexical_cast.hpp>
 # include <boost/accumulators/accumulators.hpp>
 # include <boost/accumulators/statistics/min.hpp>
@@ -37,11 +39,10 @@ using namespace mmp;
 //initialize with subgraph???
 Geodesics::Geodesics( surface_type& surface, const vertex_descriptor source )
 : surf(surface), m_source(source), windows( surface.get_property_map<boost::edge_index_t>() )
-, vertex_labels( surface.num_vertices() ), event_queue(), m_max_distance( 0 )
+, vertex_labels( surface.num_vertices() ), event_queue(), m_max_distance( 0 ), m_num_steps( 0 )
 { 
-  std::clog << "mmp::Geodesics::Geodesics\t\t|"
-            << "source " << source
-            << std::endl;
+  UTK_LOG( DEBUG, "mmp::Geodesics::Geodesics\t\t|"
+                  << "source " << source );
 
   assert( surface.has_triangulation() );
 
@@ -356,9 +357,8 @@ void	Geodesics::propagate_paths()
 {
   using utk::sqr;
 
-  std::clog << "mmp::Geodesics::propagate_paths"
-            << "\t|source " << source()
-            << std::endl;
+  UTK_LOG( DEBUG, "mmp::Geodesics::propagate_paths"
+                  << "\t|source " << source() );
 
   initialize();
 
@@ -374,10 +374,9 @@ void	Geodesics::propagate_paths()
   # if defined DBG_FLAT_MMP_FORCE_SANITY_CHECK
   assert( sanity_check() );
   # endif
-  std::clog << "mmp::Geodesics::propagate_paths\t|" 
-			<< "complete - source " << source()
-            << " with " << mmp::Window::next_id << " windows created in total"
-            << std::endl;
+  UTK_LOG( DEBUG, "mmp::Geodesics::propagate_paths\t|" 
+			      << "complete - source " << source()
+                  << " with " << mmp::Window::next_id << " windows created in total" );
 }
 
 
@@ -843,19 +842,21 @@ distance_t	Geodesics::query_minimal_distance(const edge_descriptor& targetedge)
 // check if all edges are fully and consistently covered
 bool  Geodesics::sanity_check()  const
 {
-  std::clog << "mmp::Geodesics::sanity_check\t| "
-			<< get_surface().num_edges() << " edges"  
-	        << std::endl;
+  UTK_LOG( DEBUG, "mmp::Geodesics::sanity_check\t| "
+                  << get_surface().num_edges() << " edges" );
 
   bool ok = true;
 
   const std::string dbg_prefix = boost::lexical_cast< std::string >( source() ) + "_insane";
+
+  // windows rooted at the source have no predecessor
+  auto predeccessor_string = []( const Window& window )
+  { return window.predeccessor() ? boost::lexical_cast< std::string >( *window.predeccessor() ) : std::string( "none" ); };
   
   if( !event_queue.empty() )
   { 
-	std::clog << "mmp::Geodesics::sanity_check\t|"
-              << "FAILED - there are unpropagated windows in the queue"
-              << std::endl;
+	UTK_LOG( ERROR, "mmp::Geodesics::sanity_check\t|"
+                    << "FAILED - there are unpropagated windows in the queue" );
     ok = false;
   }
   
@@ -866,26 +867,23 @@ bool  Geodesics::sanity_check()  const
     const std::pair< edge_handle, bool > eop = eits.first->opposite();
 
     const edge_handle& eh( *eits.first );
-    std::clog << "mmp::Geodesics::sanity_check\t|"
-              << "?checking " << *eits.first << " with " << wlist.size() << " windows"
-              << std::endl;
+    UTK_LOG( TRACE, "mmp::Geodesics::sanity_check\t|"
+                    << "?checking " << *eits.first << " with " << wlist.size() << " windows" );
     
     if( wlist.empty() )
     { 
       if( eh.next().opposite().second || eh.previous().opposite().second )
       { 
-        std::clog << "mmp::Geodesics::sanity_check\t|";
         if( eop.second && !windows[eop.first].empty() )
-		{ std::clog << "WARNING - uncovered ( with opposite )" << std::endl; }
+		{ UTK_LOG( WARNING, "mmp::Geodesics::sanity_check\t|" << "WARNING - uncovered ( with opposite )" ); }
         else
-        { std::clog << "FAILED - uncovered" << std::endl;
+        { UTK_LOG( ERROR, "mmp::Geodesics::sanity_check\t|" << "FAILED - uncovered" );
           ok = false;
         }
       }else
       {
-        std::clog << "mmp::Geodesics::sanity_check\t|"
-                  << " isolated "
-                  << std::endl;
+        UTK_LOG( TRACE, "mmp::Geodesics::sanity_check\t|"
+                        << " isolated " );
         continue;
       }  
     }else
@@ -893,16 +891,11 @@ bool  Geodesics::sanity_check()  const
       for( winlist_t::const_iterator it = wlist.begin(); it != wlist.end(); ++it )
       { 
 		assert( *it );
-        std::clog << "\t\t\t\t\t| " << **it
-                  << std::endl << std::flush;
+        UTK_LOG( TRACE, "\t\t\t\t\t| " << **it );
 	   
         if( !(*it)->sanity_check() )
-        { std::cerr << "mmp::Geodesics::sanity_check\t|"
-                    << "FAILED - sanity_check failed for " << *eits.first
-                    << std::endl;
-		  std::clog << "mmp::Geodesics::sanity_check\t|"
-                    << "FAILED - sanity_check failed for " << *eits.first
-                    << std::endl;
+        { UTK_LOG( ERROR, "mmp::Geodesics::sanity_check\t|"
+                          << "FAILED - sanity_check failed for " << *eits.first );
           ok = false;
         }
         
@@ -914,20 +907,12 @@ bool  Geodesics::sanity_check()  const
           if( (*it)->bound<RIGHT>() != (*nextit)->bound<LEFT>() )
           { const coord_t bdiff = (*it)->bound<RIGHT>() - (*nextit)->bound<LEFT>();
 				
-            std::cerr << "mmp::Geodesics::sanity_check\t|";
-            std::cerr << "FAILED - ";
-			std::clog << "FAILED - ";
             ok = false;
 				
-            std::cerr << (bdiff < coord_t(0.) ? "gap":"overlap") << " of " << fabs(bdiff) << " between:"
-                      << std::endl << "\t\t\t\t\t| " << **it
-                      << std::endl << "\t\t\t\t\t| " << **nextit
-                      << std::endl;
-			  
-            std::clog << (bdiff < coord_t(0.) ? "gap":"overlap") << " of " << fabs(bdiff) << " between:"
-                      << std::endl << "\t\t\t\t\t| " << **it
-                      << std::endl << "\t\t\t\t\t| " << **nextit
-                      << std::endl;
+            UTK_LOG( ERROR, "mmp::Geodesics::sanity_check\t|"
+                            << "FAILED - " << (bdiff < coord_t(0.) ? "gap":"overlap") << " of " << fabs(bdiff) << " between:"
+                            << std::endl << "\t\t\t\t\t| " << **it
+                            << std::endl << "\t\t\t\t\t| " << **nextit );
 
             # if defined DBG_MMP__USE_CAIRO
             visualizer::cairo::draw_edge_sequences_to_file( it, ++decltype(nextit)(nextit), *this, dbg_prefix+"_gap_overlap" );
@@ -946,21 +931,12 @@ bool  Geodesics::sanity_check()  const
                   ) 
             )
           {
-            std::cerr << "mmp::Geodesics::sanity_check\t|"
-                      << "FAILED"  << " - crossing of optimal paths"
-                      << std::endl << "\t\t\t\t\t| " << **it
-                      << std::endl << "\t\t\t\t\t| " << **nextit << std::endl;
-
-            std::clog << "mmp::Geodesics::sanity_check\t|"
-                      << "FAILED" << " - crossing of optimal paths" << std::endl;
-			
-			if( (*it)->predeccessor() )  
-			  std::clog << "\t\t\t\t\t| pred " <<     *(*it)->predeccessor()<< std::endl;
-			if( (*nextit)->predeccessor() )  
-              std::clog << "\t\t\t\t\t| pred " << *(*nextit)->predeccessor()<< std::endl;
-			
-            std::clog << "\t\t\t\t\t| " << **it     << std::endl
-                      << "\t\t\t\t\t| " << **nextit << std::endl;
+            UTK_LOG( ERROR, "mmp::Geodesics::sanity_check\t|"
+                            << "FAILED" << " - crossing of optimal paths"
+                            << std::endl << "\t\t\t\t\t| pred " << predeccessor_string( **it )
+                            << std::endl << "\t\t\t\t\t| pred " << predeccessor_string( **nextit )
+                            << std::endl << "\t\t\t\t\t| " << **it
+                            << std::endl << "\t\t\t\t\t| " << **nextit );
 
             # if defined DBG_MMP__USE_CAIRO
         	visualizer::cairo::draw_windows_to_file( it, ++decltype(nextit)(nextit), dbg_prefix+"_ac" );
@@ -972,19 +948,11 @@ bool  Geodesics::sanity_check()  const
           const distance_t wleftd0 = (*it)->source_distance<RIGHT>();
           if( !dist_snap_check( wleftd0, (*nextit)->source_distance<LEFT>()) )
           { const distance_t ddiff = (*nextit)->source_distance<LEFT>() - wleftd0;
-            std::cerr << "mmp::Geodesics::sanity_check"
-                      << "\t|FAILED"
-                      << " - jump of " << ddiff << " in distance function between:"
-                      << std::endl << "\t\t\t\t\t| " << **it
-                      << std::endl << "\t\t\t\t\t| " << **nextit
-                      << std::endl;
-
-            std::clog << "mmp::Geodesics::sanity_check"
-                      << "\t|FAILED"
-                      << " - jump of " << ddiff << " in distance function between:"
-                      << std::endl << "\t\t\t\t\t| " << **it
-                      << std::endl << "\t\t\t\t\t| " << **nextit
-                      << std::endl;
+            UTK_LOG( ERROR, "mmp::Geodesics::sanity_check"
+                            << "\t|FAILED"
+                            << " - jump of " << ddiff << " in distance function between:"
+                            << std::endl << "\t\t\t\t\t| " << **it
+                            << std::endl << "\t\t\t\t\t| " << **nextit );
 
             # if defined DBG_MMP__USE_CAIRO
         	visualizer::cairo::draw_edge_sequences_to_file( it, ++decltype(nextit)(nextit), *this, dbg_prefix+"_jump" );
@@ -998,13 +966,8 @@ bool  Geodesics::sanity_check()  const
       
       if( wlist.front()->bound<LEFT>() != 0 )
       { 
-		std::cerr << "mmp::Geodesics::sanity_check"
-                  << "\t|FAILED - gap at beginning (b0=" << wlist.front()->bound<LEFT>() << ") of " << (*eits.first)
-                  << std::endl;
-
-		std::clog << "mmp::Geodesics::sanity_check"
-                  << "\t|FAILED - gap at beginning (b0=" << wlist.front()->bound<LEFT>() << ") of " << (*eits.first)
-                  << std::endl;
+		UTK_LOG( ERROR, "mmp::Geodesics::sanity_check"
+                        << "\t|FAILED - gap at beginning (b0=" << wlist.front()->bound<LEFT>() << ") of " << (*eits.first) );
 
         # if defined DBG_MMP__USE_CAIRO
         visualizer::cairo::draw_edge_sequence_to_file( *wlist.front(), *this, dbg_prefix+"_gap_begin" );
@@ -1015,13 +978,8 @@ bool  Geodesics::sanity_check()  const
 
       if( !std::isfinite( vertex_labels[(*eits.first).source()] ) )
       {
-        std::cerr << "mmp::Geodesics::sanity_check"
-                  << "\t|FAILED - infinite vertex label (left)"
-                  << std::endl;
-
-        std::clog << "mmp::Geodesics::sanity_check"
-                  << "\t|FAILED - infinite vertex label (left)"
-                  << std::endl;
+        UTK_LOG( ERROR, "mmp::Geodesics::sanity_check"
+                        << "\t|FAILED - infinite vertex label (left)" );
 		
         ok = false;
       }
@@ -1034,34 +992,20 @@ bool  Geodesics::sanity_check()  const
              )
         )
       { 
-		std::cerr << "mmp::Geodesics::sanity_check"
-                  << "\t|FAILED - distance mismatch - left endpoint"
-                  << " (" << wlist.front()->source_distance<LEFT>() << ")"
-                  << " vertex (" << vertex_labels[ eits.first->source() ] << ")"
-                  << " error " << ( vertex_labels[ eits.first->source() ] - wlist.front()->source_distance<LEFT>() )
-                  << std::endl;
-
-		std::clog << "mmp::Geodesics::sanity_check"
-                  << "\t|FAILED - distance mismatch - left endpoint"
-                  << " (" << wlist.front()->source_distance<LEFT>() << ")"
-                  << " vertex (" << vertex_labels[ eits.first->source() ] << ")"
-                  << " error " << ( vertex_labels[ eits.first->source() ] - wlist.front()->source_distance<LEFT>() )
-                  << std::endl;
+		UTK_LOG( ERROR, "mmp::Geodesics::sanity_check"
+                        << "\t|FAILED - distance mismatch - left endpoint"
+                        << " (" << wlist.front()->source_distance<LEFT>() << ")"
+                        << " vertex (" << vertex_labels[ eits.first->source() ] << ")"
+                        << " error " << ( vertex_labels[ eits.first->source() ] - wlist.front()->source_distance<LEFT>() ) );
 		
         ok = false;
       }
       
       if( !utk::close_ulps( wlist.back()->bound<RIGHT>(), eh.length() ) )
       { 
-		std::cerr << "mmp::Geodesics::sanity_check\t|"
-                  << "FAILED - gap at end (b1=" << wlist.back()->bound<RIGHT>() << ")"
-				  << " of " << *eits.first
-                  << std::endl;
-
-		std::clog << "mmp::Geodesics::sanity_check\t|"
-                  << "FAILED - gap at end (b1=" << wlist.back()->bound<RIGHT>() << ")"
-				  << " of " << *eits.first
-                  << std::endl;
+		UTK_LOG( ERROR, "mmp::Geodesics::sanity_check\t|"
+                        << "FAILED - gap at end (b1=" << wlist.back()->bound<RIGHT>() << ")"
+				        << " of " << *eits.first );
 		# if defined DBG_MMP__USE_CAIRO
         visualizer::cairo::draw_edge_sequence_to_file( *wlist.back(), *this, dbg_prefix+"_gap_end" );
         # endif
@@ -1071,13 +1015,8 @@ bool  Geodesics::sanity_check()  const
 
       if( !std::isfinite( vertex_labels[ eits.first->target() ] ) )
       {
-        std::cerr << "mmp::Geodesics::sanity_check"
-                  << "\t|FAILED - infinite vertex label (right)"
-                  << std::endl;
-
-        std::clog << "mmp::Geodesics::sanity_check"
-                  << "\t|FAILED - infinite vertex label (right)"
-                  << std::endl;
+        UTK_LOG( ERROR, "mmp::Geodesics::sanity_check"
+                        << "\t|FAILED - infinite vertex label (right)" );
 		
         ok = false;
       }
@@ -1090,19 +1029,11 @@ bool  Geodesics::sanity_check()  const
              )
         )
       { 
-		std::cerr << "mmp::Geodesics::sanity_check"
-                  << "\t|FAILED - distance mismatch - right endpoint "
-                  << " (" << wlist.back()->source_distance<RIGHT>() << ")"
-                  << " vertex (" << vertex_labels[ eits.first->target().descriptor() ] << ")"
-                  << " error " << ( vertex_labels[ eits.first->target().descriptor() ] - wlist.back()->source_distance<RIGHT>() )
-                  << std::endl;
-
-		std::clog << "mmp::Geodesics::sanity_check"
-                  << "\t|FAILED - distance mismatch - right endpoint "
-                  << " (" << wlist.back()->source_distance<RIGHT>() << ")"
-                  << " vertex (" << vertex_labels[ eits.first->target().descriptor() ] << ")"
-                  << " error " << ( vertex_labels[ eits.first->target().descriptor() ] - wlist.back()->source_distance<RIGHT>() )
-                  << std::endl;
+		UTK_LOG( ERROR, "mmp::Geodesics::sanity_check"
+                        << "\t|FAILED - distance mismatch - right endpoint "
+                        << " (" << wlist.back()->source_distance<RIGHT>() << ")"
+                        << " vertex (" << vertex_labels[ eits.first->target().descriptor() ] << ")"
+                        << " error " << ( vertex_labels[ eits.first->target().descriptor() ] - wlist.back()->source_distance<RIGHT>() ) );
 		
         ok = false;
       }
@@ -1111,21 +1042,12 @@ bool  Geodesics::sanity_check()  const
   }
 
   if( ok )
-  {	std::cout << "mmp::Geodesics::sanity_check"
-		      << "\t| completed successfully"
-		      << std::endl;
-	std::clog << "mmp::Geodesics::sanity_check"
-		      << "\t| completed successfully"
-		      << std::endl;
-  }else
-  {
-    std::cerr << "mmp::Geodesics::sanity_check"
-	  	      << "\t| FAILED"
-		      << std::endl;
-    std::clog << "mmp::Geodesics::sanity_check"
-		      << "\t| FAILED"
-		      << std::endl;
-  }
+    UTK_LOG( INFO, "mmp::Geodesics::sanity_check"
+		           << "\t| completed successfully" );
+  else
+    UTK_LOG( ERROR, "mmp::Geodesics::sanity_check"
+	  	            << "\t| FAILED" );
+
   return ok;
 }
 
@@ -1159,31 +1081,30 @@ bool mmp::vertex_pair_check( const std::shared_ptr< Surface >& surface, const di
       abs_acc( diff );
       rel_acc( diff / std::min( dists_full( i, j ), dists_full( j, i ) ) );
       
-      std::cout << "mmp::vertex_pair_check\t| "
-                << "(" << i << ',' << j << ") ";
       if( equal_distance ) 
-        std::cout << "equal " << dists_full( i, j ) << std::endl;
+        UTK_LOG( TRACE, "mmp::vertex_pair_check\t| "
+                        << "(" << i << ',' << j << ") "
+                        << "equal " << dists_full( i, j ) );
       else
       {
-        if( std::fabs( diff ) > tolerance )
-        {
-          std::cout << "FAILED " << std::endl;
-          distance_failed = true;
-        }
-
-        std::cout << "diff " <<  diff
-                  << " (ij) " << dists_full( i, j )    
-                  << " (ji) " << dists_full( j, i )
-                  << std::endl;
+        const bool failed = std::fabs( diff ) > tolerance;
+        
+        if( failed ) distance_failed = true;
+
+        UTK_LOG( DEBUG, "mmp::vertex_pair_check\t| "
+                        << "(" << i << ',' << j << ") "
+                        << ( failed ? "FAILED " : "" )
+                        << "diff " <<  diff
+                        << " (ij) " << dists_full( i, j )    
+                        << " (ji) " << dists_full( j, i ) );
       } 
     }
 
-  std::cout << "mmp::vertex_pair_check\t| " 
-            << ( distance_failed ? "FAILED" : "" ) 
-            << "abs error: min " << min( abs_acc ) << " mean " << mean( abs_acc ) << " max " << max( abs_acc )
-            << std::endl << "\t\t\t\t"
-            << "rel error: min " << min( rel_acc ) << " mean " << mean( rel_acc ) << " max " << max( rel_acc )
-            << std::endl;
+  UTK_LOG( INFO, "mmp::vertex_pair_check\t| " 
+                 << ( distance_failed ? "FAILED " : "" ) 
+                 << "abs error: min " << min( abs_acc ) << " mean " << mean( abs_acc ) << " max " << max( abs_acc )
+                 << std::endl << "\t\t\t\t"
+                 << "rel error: min " << min( rel_acc ) << " mean " << mean( rel_acc ) << " max " << max( rel_acc ) );
   
   return distance_failed;
 }
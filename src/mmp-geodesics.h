@@ -105,7 +105,7 @@ namespace gtk { class GeodesicsInspector; }
         typedef std::pair<winlist_t::reverse_iterator,winlist_t::iterator> ac_t;
 
         // stores a window list for every edge
-        typedef boost::vector_property_map< winlist_t, boost::property_map< surface_type::graph_t, boost::edge_index_t >::type >
+        typedef boost::vector_property_map< winlist_t, surface_type::property_map< boost::edge_index_t >::type >
                                                         edge_winlist_pmap_t;
         // stores a distance label for every vertex
         typedef boost::vector_property_map<distance_t>  vertex_label_pmap_t;
@@ -138,6 +138,9 @@ namespace gtk { class GeodesicsInspector; }
 
         mutable distance_t          m_max_distance;
 
+        // events handled so far - the queue may keep its size while the propagation advances
+        size_t                      m_num_steps;
+
         
         //----|functions
           
@@ -150,6 +153,7 @@ namespace gtk { class GeodesicsInspector; }
 									  EventPoint* ev = event_queue.pop(); 
 									  handle_event( ev );
 									  delete ev;
+									  ++m_num_steps;
 									  return !event_queue.empty();
 									}
 		  
@@ -262,6 +266,8 @@ namespace gtk { class GeodesicsInspector; }
           
         const vertex_descriptor&    source()   const    { return m_source; }
 
+        const size_t&               num_steps()    const    { return m_num_steps; }
+
           
         // deletes all windows on a given edge
 		static void 				delete_windows_on_edge(winlist_t& wins) 
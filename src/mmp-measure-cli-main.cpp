@@ -18,9 +18,14 @@
 # include "surface.h"
 # include "quad-surface.h"
 # include "surface-generators.h"
+# include "mmp-geodesics.h"
+# include "mmp-distance-field.h"
 
 # include <boost/program_options.hpp>
 
+# include <fstream>
+# include <stdexcept>
+
 # define CLI_MEASURE__GL_OUTPUT
 
 # if defined CLI_MEASURE__GL_OUTPUT
@@ -55,6 +60,12 @@ int main (int argc, char *argv[])
   const char generator_param[]   = "generator";
   const char export_dist_param[] = "export-distances";
 
+  // geodesic distance map
+  const char distance_map_param[]        = "distance-map";
+  const char distance_map_source_param[] = "distance-map-source";
+  const char distance_map_size_param[]   = "distance-map-size";
+  const char isoline_spacing_param[]     = "isoline-spacing";
+
   const char session_out_param[]   = "session-out";
 
   po::options_description desc("Program options");
@@ -64,6 +75,10 @@ int main (int argc, char *argv[])
     (surface_file_param, po::value< std::string >(), "loads surface and texture from the specified file" )
     (generator_param, po::value< std::string >(), "defines a surface generator" )
     (export_dist_param, po::value< std::string >(), "specifies a file to which the distance matrix will be exported" )
+    (distance_map_param, po::value< std::string >(), "propagates the geodesics from a source vertex and writes the distance map to a png file" )
+    (distance_map_source_param, po::value< size_t >()->default_value( 0 ), "source vertex of the distance map" )
+    (distance_map_size_param, po::value< size_t >()->default_value( 512 ), "width and height of the distance map in pixels" )
+    (isoline_spacing_param, po::value< double >()->default_value( 0. ), "distance between the isolines of the distance map - none if zero" )
     ;
   
   po::variables_map vm;
@@ -80,6 +95,7 @@ int main (int argc, char *argv[])
   if( vm.count( generator_param ) )     { std::cout << generator_param << " \"" << vm[ generator_param ].as<std::string>() << "\" "; }
 
   if( vm.count( export_dist_param ) ) { std::cout << export_dist_param << " \"" << vm[ export_dist_param ].as<std::string>() << "\" "; }
+  if( vm.count( distance_map_param ) ) { std::cout << distance_map_param << " \"" << vm[ distance_map_param ].as<std::string>() << "\" "; }
   std::cout<<std::endl;
 
 
@@ -136,6 +152,34 @@ int main (int argc, char *argv[])
     distfile.close();
   }
 
+  //----| export geodesic distance map
+  if( vm.count( distance_map_param ) )
+  {
+    const std::string path( vm[ distance_map_param ].as< std::string >() );
+    const size_t      source = vm[ distance_map_source_param ].as< size_t >();
+    const size_t      size   = vm[ distance_map_size_param ].as< size_t >();
+
+    if( source >= surface->num_vertices() || !size )
+    { std::cerr << "ERROR - invalid distance map source vertex " << source << " or size " << size << std::endl;
+      return 0;
+    }
+
+    mmp::Geodesics geodesics( *surface, source );
+    geodesics.propagate_paths();
+
+    mmp::DistanceField field( geodesics, size, size );
+    field.sample();
+
+    std::clog << "exporting distance map to file \"" << path << '\"'<< std::endl;
+
+    try
+    { field.write_png( path, vm[ isoline_spacing_param ].as< double >() ); }
+    catch( const std::runtime_error& error )
+    { std::cerr << "ERROR - " << error.what() << std::endl;
+      return 0;
+    }
+  }
+
   //----| exit
   return 1;
 }	
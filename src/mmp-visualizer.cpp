@@ -44,6 +44,9 @@ gtk::GeodesicsInspector::GeodesicsInspector( BaseObjectType* cobject, const Glib
   m_builder->get_widget( "stop_on_errors_check", m_stop_on_errors_check );
   on_stop_on_errors_check_clicked();
   m_stop_on_errors_check->signal_clicked().connect( sigc::mem_fun( *this, &GeodesicsInspector::on_stop_on_errors_check_clicked ) );
+
+  m_builder->get_widget( "distance_field_check", m_distance_field_check );
+  m_distance_field_check->signal_clicked().connect( sigc::mem_fun( *this, &GeodesicsInspector::on_distance_field_check_clicked ) );
     
   m_builder->get_widget( "step_button", m_step_button );
   m_step_button->signal_clicked().connect( sigc::mem_fun( *this, &GeodesicsInspector::single_step ) );
@@ -125,6 +128,9 @@ void gtk::GeodesicsInspector::initialize( Geodesics* geodesics, const std::share
   
   m_geodesics = geodesics;
 
+  // the drawables replaced below are destroyed with their gl objects
+  m_view->gl_release_drawables();
+
   if( !m_surface_drawable || m_surface_drawable->get_surface() != surface )
   { 
 	m_surface_drawable.reset( new gl::SurfaceDrawable( surface ) );
@@ -132,6 +138,7 @@ void gtk::GeodesicsInspector::initialize( Geodesics* geodesics, const std::share
   }
   
   m_geodesics_drawable.reset( new gl::GeodesicsDrawable( m_geodesics ) );
+  m_geodesics_drawable->set_distance_field_visibility( m_distance_field_check->get_active() );
 
   m_view->add_drawable( m_geodesics_drawable.get() );
   
@@ -167,9 +174,15 @@ void gtk::GeodesicsInspector::run_propagation( )
 
 gl::GeodesicsDrawable::GeodesicsDrawable( Geodesics* g )
 : m_geodesics( g ), m_events_visible( EventPoint::ALL ), m_covering_visible( true ), m_gl_initialized( false )  
+, m_covering_triangles( VERTEX_FLOATS, 3 ), m_covering_lines( VERTEX_FLOATS, 2 ), m_covering_sidelobe_lines( VERTEX_FLOATS, 2 )
+, m_covering_pass( 0 )
+, m_covering_shading( TEXTURE_DISTANCE_SHADING ), m_covering_max_distance( 0 )
+, m_distance_field_visible( false ), m_distance_field_size( 512 ), m_isoline_spacing( 0 )
+, m_distance_texture( 0 ), m_distance_field_windows( 0 ), m_distance_field_events( 0 ), m_distance_texture_valid( false )
 {	}
 
 
+
 void gl::GeodesicsDrawable::gl_init_textures()
 {
   	const size_t width = 128;
@@ -212,130 +225,186 @@ void gl::GeodesicsDrawable::gl_init_textures()
 }
 
 
-void gl::GeodesicsDrawable::gl_draw_event_point( EventPoint* ev )
+
+void gl::GeodesicsDrawable::add_vertex( vertices_t& vertices, const location_ref_t position, const location_ref_t normal
+                                      , const rgba_color_ref_t color, const distance_t distance )
 {
-  using ::gl::Color;
-  using ::gl::Vertex;
-  
-  if( ! ( get_events_visibility() & ev->flags() ) ) return;
+  vertices.insert( vertices.end(), position.begin(), position.end() );
+  vertices.insert( vertices.end(), normal.begin(), normal.end() );
+  vertices.insert( vertices.end(), color.begin(), color.end() );
+  vertices.push_back( distance );
+}
 
-  Geodesics::edge_handle edge( ev->window()->edge, get_geodesics()->surf );
 
-  const location_t evloc =  edge.ray().at_arc_length( ev->point() );
+void gl::GeodesicsDrawable::gl_draw_vertices( const GLfloat* base, const GLsizei stride, const size_t count, const GLenum mode
+                                            , const shading_t shading, const bool lighting, const distance_t top_distance )
+{
+  if( !count ) return;
+
+  const bool textured = shading == TEXTURE_DISTANCE_SHADING;
+
+  glEnableClientState( GL_VERTEX_ARRAY );
+  glEnableClientState( GL_NORMAL_ARRAY );
+  glEnableClientState( GL_COLOR_ARRAY );
+
+  glVertexPointer( 3, GL_FLOAT, stride, base );
+  glNormalPointer( GL_FLOAT, stride, base + 3 );
+  glColorPointer( 4, GL_FLOAT, stride, base + 6 );
+
+  if( textured )
+  { glEnable( GL_TEXTURE_1D );
+	glBindTexture( GL_TEXTURE_1D, m_equidist_texture );
+
+    glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+    glTexCoordPointer( 1, GL_FLOAT, stride, base + 10 );
+
+    // the vertices keep their source distances - the texture moves along with the top event
+    glMatrixMode( GL_TEXTURE );
+    glPushMatrix();
+    glLoadIdentity();
+    glTranslated( -top_distance, 0., 0. );
+    glMatrixMode( GL_MODELVIEW );
+  }
+
+  if( lighting ) glEnable( GL_LIGHTING );
+  else           glDisable( GL_LIGHTING );
+
+  glDrawArrays( mode, 0, count );
 
   glDisable( GL_LIGHTING );
-  
-  if( get_geodesics()->event_queue.top() == ev )
-  { // draw top-event marker
-    glPointSize( 5. );
-    Color( rgba_color_t( 1, .2, .2, 1 ) );
-   	
-    glBegin( GL_POINTS );
-      Vertex( evloc );
-    glEnd();
+
+  if( textured )
+  { glMatrixMode( GL_TEXTURE );
+    glPopMatrix();
+    glMatrixMode( GL_MODELVIEW );
+
+    glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+    glDisable( GL_TEXTURE_1D );
   }
 
-  // draw event point
+  glDisableClientState( GL_COLOR_ARRAY );
+  glDisableClientState( GL_NORMAL_ARRAY );
+  glDisableClientState( GL_VERTEX_ARRAY );
+}
+
+
+void gl::GeodesicsDrawable::tessellate_event_point( EventPoint* ev, const EventPoint* top_event )
+{
+  if( ! ( get_events_visibility() & ev->flags() ) ) return;
+
+  Geodesics::edge_handle edge( ev->window()->edge, get_geodesics()->surf );
+
+  const location_t evloc  = edge.ray().at_arc_length( ev->point() );
+  const location_t normal( 0. );
+
+  // top-event marker
+  if( ev == top_event )
+    add_vertex( m_top_event_points, evloc, normal, rgba_color_t( 1, .2, .2, 1 ), 0. );
+
   const rgba_color_t ev_col( ev->flags() & EventPoint::FRONTIER ? rgba_color_t( 1., .1, .1, .8 ) : rgba_color_t( .1, .1, 1, .2 ) );
   
-  Color( ev_col );	
-  glPointSize( 3. );
-
-  glBegin( GL_POINTS );
-    Vertex( evloc );
-  glEnd();
-		          
+  add_vertex( m_event_points, evloc, normal, ev_col, 0. );
 }
 
-void gl::GeodesicsDrawable::gl_draw_window_edges( const Window& window, const Window::types& window_type
-                                                , const location_t& win_left, const location_t& win_right
-                                                , const location_t& pre_left, const location_t& pre_right 
-                                                , const rgba_color_ref_t edge_color, const rgba_color_ref_t source_edge_color )
+void gl::GeodesicsDrawable::tessellate_window_edges( const Window& window, const Window::types& window_type
+                                                   , const location_t& win_left, const location_t& win_right
+                                                   , const location_t& pre_left, const location_t& pre_right 
+                                                   , const rgba_color_ref_t edge_color, const rgba_color_ref_t source_edge_color
+                                                   , geometry_t& geometry )
 {
-  using ::gl::Vertex;
-  using ::gl::Color;
-  
-  glDisable( GL_LIGHTING );
-  
+  const location_t normal( 0. );
+
   if( window_type == Window::INNER_SIDELOBE )
   {
-    glLineWidth( 1.6 );
     const bool ps_left = window.has_ps_vertex<mmp::LEFT>();
-    glBegin( GL_LINES );
-    { 
-      Color( ps_left ? source_edge_color : edge_color ); Vertex( win_left ); 
-      Color( ps_left ? edge_color : source_edge_color ); Vertex( win_right );
-    }
-    glEnd();
+
+    vertices_t& lines = geometry.sidelobe_lines;
+
+    add_vertex( lines, win_left,  normal, ps_left ? source_edge_color : edge_color, 0. );
+    add_vertex( lines, win_right, normal, ps_left ? edge_color : source_edge_color, 0. );
   }else
   {
-    glLineWidth( 1. );
-    glBegin( GL_LINES );
-    { 
-      Color( edge_color ); Vertex( win_left  ); if(window_type == Window::OUTER_SIDELOBE) Color( source_edge_color ); Vertex( pre_left  );
-      Color( edge_color ); Vertex( win_right ); if(window_type == Window::OUTER_SIDELOBE) Color( source_edge_color ); Vertex( pre_right );
-      Color( edge_color ); Vertex( win_left  ); Vertex( win_right ); 
-    }
-    glEnd();
+    vertices_t& lines = geometry.lines;
+
+    const rgba_color_ref_t pre_color = window_type == Window::OUTER_SIDELOBE ? source_edge_color : edge_color;
+
+    add_vertex( lines, win_left,  normal, edge_color, 0. ); add_vertex( lines, pre_left,  normal, pre_color, 0. );
+    add_vertex( lines, win_right, normal, edge_color, 0. ); add_vertex( lines, pre_right, normal, pre_color, 0. );
+    add_vertex( lines, win_left,  normal, edge_color, 0. ); add_vertex( lines, win_right, normal, edge_color, 0. );
   }
 }
 
 
-bool gl::GeodesicsDrawable::gl_draw_window_subdivision( const Window& window
-                                                      , const rgba_color_ref_t edge_color
-                                                      , const rgba_color_ref_t fill_color
-                                                      , const rgba_color_ref_t source_color
-                                                      , const shading_t shading
-                                                      )
+bool gl::GeodesicsDrawable::tessellate_window( const Window& window
+                                             , const rgba_color_ref_t edge_color
+                                             , const rgba_color_ref_t fill_color
+                                             , const rgba_color_ref_t source_color
+                                             , const shading_t shading
+                                             , const bool subdivision
+                                             , geometry_t& geometry
+                                             )
 { using mmp::LEFT;
   using mmp::RIGHT;
   
   const Window* pre = window.predeccessor();
 
+  if( !pre ) return false;
+
   const Window::types type = window.type();
-  if( pre )
-  { 
-    std::tuple< coord_t, coord_t > pre_bounds = get_geodesics()->backtrace( window, window );
 
-    const Geodesics::edge_handle win_edge( window.edge, m_geodesics->get_surface() );
-    const Geodesics::edge_handle pre_edge( pre->edge   , m_geodesics->get_surface() );
+  std::tuple< coord_t, coord_t > pre_bounds = get_geodesics()->backtrace( window, window );
+
+  const Geodesics::edge_handle win_edge( window.edge, m_geodesics->get_surface() );
+  const Geodesics::edge_handle pre_edge( pre->edge   , m_geodesics->get_surface() );
+
+  const location_t win_left  = win_edge.ray().at_arc_length( window.bound<  LEFT >() );
+  const location_t win_right = win_edge.ray().at_arc_length( window.bound< RIGHT >() );
 
-    const location_t win_left  = win_edge.ray().at_arc_length( window.bound< mmp::LEFT  >() );
-    const location_t win_right = win_edge.ray().at_arc_length( window.bound< RIGHT >() );
+  const location_t pre_left  = pre_edge.ray().at_arc_length( get<  LEFT >(pre_bounds) );
+  const location_t pre_right = pre_edge.ray().at_arc_length( get< RIGHT >(pre_bounds) );
 
-    const location_t pre_left  = pre_edge.ray().at_arc_length( get<  LEFT >(pre_bounds) );
-    const location_t pre_right = pre_edge.ray().at_arc_length( get< RIGHT >(pre_bounds) );
+  ps_t pre_ps = pre->pseudosource();
 
-    ps_t pre_ps = pre->pseudosource();
+  const distance_t pre_left_distance  = pre->source_distance( get< LEFT>(pre_bounds), pre_ps );
+  const distance_t pre_right_distance = pre->source_distance( get<RIGHT>(pre_bounds), pre_ps );
 
-    gl_do_draw_subdivision( window
+  if( subdivision )
+  { 
+    tessellate_subdivision( window
                           , type
                           , 1e-2 
-                          , edge_color, fill_color, source_color, shading
+                          , fill_color, source_color, shading
                           , win_edge.face().normal()
                           , window.bounds()
                           , window.source_distances()
-                          , std::make_pair( pre->source_distance( get< LEFT>(pre_bounds), pre_ps )
-                                          , pre->source_distance( get<RIGHT >(pre_bounds), pre_ps ) )
-                          , std::make_pair( win_left, win_right )
-                          , std::make_pair( pre_left, pre_right )
+                          , { pre_left_distance, pre_right_distance }
+                          , { win_left, win_right }
+                          , { pre_left, pre_right }
                           , window.pseudosource() 
-                          , pre_ps );
+                          , pre_ps
+                          , geometry.triangles );
 
 #warning "Change edge to source color"
-    gl_draw_window_edges( window, type, win_left, win_right, pre_left, pre_right, edge_color, /*!!!*/ edge_color );
-    
-    return ! ( type & Window::OUTER_SIDELOBE );
+    tessellate_window_edges( window, type, win_left, win_right, pre_left, pre_right, edge_color, /*!!!*/ edge_color, geometry );
   }
-  return false;
+  else
+    tessellate_interval( type
+                       , fill_color, source_color, shading
+                       , win_edge.face().normal()
+                       , window.source_distances()
+                       , { pre_left_distance, pre_right_distance }
+                       , { win_left, win_right }
+                       , { pre_left, pre_right }
+                       , geometry.triangles );
+    
+  return ! ( type & Window::OUTER_SIDELOBE );
 }
 
 
 
-void gl::GeodesicsDrawable::gl_do_draw_subdivision( const Window&           window
+void gl::GeodesicsDrawable::tessellate_subdivision( const Window&           window
                                                   , const Window::types     window_type
                                                   , const distance_t        recursion_threshold
-                                                  , const rgba_color_ref_t  edge_color
                                                   , const rgba_color_ref_t  fill_color
                                                   , const rgba_color_ref_t  source_color
                                                   , const shading_t         shading
@@ -347,16 +416,11 @@ void gl::GeodesicsDrawable::gl_do_draw_subdivision( const Window&           wind
                                                   , const std::pair< const location_t&, const location_t& >& pre_points
                                                   , const ps_t& win_ps
                                                   , const ps_t& pre_ps
+                                                  , vertices_t& triangles
                                                   )
 { using mmp::LEFT;
   using mmp::RIGHT;
 
-  using ::gl::Vertex;
-  using ::gl::Normal;
-  using ::gl::Color;
-
-  //std::cout<< "gl::GeodesicsDrawable::gl_do_draw_subdivision\t| " << window << std::endl;
-  
   assert( window.predeccessor() );
   const Window& pre = *window.predeccessor();
   
@@ -376,10 +440,10 @@ void gl::GeodesicsDrawable::gl_do_draw_subdivision( const Window&           wind
   const location_t pre_mid_point  = pre_edge.ray().at_arc_length( pre_mid );
 
   if( subdivide )
-  { gl_do_draw_subdivision( window
+  { tessellate_subdivision( window
                           , window_type
                           , recursion_threshold
-                          , edge_color, fill_color, source_color, shading
+                          , fill_color, source_color, shading
                           , normal
                           , { get< LEFT >(bounds)       , win_mid }
                           , { get< LEFT >(win_distances), win_mid_distance }
@@ -387,11 +451,12 @@ void gl::GeodesicsDrawable::gl_do_draw_subdivision( const Window&           wind
                           , { get< LEFT >(win_points)   , win_mid_point }
                           , { get< LEFT >(pre_points)   , pre_mid_point }
                           , win_ps, pre_ps
+                          , triangles
                           );
-    gl_do_draw_subdivision( window
+    tessellate_subdivision( window
                           , window_type
                           , recursion_threshold
-                          , edge_color, fill_color, source_color, shading   
+                          , fill_color, source_color, shading   
                           , normal
                           , { win_mid         , get< RIGHT >(bounds) }
                           , { win_mid_distance, get< RIGHT >(win_distances) }
@@ -399,64 +464,45 @@ void gl::GeodesicsDrawable::gl_do_draw_subdivision( const Window&           wind
                           , { win_mid_point   , get< RIGHT >(win_points) }
                           , { pre_mid_point   , get< RIGHT >(pre_points) }
                           , win_ps, pre_ps
+                          , triangles
                           );
   }
   else
   {
-    gl_draw_interval( window
-                    , window_type
-                    , edge_color, fill_color, source_color, shading
-                    , normal
-                    , { get< LEFT >(win_distances), win_mid_distance }
-                    , { get< LEFT >(pre_distances), pre_mid_distance }
-                    , { get< LEFT >(win_points)   , win_mid_point }
-                    , { get< LEFT >(pre_points)   , pre_mid_point }
-                    );
-    gl_draw_interval( window
-                    , window_type
-                    , edge_color, fill_color, source_color, shading
-                    , normal
-                    , { win_mid_distance, get< RIGHT >(win_distances) }
-                    , { pre_mid_distance, get< RIGHT >(pre_distances) }
-                    , { win_mid_point   , get< RIGHT >(win_points) }
-                    , { pre_mid_point   , get< RIGHT >(pre_points) }
-                    );
+    tessellate_interval( window_type
+                       , fill_color, source_color, shading
+                       , normal
+                       , { get< LEFT >(win_distances), win_mid_distance }
+                       , { get< LEFT >(pre_distances), pre_mid_distance }
+                       , { get< LEFT >(win_points)   , win_mid_point }
+                       , { get< LEFT >(pre_points)   , pre_mid_point }
+                       , triangles
+                       );
+    tessellate_interval( window_type
+                       , fill_color, source_color, shading
+                       , normal
+                       , { win_mid_distance, get< RIGHT >(win_distances) }
+                       , { pre_mid_distance, get< RIGHT >(pre_distances) }
+                       , { win_mid_point   , get< RIGHT >(win_points) }
+                       , { pre_mid_point   , get< RIGHT >(pre_points) }
+                       , triangles
+                       );
   }
-
-  // uncomment to drw subdivision
-  /*
-  glPointSize( 1 );
-
-  glBegin( GL_LINES );
-
-    flat::gl::Color( .5, .2, 1. , 1.);
-
-    flat::gl::Vertex( win_mid_point );
-
-    flat::gl::Vertex( pre_mid_point );
-
-  glEnd();
-  */
 }
 
-void gl::GeodesicsDrawable::gl_draw_interval( const Window&             window
-                                            , const Window::types       window_type
-                                            , const rgba_color_ref_t    edge_color
-                                            , const rgba_color_ref_t    fill_color
-                                            , const rgba_color_ref_t    source_color
-                                            , const shading_t           shading
-                                            , const location_ref_t      normal
-                                            , const std::pair< const distance_t&, const distance_t& >& win_distances
-                                            , const std::pair< const distance_t&, const distance_t& >& pre_distances
-                                            , const std::pair< const location_t&, const location_t& >& win_points
-                                            , const std::pair< const location_t&, const location_t& >& pre_points )
+void gl::GeodesicsDrawable::tessellate_interval( const Window::types       window_type
+                                               , const rgba_color_ref_t    fill_color
+                                               , const rgba_color_ref_t    source_color
+                                               , const shading_t           shading
+                                               , const location_ref_t      normal
+                                               , const std::pair< const distance_t&, const distance_t& >& win_distances
+                                               , const std::pair< const distance_t&, const distance_t& >& pre_distances
+                                               , const std::pair< const location_t&, const location_t& >& win_points
+                                               , const std::pair< const location_t&, const location_t& >& pre_points
+                                               , vertices_t& triangles )
 { using mmp::LEFT;
   using mmp::RIGHT;
   
-  using ::gl::Vertex;
-  using ::gl::Normal;
-  using ::gl::Color;  
-  
   // default: FLAT_SHADING
   rgba_color_t win_left_color = fill_color, win_right_color = fill_color,
                pre_left_color = fill_color, pre_right_color = fill_color;
@@ -473,167 +519,263 @@ void gl::GeodesicsDrawable::gl_draw_interval( const Window&             window
     pre_right_color.rgb() = rgb_color_t( get<RIGHT>(pre_distances) / max_distance );
   }    
 
-  
-  if( shading == TEXTURE_DISTANCE_SHADING )
-  {	glEnable( GL_TEXTURE_1D );
-	glBindTexture( GL_TEXTURE_1D, m_equidist_texture );
-  }
-
-  glEnable( GL_LIGHTING );
+  // the source distances go to the texture coordinates - they are drawn relative to the top event
+  add_vertex( triangles, get< LEFT>(win_points), normal, win_left_color,  get< LEFT>(win_distances) );
+  add_vertex( triangles, get<RIGHT>(win_points), normal, win_right_color, get<RIGHT>(win_distances) );
 
-  const distance_t top_distance = m_geodesics->event_queue.empty() ? 0. : m_geodesics->event_queue.top()->distance();
-
-
-  
   if( window_type == Window::OUTER_SIDELOBE )
   { 
 	// pseudosource vertex
-    glBegin( GL_TRIANGLES );
-      Normal( normal );
-	  Color( win_left_color  ); glTexCoord1d( get< LEFT>(win_distances) - top_distance ); Vertex( get< LEFT>(win_points) );
-	  Color( win_right_color ); glTexCoord1d( get<RIGHT>(win_distances) - top_distance ); Vertex( get<RIGHT>(win_points) );
-	  Color( source_color    ); glTexCoord1d( get<RIGHT>(pre_distances) - top_distance ); Vertex( get<RIGHT>(pre_points) );
-    glEnd();
+    add_vertex( triangles, get<RIGHT>(pre_points), normal, source_color, get<RIGHT>(pre_distances) );
   }
   else
   {  
-    glBegin( GL_QUADS );
-      Normal( normal );
-	  Color( win_left_color  ); glTexCoord1d( get< LEFT>(win_distances) - top_distance ); Vertex( get< LEFT>(win_points) );
-	  Color( win_right_color ); glTexCoord1d( get<RIGHT>(win_distances) - top_distance ); Vertex( get<RIGHT>(win_points) );
-	  Color( pre_right_color ); glTexCoord1d( get<RIGHT>(pre_distances) - top_distance ); Vertex( get<RIGHT>(pre_points) );
-      Color( pre_left_color  ); glTexCoord1d( get< LEFT>(pre_distances) - top_distance ); Vertex( get< LEFT>(pre_points) );
-    glEnd();
+    // the quad split along its diagonal
+    add_vertex( triangles, get<RIGHT>(pre_points), normal, pre_right_color, get<RIGHT>(pre_distances) );
+
+    add_vertex( triangles, get< LEFT>(win_points), normal, win_left_color,  get< LEFT>(win_distances) );
+    add_vertex( triangles, get<RIGHT>(pre_points), normal, pre_right_color, get<RIGHT>(pre_distances) );
+    add_vertex( triangles, get< LEFT>(pre_points), normal, pre_left_color,  get< LEFT>(pre_distances) );
   }
+}
 
-  if( shading == TEXTURE_DISTANCE_SHADING )
-  {	glDisable( GL_TEXTURE_1D ); }
 
-  glDisable( GL_LIGHTING );
+void gl::GeodesicsDrawable::tessellate_window_sequence( const Window& window
+                                                      , const rgba_color_ref_t edge_color
+                                                      , const rgba_color_ref_t fill_color
+                                                      , const rgba_color_ref_t source_color
+                                                      , const shading_t shading
+                                                      , geometry_t& geometry )
+{
+  bool no_root = tessellate_window( window, edge_color, fill_color, source_color, shading, false, geometry );
+  
+  if( window.predeccessor() && no_root ) 
+    tessellate_window_sequence( *window.predeccessor(), edge_color, fill_color, source_color, shading, geometry );
 }
 
-bool gl::GeodesicsDrawable::gl_draw_window( const Window& window
-                                          , const rgba_color_ref_t edge_color
-                                          , const rgba_color_ref_t fill_color 
-                                          , const rgba_color_ref_t source_color 
-                                          , const shading_t shading )
+void gl::GeodesicsDrawable::update_covering( const shading_t shading )
 { using mmp::LEFT;
   using mmp::RIGHT;
-  
-  const Window* pre = window.predeccessor();
 
-  const Window::types type = window.type();
-  if( pre )
+  const distance_t max_distance = m_geodesics->max_distance();
+
+  // absolute distance shading colors every window relative to the largest distance
+  if( shading != m_covering_shading || ( shading == ABSOLUTE_DISTANCE_SHADING && max_distance != m_covering_max_distance ) )
+  { m_covering.clear();
+    m_covering_triangles.clear();
+    m_covering_lines.clear();
+    m_covering_sidelobe_lines.clear();
+    m_covering_shading      = shading;
+    m_covering_max_distance = max_distance;
+  }
+
+  const rgba_color_t edge_color( .5, .5, .5, .5 );
+  const rgba_color_t fill_color( .5, .5, .5, 1. );
+  const rgba_color_t source_color( 1., 1., .0, 1. );
+
+  ++m_covering_pass;
+
+  geometry_t geometry;
+
+  auto edges = m_geodesics->get_surface().edge_handles();
+
+  for( auto edge_it = edges.first; edge_it != edges.second; ++edge_it )
   { 
-    std::tuple< coord_t, coord_t > pre_bounds = get_geodesics()->backtrace( window, window );
+	const Geodesics::winlist_t& window_list = m_geodesics->windows[ *edge_it ];
 
-    const Geodesics::edge_handle win_edge( window.edge, m_geodesics->get_surface() );
-    const Geodesics::edge_handle pre_edge( pre->edge   , m_geodesics->get_surface() );
+    for( auto win_it = window_list.begin(); win_it != window_list.end(); ++win_it )
+    {
+      const Window& window = **win_it;
 
-    const location_t win_left  = win_edge.ray().at_arc_length( window.bound<  LEFT >() );
-    const location_t win_right = win_edge.ray().at_arc_length( window.bound< RIGHT >() );
+      const std::pair< std::unordered_map< const Window*, covering_entry >::iterator, bool > found
+        = m_covering.insert( std::make_pair( &window, covering_entry() ) );
 
-    const location_t pre_left  = pre_edge.ray().at_arc_length( get<  LEFT >(pre_bounds) );
-    const location_t pre_right = pre_edge.ray().at_arc_length( get< RIGHT >(pre_bounds) );
+      covering_entry& entry = found.first->second;
+      entry.pass = m_covering_pass;
 
-    ps_t pre_ps = pre->pseudosource();
-    
-    gl_draw_interval( window
-                    , type
-                    , edge_color, fill_color, source_color, shading
-                    , win_edge.face().normal()
-                    , window.source_distances()
-                    , std::make_pair( pre->source_distance( get< LEFT>(pre_bounds), pre_ps )
-                                    , pre->source_distance( get<RIGHT >(pre_bounds), pre_ps ) )
-                    , std::make_pair( win_left, win_right )
-                    , std::make_pair( pre_left, pre_right )
-                    );
-    
-    return ! ( type & Window::OUTER_SIDELOBE );
+      const Window* pre = window.predeccessor();
+      const coord_t pre_left  = pre ? pre->bound<  LEFT >() : coord_t( 0 );
+      const coord_t pre_right = pre ? pre->bound< RIGHT >() : coord_t( 0 );
+
+      if( !found.second && entry.id == window.id 
+          && entry.bounds[0] == window.bound< LEFT >() && entry.bounds[1] == window.bound< RIGHT >()
+          && entry.pre_bounds[0] == pre_left && entry.pre_bounds[1] == pre_right )
+        continue;
+
+      geometry.clear();
+      tessellate_window( window, edge_color, fill_color, source_color, shading, true, geometry );
+
+      entry.id            = window.id;
+      entry.bounds[0]     = window.bound<  LEFT >();
+      entry.bounds[1]     = window.bound< RIGHT >();
+      entry.pre_bounds[0] = pre_left;
+      entry.pre_bounds[1] = pre_right;
+
+      entry.triangles = m_covering_triangles.assign( entry.triangles, geometry.triangles.data(), geometry.triangles.size() / VERTEX_FLOATS );
+      entry.lines     = m_covering_lines.assign( entry.lines, geometry.lines.data(), geometry.lines.size() / VERTEX_FLOATS );
+      entry.sidelobe_lines = m_covering_sidelobe_lines.assign( entry.sidelobe_lines, geometry.sidelobe_lines.data()
+                                                             , geometry.sidelobe_lines.size() / VERTEX_FLOATS );
+    }
   }
-  return false;
-}
 
+  // the windows not met anymore were deleted
+  for( auto it = m_covering.begin(); it != m_covering.end(); )
+    if( it->second.pass != m_covering_pass )
+    { m_covering_triangles.release( it->second.triangles );
+      m_covering_lines.release( it->second.lines );
+      m_covering_sidelobe_lines.release( it->second.sidelobe_lines );
+      it = m_covering.erase( it );
+    }
+    else ++it;
+}
 
-void gl::GeodesicsDrawable::gl_draw_window_sequence( const Window& window
-                                                   , const rgba_color_ref_t edge_color
-                                                   , const rgba_color_ref_t fill_color
-                                                   , const rgba_color_ref_t source_color
-                                                   , const shading_t shading )
+void gl::GeodesicsDrawable::gl_draw_covering( const shading_t shading )
 {
-  bool no_root = gl_draw_window( window, edge_color, fill_color, source_color, shading );
-  
-  if( window.predeccessor() && no_root ) 
-    gl_draw_window_sequence( *window.predeccessor(), edge_color, fill_color, source_color, shading );
-  //else std::cout<< "mmp::visualizer::gl::GeodesicsDrawable::gl_draw_window_sequence\t| last " << window << std::endl;
+  update_covering( shading );
+
+  const distance_t top_distance = m_geodesics->event_queue.empty() ? 0. : m_geodesics->event_queue.top()->distance();
+
+  const GLfloat* triangles = m_covering_triangles.gl_bind();
+  gl_draw_vertices( triangles, m_covering_triangles.stride(), m_covering_triangles.size(), GL_TRIANGLES, shading, true, top_distance );
+  m_covering_triangles.gl_unbind();
+
+  glLineWidth( 1. );
+
+  const GLfloat* lines = m_covering_lines.gl_bind();
+  gl_draw_vertices( lines, m_covering_lines.stride(), m_covering_lines.size(), GL_LINES, FLAT_SHADING, false, top_distance );
+  m_covering_lines.gl_unbind();
+
+  glLineWidth( 1.6 );
+
+  const GLfloat* sidelobe_lines = m_covering_sidelobe_lines.gl_bind();
+  gl_draw_vertices( sidelobe_lines, m_covering_sidelobe_lines.stride(), m_covering_sidelobe_lines.size(), GL_LINES, FLAT_SHADING, false, top_distance );
+  m_covering_sidelobe_lines.gl_unbind();
 }
 
-void gl::GeodesicsDrawable::gl_draw_covering( const shading_t shading )
+
+void gl::GeodesicsDrawable::update_distance_texture()
 {
-  auto edges = m_geodesics->get_surface().edge_handles();
+  const size_t windows = mmp::Window::next_id;
+  const size_t events  = m_geodesics->num_steps();
 
-  for( auto edge_it = edges.first; edge_it != edges.second; ++edge_it )
-  { 
-	const Geodesics::winlist_t& window_list = m_geodesics->windows[ *edge_it ];
+  if( m_distance_texture_valid && m_distance_field_windows == windows && m_distance_field_events == events )
+    return;
 
-    const rgba_color_t edge_color( .5, .5, .5, .5 );
-    const rgba_color_t fill_color( .5, .5, .5, 1. );
-    const rgba_color_t source_color( 1., 1., .0, 1. );
-    
-	std::for_each( window_list.begin(), window_list.end()
-                 , [&]( Geodesics::winlist_t::value_type win_ptr ) 
-                   { return gl_draw_window_subdivision( *win_ptr, edge_color, fill_color, source_color, shading ); }
-                 );
+  if( !m_distance_field || m_distance_field->width() != m_distance_field_size )
+  { m_distance_field.reset( new DistanceField( *m_geodesics, m_distance_field_size, m_distance_field_size ) );
+    m_distance_texture_valid = false;
   }
-    
+
+  m_distance_field->sample();
+
+  std::vector< unsigned char > texels;
+  m_distance_field->rgb( texels, m_isoline_spacing );
+
+  const bool allocate = !m_distance_texture || !m_distance_texture_valid;
+
+  if( !m_distance_texture )
+  { glGenTextures( 1, &m_distance_texture );
+    glBindTexture( GL_TEXTURE_2D, m_distance_texture );
+
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+  }
+  else glBindTexture( GL_TEXTURE_2D, m_distance_texture );
+
+  // the rgb rows are not padded
+  glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+
+  const GLsizei size = m_distance_field->width();
+
+  if( allocate ) glTexImage2D( GL_TEXTURE_2D, 0, GL_RGB, size, size, 0, GL_RGB, GL_UNSIGNED_BYTE, texels.data() );
+  else           glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RGB, GL_UNSIGNED_BYTE, texels.data() );
+
+  glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+
+  m_distance_field_windows = windows;
+  m_distance_field_events  = events;
+  m_distance_texture_valid = true;
+}
+
+void gl::GeodesicsDrawable::gl_draw_distance_field()
+{
+  const Geodesics::surface_type& surface = m_geodesics->get_surface();
+
+  // the propagation does not move the vertices
+  if( m_field_vertices.size() != surface.num_faces() * 3 * 5 )
+  { m_field_vertices.clear();
+
+    for( auto face_it = surface.face_handles(); face_it.first != face_it.second; ++face_it.first )
+      for( size_t i = 0; i < 3; ++i )
+      { const Geodesics::surface_type::vertex_handle vertex = face_it.first->vertex( i );
+        const location_t location = vertex.location();
+        m_field_vertices.insert( m_field_vertices.end(), location.begin(), location.end() );
+        m_field_vertices.insert( m_field_vertices.end(), vertex.texture_coordinate().begin(), vertex.texture_coordinate().end() );
+      }
+  }
+
+  update_distance_texture();
+
+  const GLsizei stride = 5 * sizeof( GLfloat );
+
+  glEnable( GL_TEXTURE_2D );
+  glBindTexture( GL_TEXTURE_2D, m_distance_texture );
+  glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE );
+
+  glEnableClientState( GL_VERTEX_ARRAY );
+  glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+
+  glVertexPointer( 3, GL_FLOAT, stride, m_field_vertices.data() );
+  glTexCoordPointer( 2, GL_FLOAT, stride, m_field_vertices.data() + 3 );
+
+  glDisable( GL_LIGHTING );
+  glDrawArrays( GL_TRIANGLES, 0, m_field_vertices.size() / 5 );
+
+  glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+  glDisableClientState( GL_VERTEX_ARRAY );
+
+  // the covering textures modulate their colors
+  glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
+  glDisable( GL_TEXTURE_2D );
 }
 
 
-void gl::GeodesicsDrawable::gl_draw_wavefront_indicators( EventPoint* 	ev
-                                                        , rgba_color_ref_t crossing_color
-                                                        , rgba_color_ref_t colinear_color )
+void gl::GeodesicsDrawable::tessellate_wavefront_indicators( EventPoint* ev )
 { using mmp::LEFT;
   using mmp::RIGHT;
 
-  using ::gl::Vertex;
-  using ::gl::Color;
-  
-  const Window& window = *ev->window();
-  Geodesics::edge_handle edge( window.edge, get_geodesics()->surf );
-
   const coord_t rel_length = .333;
   
-  auto draw_indicators = [&] ( EventPoint* left_ev, EventPoint* right_ev )
-  						 { const Window& left_win =  *left_ev->window();
-						   const Window& right_win = *right_ev->window();
-							 
-						   Geodesics::edge_handle  left_edge(  left_win.edge, m_geodesics->get_surface() );
- 						   Geodesics::edge_handle right_edge( right_win.edge, m_geodesics->get_surface() );
-							 
-						   Vertex(  left_edge.ray().at_arc_length( left_win.bound<RIGHT>() - rel_length * left_win.length() ) );
-						   Vertex(  left_edge.ray().at_arc_length( left_win.bound<RIGHT>() ) );	 
-
-						   Vertex( right_edge.ray().at_arc_length( right_win.bound<LEFT>() ) );
-						   Vertex( right_edge.ray().at_arc_length( right_win.bound<LEFT>() + rel_length * right_win.length() ) );
-						 };
-
   # if defined FLAT_MMP_MAINTAIN_WAVEFRONT
 
+  if( ! ev->adjacent< LEFT >() ) return;
 
-  if( ev->colinear<LEFT>() )
-  { glLineWidth( 3. );
-    Color( colinear_color );
-  }else
-  { glLineWidth( 2. );
-    Color( crossing_color );
-  }
-  
-  glBegin( GL_LINE_STRIP );
+  const Window& left_win  = *ev->adjacent< LEFT >()->window();
+  const Window& right_win = *ev->window();
+
+  Geodesics::edge_handle  left_edge(  left_win.edge, m_geodesics->get_surface() );
+  Geodesics::edge_handle right_edge( right_win.edge, m_geodesics->get_surface() );
+
+  const location_t strip[4] = { left_edge.ray().at_arc_length( left_win.bound<RIGHT>() - rel_length * left_win.length() )
+                              , left_edge.ray().at_arc_length( left_win.bound<RIGHT>() )
+                              , right_edge.ray().at_arc_length( right_win.bound<LEFT>() )
+                              , right_edge.ray().at_arc_length( right_win.bound<LEFT>() + rel_length * right_win.length() ) };
+
+  const rgba_color_t colinear_color( .3, .8, .1, 1. );
+  const rgba_color_t crossing_color( .8, .3, .1, 1. );
 
-  if( ev->adjacent< LEFT >() ) 
-	draw_indicators( ev->adjacent< LEFT >(), ev );
+  const bool colinear = ev->colinear<LEFT>();
+  vertices_t& lines   = colinear ? m_colinear_indicators : m_crossing_indicators;
 
-  glEnd();
+  const location_t normal( 0. );
+
+  // the line strip as separate lines
+  for( size_t i = 0; i < 3; ++i )
+  { add_vertex( lines, strip[ i ],     normal, colinear ? colinear_color : crossing_color, 0. );
+    add_vertex( lines, strip[ i + 1 ], normal, colinear ? colinear_color : crossing_color, 0. );
+  }
   
   # endif
 }
@@ -648,11 +790,9 @@ void gl::GeodesicsDrawable::gl_draw_wavefront( const shading_t shading )
   rgba_color_t top_covering_color       ( 1, 0, 0, .3 );
 
   # if defined FLAT_MMP_MAINTAIN_WAVEFRONT
-  rgba_color_t colin_indicator_color	( .3, .8, .1, 1. );
   rgba_color_t colin_edge_color 		( .3, .8, .1, .4 );
   rgba_color_t colin_covering_color		( .3, .8, .1, .3 );
 
-  rgba_color_t cross_indicator_color	( .8, .3, .1, 1. );
   rgba_color_t cross_edge_color     	( .8, .3, .1, .4 );
   rgba_color_t cross_covering_color 	( .8, .3, .1, .3 );
   # endif
@@ -660,44 +800,65 @@ void gl::GeodesicsDrawable::gl_draw_wavefront( const shading_t shading )
   rgba_color_t edge_color           ( 1, .5, 1, .6 );
   rgba_color_t fill_color           ( 1, .5, 1, .1 );
   rgba_color_t source_color         ( 1., 1. ,.0, 1. );
+
+  m_wavefront.clear();
+  m_event_points.clear();
+  m_top_event_points.clear();
+  m_crossing_indicators.clear();
+  m_colinear_indicators.clear();
+
+  // the queue searches its top on every call
+  EventPoint* const top = queue.empty() ? 0 : queue.top();
   
   auto draw_win     = [&] ( const Window& win )  
-                      { this->gl_draw_window( win, edge_color, fill_color, source_color, shading ); };
+                      { this->tessellate_window( win, edge_color, fill_color, source_color, shading, false, m_wavefront ); };
   auto draw_top_win = [&] ( const Window& win )  
-                      { this->gl_draw_window_sequence( win, top_edge_color, top_covering_color, source_color, shading ); };
+                      { this->tessellate_window_sequence( win, top_edge_color, top_covering_color, source_color, shading, m_wavefront ); };
 
   # if defined FLAT_MMP_MAINTAIN_WAVEFRONT
   auto draw_colin_win = [&] ( const Window& win ) 
-                        { this->gl_draw_window_sequence( win, colin_edge_color, colin_covering_color, source_color, shading ); };
+                        { this->tessellate_window_sequence( win, colin_edge_color, colin_covering_color, source_color, shading, m_wavefront ); };
   
   auto draw_cross_win = [&] ( const Window& win ) 
-                        { this->gl_draw_window_sequence( win, cross_edge_color, cross_covering_color, source_color, shading ); };
+                        { this->tessellate_window_sequence( win, cross_edge_color, cross_covering_color, source_color, shading, m_wavefront ); };
   # endif
 
-  //glDisable( GL_DEPTH_TEST );
-
   std::for_each( queue.rbegin(), queue.rend()
                , [&] ( EventPoint* ev ) 
                  { 
                    if( ev->flags() & EventPoint::FRONTIER )
                    {
-					 gl_draw_wavefront_indicators( ev, cross_indicator_color, colin_indicator_color );
+					 tessellate_wavefront_indicators( ev );
 					 
-                     if( ev == queue.top() ) 
+                     if( ev == top ) 
                        draw_top_win( *ev->window() );
                      # if defined FLAT_MMP_MAINTAIN_WAVEFRONT
-					 else if( ev == queue.top()->colinear<LEFT>() || ev == queue.top()->colinear<RIGHT>() )
+					 else if( ev == top->colinear<LEFT>() || ev == top->colinear<RIGHT>() )
 					   draw_colin_win( *ev->window() );
-					 else if( ev == queue.top()->adjacent<LEFT>() || ev == queue.top()->adjacent<RIGHT>() )
+					 else if( ev == top->adjacent<LEFT>() || ev == top->adjacent<RIGHT>() )
 					   draw_cross_win( *ev->window() );
 					 # endif
                      else 
                        draw_win( *ev->window() );
 				   }
-                   gl_draw_event_point( ev ); 
+                   tessellate_event_point( ev, top ); 
                  } 
                );
-  //glEnable( GL_DEPTH_TEST );
+
+  const distance_t top_distance = top ? top->distance() : 0.;
+  const GLsizei    stride       = VERTEX_FLOATS * sizeof( GLfloat );
+
+  gl_draw_vertices( m_wavefront.triangles.data(), stride, m_wavefront.triangles.size() / VERTEX_FLOATS, GL_TRIANGLES, shading, true, top_distance );
+
+  glLineWidth( 2. );
+  gl_draw_vertices( m_crossing_indicators.data(), stride, m_crossing_indicators.size() / VERTEX_FLOATS, GL_LINES, FLAT_SHADING, false, top_distance );
+  glLineWidth( 3. );
+  gl_draw_vertices( m_colinear_indicators.data(), stride, m_colinear_indicators.size() / VERTEX_FLOATS, GL_LINES, FLAT_SHADING, false, top_distance );
+
+  glPointSize( 5. );
+  gl_draw_vertices( m_top_event_points.data(), stride, m_top_event_points.size() / VERTEX_FLOATS, GL_POINTS, FLAT_SHADING, false, top_distance );
+  glPointSize( 3. );
+  gl_draw_vertices( m_event_points.data(), stride, m_event_points.size() / VERTEX_FLOATS, GL_POINTS, FLAT_SHADING, false, top_distance );
 }
 
 
@@ -710,13 +871,28 @@ void gl::GeodesicsDrawable::gl_draw()
 	m_gl_initialized = true;
   }
   
-  if( get_covering_visibility() )
+  if( get_distance_field_visibility() )
+    gl_draw_distance_field();
+  else if( get_covering_visibility() )
     gl_draw_covering( TEXTURE_DISTANCE_SHADING );
   
   if( get_events_visibility() ) 
     gl_draw_wavefront( FLAT_SHADING );
-
-  //glDeleteTextures( 1, &m_equidist_texture );
 }
 
+void gl::GeodesicsDrawable::gl_release()
+{
+  if( m_gl_initialized ) glDeleteTextures( 1, &m_equidist_texture );
+  m_gl_initialized = false;
+
+  if( m_distance_texture ) glDeleteTextures( 1, &m_distance_texture );
+  m_distance_texture       = 0;
+  m_distance_texture_valid = false;
 
+  // the cached windows are uploaded again from client memory
+  m_covering_triangles.gl_release();
+  m_covering_lines.gl_release();
+  m_covering_sidelobe_lines.gl_release();
+
+  ::gl::Drawable::gl_release();
+}
@@ -20,15 +20,19 @@
 # include "drawable.h"
 
 # include "mmp-geodesics.h"
+# include "mmp-distance-field.h"
 
 # include "surface-drawable.h"
 # include "gl-view.h"
+# include "vertex-pool.h"
 
 # include <utk/geometry.h>
 
 # include <gtkmm/window.h>
 
 # include <fstream>
+# include <memory>
+# include <unordered_map>
 
 /* For testing propose use the local (not installed) glade file */
 /* #define GTK_MMP_OBSERVER_BUILDER_FILE PACKAGE_DATA_DIR"/gtk_flatdoc/glade/mmp-propagation-observer.ui" */
@@ -50,6 +54,38 @@ namespace gl
 				   , ABSOLUTE_DISTANCE_SHADING
 				   , TEXTURE_DISTANCE_SHADING	}   shading_t;
         
+	private: // types
+
+      // interleaved position, normal, rgba color and source distance of every vertex
+      enum { VERTEX_FLOATS = 11 };
+
+      typedef std::vector< GLfloat >    vertices_t;
+
+      struct geometry_t
+      {
+        vertices_t  triangles;
+        vertices_t  lines;
+        // edges of inner sidelobes are drawn wider
+        vertices_t  sidelobe_lines;
+
+        void    clear()     { triangles.clear(); lines.clear(); sidelobe_lines.clear(); }
+      };
+
+      // tessellation of a window of the covering - redone if another window took its address or if it or
+      // its predeccessor were trimmed, the backtrace of a pseudosource window ends at the predeccessor bounds
+      struct covering_entry
+      {
+        size_t      id;
+        coord_t     bounds[2];
+        coord_t     pre_bounds[2];
+        // update the window was last seen in
+        size_t      pass;
+
+        ::gl::VertexPool::slot  triangles;
+        ::gl::VertexPool::slot  lines;
+        ::gl::VertexPool::slot  sidelobe_lines;
+      };
+
 	private: // data members
 
 	  Geodesics* m_geodesics;
@@ -61,75 +97,114 @@ namespace gl
 
 	  bool m_gl_initialized;
 
+      // the covering windows in one pool of triangles and two of edge lines
+      std::unordered_map< const Window*, covering_entry >   m_covering;
+      ::gl::VertexPool  m_covering_triangles;
+      ::gl::VertexPool  m_covering_lines;
+      ::gl::VertexPool  m_covering_sidelobe_lines;
+      size_t            m_covering_pass;
+      shading_t         m_covering_shading;
+      // absolute distance shading of the cached windows depends on it
+      distance_t        m_covering_max_distance;
+
+      // the wavefront changes with every step and is tessellated anew for every frame
+      geometry_t        m_wavefront;
+      vertices_t        m_event_points;
+      vertices_t        m_top_event_points;
+      vertices_t        m_crossing_indicators;
+      vertices_t        m_colinear_indicators;
+
+      // the distance field mode draws the surface faces once with the sampled distances as texture
+      // - resampled if windows were created or events processed since the last sample
+      bool              m_distance_field_visible;
+      size_t            m_distance_field_size;
+      distance_t        m_isoline_spacing;
+      std::unique_ptr< DistanceField >  m_distance_field;
+      GLuint            m_distance_texture;
+      size_t            m_distance_field_windows;
+      size_t            m_distance_field_events;
+      bool              m_distance_texture_valid;
+      // position and texture coordinate of the three vertices of every face
+      vertices_t        m_field_vertices;
+
 	private: // functions
 
 	  void gl_init_textures();
-		
-	  void gl_draw_wavefront_indicators( EventPoint* 	 ev
-                                       , rgba_color_ref_t crossing_color
-                                       , rgba_color_ref_t colinear_color 
-                                       );
-
-      void gl_draw_window_edges( const Window& window, const Window::types& window_type
-                               , const location_t& win_left, const location_t& win_right
-                               , const location_t& pre_left, const location_t& pre_right 
-                               , const rgba_color_ref_t edge_color
-                               , const rgba_color_ref_t source_edge_color );
-
-      bool gl_draw_window( const Window&          window
-                         , const rgba_color_ref_t edge_color
-                         , const rgba_color_ref_t fill_color
-                         , const rgba_color_ref_t source_color 
-                         , const shading_t        shading );
-      
-      bool gl_draw_window_subdivision( const Window& window
+
+      static void add_vertex( vertices_t& vertices, const location_ref_t position, const location_ref_t normal
+                            , const rgba_color_ref_t color, const distance_t distance );
+
+	  void tessellate_wavefront_indicators( EventPoint* ev );
+
+      void tessellate_window_edges( const Window& window, const Window::types& window_type
+                                  , const location_t& win_left, const location_t& win_right
+                                  , const location_t& pre_left, const location_t& pre_right 
+                                  , const rgba_color_ref_t edge_color
+                                  , const rgba_color_ref_t source_edge_color
+                                  , geometry_t& geometry );
+
+      // the window as one interval, or subdivided along the distance function with its edges
+      // - returns false if the window has no predeccessor to draw or ends the sequence
+      bool tessellate_window( const Window&          window
+                            , const rgba_color_ref_t edge_color
+                            , const rgba_color_ref_t fill_color
+                            , const rgba_color_ref_t source_color 
+                            , const shading_t        shading
+                            , const bool             subdivision
+                            , geometry_t&            geometry );
+
+      void tessellate_subdivision( const Window&           window
+                                 , const Window::types     window_type
+                                 , const distance_t        recursion_threshold
+                                 , const rgba_color_ref_t  fill_color
+                                 , const rgba_color_ref_t  source_color
+                                 , const shading_t         shading
+                                 , const location_ref_t    normal
+                                 , const std::pair< const coord_t&   , const coord_t&    >& bounds
+                                 , const std::pair< const distance_t&, const distance_t& >& win_distances
+                                 , const std::pair< const distance_t&, const distance_t& >& pre_distances
+                                 , const std::pair< const location_t&, const location_t& >& win_points
+                                 , const std::pair< const location_t&, const location_t& >& pre_points
+                                 , const ps_t& ps
+                                 , const ps_t& pre_ps
+                                 , vertices_t& triangles
+                                 );
+
+      void tessellate_interval( const Window::types       window_type
+                              , const rgba_color_ref_t    fill_color
+                              , const rgba_color_ref_t    source_color
+                              , const shading_t           shading
+                              , const location_ref_t      normal
+                              , const std::pair< const distance_t&, const distance_t& >& win_distances
+                              , const std::pair< const distance_t&, const distance_t& >& pre_distances
+                              , const std::pair< const location_t&, const location_t& >& win_points
+                              , const std::pair< const location_t&, const location_t& >& pre_points
+                              , vertices_t& triangles );
+
+      void tessellate_event_point( EventPoint* ev, const EventPoint* top_event );
+
+      void tessellate_window_sequence( const Window& window
                                      , const rgba_color_ref_t edge_color
                                      , const rgba_color_ref_t fill_color
-                                     , const rgba_color_ref_t source_color 
-                                     , const shading_t shading
-                                     );
-
-      void gl_do_draw_subdivision( const Window&           window
-                                      , const Window::types     window_type
-                                      , const distance_t        recursion_threshold
-                                      , const rgba_color_ref_t  edge_color
-                                      , const rgba_color_ref_t  fill_color
-                                      , const rgba_color_ref_t  source_color
-                                      , const shading_t         shading
-                                      , const location_ref_t    normal
-                                      , const std::pair< const coord_t&   , const coord_t&    >& bounds
-                                      , const std::pair< const distance_t&, const distance_t& >& win_distances
-                                      , const std::pair< const distance_t&, const distance_t& >& pre_distances
-                                      , const std::pair< const location_t&, const location_t& >& win_points
-                                      , const std::pair< const location_t&, const location_t& >& pre_points
-                                      , const ps_t& ps
-                                      , const ps_t& pre_ps
-                                      );
-
-      void gl_draw_interval( const Window&             window
-                           , const Window::types       window_type
-                           , const rgba_color_ref_t    edge_color
-                           , const rgba_color_ref_t    fill_color
-                           , const rgba_color_ref_t    source_color
-                           , const shading_t           shading
-                           , const location_ref_t      normal
-                           , const std::pair< const distance_t&, const distance_t& >& win_distances
-                           , const std::pair< const distance_t&, const distance_t& >& pre_distances
-                           , const std::pair< const location_t&, const location_t& >& win_points
-                           , const std::pair< const location_t&, const location_t& >& pre_points );
+                                     , const rgba_color_ref_t source_color
+                                     , const shading_t         shading
+                                     , geometry_t&             geometry );
 
-      
-      void gl_draw_event_point( EventPoint* ev );
+      // tessellates the windows inserted or trimmed since the last update and frees the deleted ones
+      void update_covering( const shading_t shading );
 
-      void  gl_draw_window_sequence( const Window& window
-                                   , const rgba_color_ref_t edge_color
-                                   , const rgba_color_ref_t fill_color
-                                   , const rgba_color_ref_t source_color
-                                   , const shading_t         shading );
+      // draws the vertices at base - textured by the distance below the top event if shading asks for it
+      void gl_draw_vertices( const GLfloat* base, const GLsizei stride, const size_t count, const GLenum mode
+                           , const shading_t shading, const bool lighting, const distance_t top_distance );
 
       void gl_draw_wavefront( const shading_t );
 
       void gl_draw_covering( const shading_t );
+
+      // samples the field if it is out of date and uploads it as texture
+      void update_distance_texture();
+
+      void gl_draw_distance_field();
         
 	public: // functions
         
@@ -138,6 +213,9 @@ namespace gl
 	  virtual ~GeodesicsDrawable() { std::clog << "flat::gl::GeodesicsDrawable::~GeodesicsDrawable\t" << std::endl; }
 		
 	  void gl_draw();
+
+	  // frees the textures and the buffer objects of the covering as well
+	  void gl_release();
 	  
 
       const EventPoint::flags_t&    get_events_visibility() const
@@ -152,6 +230,31 @@ namespace gl
       void set_covering_visibility( const bool& visibility ) 
       { m_covering_visible = visibility; }
 
+      // draws the distance field instead of the covering
+      const bool& get_distance_field_visibility() const
+      { return m_distance_field_visible; }
+
+      void set_distance_field_visibility( const bool& visibility )
+      { m_distance_field_visible = visibility; }
+
+      // texels along both texture coordinates
+      const size_t& get_distance_field_size() const
+      { return m_distance_field_size; }
+
+      void set_distance_field_size( const size_t& size )
+      { m_distance_field_size = size;
+        m_distance_texture_valid = false;
+      }
+
+      // distance between the isolines of the field - none if zero
+      const distance_t& get_isoline_spacing() const
+      { return m_isoline_spacing; }
+
+      void set_isoline_spacing( const distance_t& spacing )
+      { m_isoline_spacing = spacing;
+        m_distance_texture_valid = false;
+      }
+
       Geodesics*  get_geodesics() const   { return m_geodesics; }
   };
 }
@@ -192,6 +295,7 @@ namespace gtk
 
       Gtk::CheckButton*       m_check_result_check;
       Gtk::CheckButton*       m_stop_on_errors_check;
+      Gtk::CheckButton*       m_distance_field_check;
     
       bool m_check_result;
       bool m_stop_on_errors;
@@ -245,6 +349,12 @@ namespace gtk
 
       void on_check_result_check_clicked()     
 	  { m_check_result = m_check_result_check->get_active(); }
+
+      void on_distance_field_check_clicked()
+      { if( !m_geodesics_drawable ) return;
+        m_geodesics_drawable->set_distance_field_visibility( m_distance_field_check->get_active() );
+        m_geodesics_drawable->invalidate();
+      }
       
       virtual void on_hide()  
       { restore_clog(); 
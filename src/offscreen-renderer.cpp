@@ -0,0 +1,177 @@
+//           offscreen-renderer.cpp
+//  Copyright  2011  Peter Urban
+//  <s9peurba@stud.uni-saarland.de>
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+
+# include "offscreen-renderer.h"
+
+# include "gl-tools.h"
+# include "png-writer.h"
+
+# include "utk/log.h"
+
+# include <EGL/egl.h>
+# include <EGL/eglext.h>
+
+# include <algorithm>
+# include <cmath>
+# include <cstring>
+# include <stdexcept>
+
+using namespace gl;
+
+struct OffscreenRenderer::egl_context
+{
+  EGLDisplay    display;
+  EGLSurface    surface;
+  EGLContext    context;
+
+  egl_context() : display( EGL_NO_DISPLAY ), surface( EGL_NO_SURFACE ), context( EGL_NO_CONTEXT )   {   }
+
+  ~egl_context()
+  {
+    if( display == EGL_NO_DISPLAY ) return;
+
+    eglMakeCurrent( display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+    if( context != EGL_NO_CONTEXT ) eglDestroyContext( display, context );
+    if( surface != EGL_NO_SURFACE ) eglDestroySurface( display, surface );
+    eglTerminate( display );
+  }
+};
+
+namespace
+{
+  // the surfaceless platform of mesa needs neither a window system nor a gpu
+  EGLDisplay    get_display()
+  {
+    const char* extensions = eglQueryString( EGL_NO_DISPLAY, EGL_EXTENSIONS );
+
+    if( extensions && std::strstr( extensions, "EGL_MESA_platform_surfaceless" ) )
+    {
+      PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display
+        = reinterpret_cast< PFNEGLGETPLATFORMDISPLAYEXTPROC >( eglGetProcAddress( "eglGetPlatformDisplayEXT" ) );
+
+      if( get_platform_display )
+        return get_platform_display( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, 0 );
+    }
+
+    return eglGetDisplay( EGL_DEFAULT_DISPLAY );
+  }
+}
+
+OffscreenRenderer::OffscreenRenderer( const size_t width, const size_t height )
+: m_egl( new egl_context ), m_width( width ), m_height( height ), m_pixels( 3 * width * height )
+{
+  if( !width || !height )
+    throw std::runtime_error( "offscreen frames need a positive size" );
+
+  m_egl->display = get_display();
+
+  EGLint major, minor;
+  if( m_egl->display == EGL_NO_DISPLAY || !eglInitialize( m_egl->display, &major, &minor ) )
+  { m_egl->display = EGL_NO_DISPLAY;
+    throw std::runtime_error( "no egl display for offscreen rendering" );
+  }
+
+  if( !eglBindAPI( EGL_OPENGL_API ) )
+    throw std::runtime_error( "the egl implementation does not support desktop opengl" );
+
+  // multisampled if available - the pbuffer is resolved when read back
+  EGLint config_attributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT
+                               , EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT
+                               , EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8
+                               , EGL_DEPTH_SIZE, 24
+                               , EGL_SAMPLE_BUFFERS, 1, EGL_SAMPLES, 4
+                               , EGL_NONE };
+  EGLConfig config;
+  EGLint    num_configs = 0;
+
+  if( !eglChooseConfig( m_egl->display, config_attributes, &config, 1, &num_configs ) || !num_configs )
+  {
+    std::fill( config_attributes + 12, config_attributes + 16, EGL_NONE );
+
+    if( !eglChooseConfig( m_egl->display, config_attributes, &config, 1, &num_configs ) || !num_configs )
+      throw std::runtime_error( "no egl configuration for rgb pbuffers with depth" );
+  }
+
+  const EGLint surface_attributes[] = { EGL_WIDTH, EGLint( width ), EGL_HEIGHT, EGLint( height ), EGL_NONE };
+
+  m_egl->surface = eglCreatePbufferSurface( m_egl->display, config, surface_attributes );
+  if( m_egl->surface == EGL_NO_SURFACE )
+    throw std::runtime_error( "can not create an egl pbuffer" );
+
+  m_egl->context = eglCreateContext( m_egl->display, config, EGL_NO_CONTEXT, 0 );
+  if( m_egl->context == EGL_NO_CONTEXT )
+    throw std::runtime_error( "can not create an egl context" );
+
+  make_current();
+
+  UTK_LOG( INFO, "gl::OffscreenRenderer::OffscreenRenderer\t| " << width << 'x' << height << " egl " << major << '.' << minor
+                 << " renderer \"" << glGetString( GL_RENDERER ) << "\" version " << glGetString( GL_VERSION ) );
+
+  gl::InitializeContext();
+  gl::SetupView( width, height );
+  gl::PrintError();
+
+  m_camera.position().z() += 10.;
+}
+
+OffscreenRenderer::~OffscreenRenderer()
+{
+  // the drawables still attached free their gl objects while the context exists
+  if( eglMakeCurrent( m_egl->display, m_egl->surface, m_egl->surface, m_egl->context ) )
+    std::for_each( begin(), end(), []( Drawable* d ) { d->gl_release(); } );
+}
+
+void    OffscreenRenderer::make_current()  const
+{
+  if( !eglMakeCurrent( m_egl->display, m_egl->surface, m_egl->surface, m_egl->context ) )
+    throw std::runtime_error( "can not make the egl context current" );
+}
+
+void    OffscreenRenderer::look_at( const flat::location_t& center, const flat::coord_t radius )
+{
+  // the sphere fits the narrower field of view of gl::SetupView
+  const flat::coord_t half_fov = std::atan( std::tan( 20. * M_PI / 180. ) * std::min( 1., double( m_width ) / m_height ) );
+  const flat::coord_t distance = radius / std::sin( half_fov );
+
+  m_camera = utk::inertial< flat::coord_t >();
+  m_camera.position() = center;
+  m_camera.position().z() += distance;
+}
+
+const std::vector< unsigned char >&    OffscreenRenderer::render()
+{
+  make_current();
+
+  glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+
+  glPushMatrix();
+    gl::InvTrafo( m_camera );
+    // the context lives as long as the renderer, so unchanged drawables are replayed
+    std::for_each( begin(), end(), []( Drawable* d ) { d->gl_render( true ); } );
+  glPopMatrix();
+
+  glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+  glReadPixels( 0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, m_pixels.data() );
+
+  gl::PrintError();
+
+  return m_pixels;
+}
+
+void    OffscreenRenderer::write_png( const std::string& path )    const
+{ flat::write_png( path, m_width, m_height, m_pixels.data(), true ); }
@@ -0,0 +1,88 @@
+/***************************************************************************
+ *            offscreen-renderer.h
+ *
+ *  Copyright  2011  Peter Urban
+ *  <s9peurba@stud.uni-saarland.de>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+# pragma once
+
+# include "common.h"
+
+# include "drawable.h"
+# include "view.h"
+
+# include "utk/inertial.h"
+
+# include <memory>
+# include <string>
+# include <vector>
+
+namespace gl
+{
+  // renders drawables into an egl pbuffer - needs no window system,
+  // with mesa it runs on the surfaceless platform of render farm nodes
+  // - the context is set up like the one of gtk::GLCanvas, so frames look like the interactive view
+  // - all drawables share the context of the renderer and have to be destroyed while it exists
+  class OffscreenRenderer : public flat::View< Drawable >
+  {
+      // egl display, surface and context
+      struct egl_context;
+
+      std::unique_ptr< egl_context >    m_egl;
+
+      const size_t  m_width;
+      const size_t  m_height;
+
+      utk::inertial< flat::coord_t >    m_camera;
+
+      // rgb rows of the last frame, bottom row first
+      std::vector< unsigned char >      m_pixels;
+
+      OffscreenRenderer( const OffscreenRenderer& );
+      OffscreenRenderer&    operator=( const OffscreenRenderer& );
+
+      void  make_current()  const;
+
+    public:
+
+      // throws std::runtime_error if no context can be created
+      OffscreenRenderer( const size_t width, const size_t height );
+
+      ~OffscreenRenderer();
+
+      size_t    width()     const   { return m_width; }
+      size_t    height()    const   { return m_height; }
+
+      utk::inertial< flat::coord_t >&       camera()        { return m_camera; }
+      const utk::inertial< flat::coord_t >& camera() const  { return m_camera; }
+
+      // looks down the z axis onto a sphere around center
+      void  look_at( const flat::location_t& center, const flat::coord_t radius );
+
+      // frames are only drawn on request
+      virtual void  invalidate( Drawable* )     {   }
+
+      // draws all drawables and reads the frame back
+      const std::vector< unsigned char >&   render();
+
+      // writes the last frame
+      void  write_png( const std::string& path )    const;
+  };
+}
@@ -0,0 +1,91 @@
+//           pdm-format.cpp
+//  Copyright  2011  Peter Urban
+//  <s9peurba@stud.uni-saarland.de>
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+
+# include "pdm-format.h"
+
+# include "utk/log.h"
+
+# include <fstream>
+# include <sstream>
+# include <stdexcept>
+
+using namespace flat;
+
+pdm::header   pdm::read_header( const utk::mapped_file& file )
+{
+  // the header is short - parse it with a stream over its first bytes
+  const std::string head( file.begin(), std::min< size_t >( file.size(), 1024 ) );
+  std::istringstream  stream( head );
+
+  header result;
+
+  stream >> result.magic;
+  for( size_t t = 0; t < 5; ++t )
+    stream >> result.tokens[t];
+
+  result.field_size = { std::strtoul( result.tokens[3].c_str(), 0, 10 )
+                      , std::strtoul( result.tokens[2].c_str(), 0, 10 ) };
+
+  // samples start after the end of the header line
+  std::streamoff end_of_tokens = stream.tellg();
+  if( end_of_tokens < 0 ) end_of_tokens = head.size();
+  result.data_offset = next_line( file.begin() + end_of_tokens, file.end() ) - file.begin();
+
+  return result;
+}
+
+void    pdm::write_binary_header( std::ostream& stream, const header& head )
+{
+  stream << binary_magic;
+  for( size_t t = 0; t < 5; ++t )
+    stream << ' ' << head.tokens[t];
+  stream << '\n';
+}
+
+void    pdm::convert_to_binary( const std::string& text_path, const std::string& binary_path )
+{
+  const utk::mapped_file  text( text_path, utk::mapped_file::SEQUENTIAL );
+  const header            head( read_header( text ) );
+
+  if( head.magic != text_magic )
+    throw std::runtime_error( "\"" + text_path + "\" is not a text pdm file" );
+
+  std::ofstream binary( binary_path.c_str(), std::ios::binary );
+  binary.exceptions( std::ofstream::failbit | std::ofstream::badbit );
+
+  write_binary_header( binary, head );
+
+  const char* position = text.begin() + head.data_offset;
+
+  std::vector< float > records;
+  records.reserve( 6 * 4096 );
+
+  for( size_t sample = 0; sample < head.num_samples(); ++sample )
+  {
+    for( size_t value = 0; value < 6; ++value )
+      records.push_back( parse_float( position, text.end() ) );
+    position = next_line( position, text.end() );
+
+    if( records.size() == records.capacity() || sample + 1 == head.num_samples() )
+    { binary.write( reinterpret_cast< const char* >( &records[0] ), records.size() * sizeof( float ) );
+      records.clear();
+    }
+  }
+
+  UTK_LOG( INFO, "flat::pdm::convert_to_binary\t| " << head.num_samples() << " samples from \"" << text_path << "\" written to \"" << binary_path << '\"' );
+}
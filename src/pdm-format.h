@@ -0,0 +1,163 @@
+/***************************************************************************
+ *            pdm-format.h
+ *
+ *  Copyright  2011  Peter Urban
+ *  <s9peurba@stud.uni-saarland.de>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+# pragma once
+
+# include "common.h"
+
+# include "utk/mmap.h"
+
+# include <algorithm>
+# include <cmath>
+# include <cstdlib>
+# include <cstring>
+# include <ostream>
+# include <string>
+
+// PDM range scans
+//
+// text   - "P9 <a> <b> <rows> <columns> <c>" followed by one "x y z r g b" line per sample
+// binary - "P9B <a> <b> <rows> <columns> <c>\n" followed by one record of six native
+//          floats per sample, so sample i starts at data + i * binary_record_size
+
+namespace flat
+{
+  namespace pdm
+  {
+    const char text_magic[]   = "P9";
+    const char binary_magic[] = "P9B";
+
+    const size_t binary_record_size = 6 * sizeof( float );
+
+    struct header
+    {
+      std::string   magic;
+      // the header tokens are written back unchanged on conversion
+      std::string   tokens[5];
+      // columns, rows
+      size_pair     field_size;
+      // offset of the first sample
+      size_t        data_offset;
+
+      bool  is_binary() const   { return magic == binary_magic; }
+
+      size_t    num_samples()   const   { return std::get<0>( field_size ) * std::get<1>( field_size ); }
+
+      // true if a file of file_size bytes holds all binary records
+      // - compared by division as the counts of a corrupt header may overflow the record bytes
+      bool  fits_binary( const size_t file_size ) const
+      { return data_offset <= file_size && num_samples() <= ( file_size - data_offset ) / binary_record_size; }
+    };
+
+    // reads the header - the magic number is not checked
+    header  read_header( const utk::mapped_file& file );
+
+    // writes the header tokens behind the binary magic number
+    void    write_binary_header( std::ostream& stream, const header& head );
+
+    // writes a binary copy of a text pdm file
+    void    convert_to_binary( const std::string& text_path, const std::string& binary_path );
+
+    // start of the line following position
+    inline const char*  next_line( const char* position, const char* end )
+    {
+      const char* newline = static_cast< const char* >( std::memchr( position, '\n', end - position ) );
+      return newline ? newline + 1 : end;
+    }
+
+    // parses a decimal floating point number and advances position behind it
+    // - leading blanks are skipped, the rest of the line is not touched
+    // - anything the fast path does not understand ( nan, inf, hex ) is handed to strtod
+    inline double   parse_float( const char*& position, const char* end )
+    {
+      static const double powers_of_ten[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7
+                                            , 1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+                                            , 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+      const char* p = position;
+
+      while( p != end && ( *p == ' ' || *p == '\t' || *p == '\r' ) ) ++p;
+
+      const char* const start = p;
+
+      bool negative = false;
+      if( p != end && ( *p == '-' || *p == '+' ) ) negative = *p++ == '-';
+
+      unsigned long long mantissa = 0;
+      int   exponent = 0;
+      int   digits   = 0;
+
+      for( ; p != end && *p >= '0' && *p <= '9'; ++p, ++digits )
+        if( mantissa < 100000000000000000ull ) mantissa = mantissa * 10 + ( *p - '0' );
+        else ++exponent;
+
+      if( p != end && *p == '.' )
+        for( ++p; p != end && *p >= '0' && *p <= '9'; ++p, ++digits )
+          if( mantissa < 100000000000000000ull ) { mantissa = mantissa * 10 + ( *p - '0' ); --exponent; }
+
+      if( !digits )
+      { // not a plain decimal - copy the token and let the c library handle it
+        char  token[64];
+        const size_t length = std::min< size_t >( sizeof( token ) - 1, std::find_if( start, end, []( const char c ) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; } ) - start );
+        std::memcpy( token, start, length );
+        token[ length ] = 0;
+
+        char* token_end;
+        const double value = std::strtod( token, &token_end );
+        position = start + ( token_end - token );
+        return value;
+      }
+
+      if( p != end && ( *p == 'e' || *p == 'E' ) )
+      {
+        const char* q = p + 1;
+        bool negative_exponent = false;
+        if( q != end && ( *q == '-' || *q == '+' ) ) negative_exponent = *q++ == '-';
+
+        if( q != end && *q >= '0' && *q <= '9' )
+        {
+          int value = 0;
+          for( ; q != end && *q >= '0' && *q <= '9'; ++q )
+            if( value < 10000 ) value = value * 10 + ( *q - '0' );
+          exponent += negative_exponent ? -value : value;
+          p = q;
+        }
+      }
+
+      position = p;
+
+      double value = double( mantissa );
+
+      if( exponent < 0 )
+        value = -exponent <= 22 ? value / powers_of_ten[ -exponent ] : value * std::pow( 10., exponent );
+      else if( exponent > 0 )
+        value = exponent <= 22 ? value * powers_of_ten[ exponent ] : value * std::pow( 10., exponent );
+
+      return negative ? -value : value;
+    }
+
+    // reads the six values of a binary record
+    inline void read_binary_record( const char* record, float ( &values )[6] )
+    { std::memcpy( values, record, binary_record_size ); }
+  }
+}
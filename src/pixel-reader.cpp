@@ -0,0 +1,118 @@
+//           pixel-reader.cpp
+//  Copyright  2011  Peter Urban
+//  <s9peurba@stud.uni-saarland.de>
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+
+// pixel buffer object entry points of gl 2.1 - must precede the first gl header
+# define GL_GLEXT_PROTOTYPES
+
+# include "pixel-reader.h"
+
+# include <cstdio>
+
+using namespace gl;
+
+namespace
+{
+  // pixel buffer objects are core since gl 2.1
+  bool  has_pixel_buffer_objects()
+  {
+    const char* version = reinterpret_cast< const char* >( glGetString( GL_VERSION ) );
+
+    int major = 0, minor = 0;
+    if( version ) std::sscanf( version, "%d.%d", &major, &minor );
+
+    return major > 2 || ( major == 2 && minor >= 1 );
+  }
+}
+
+PixelReader::PixelReader()
+: m_initialized( false ), m_supported( false ), m_width( 0 ), m_height( 0 ), m_next( 0 ), m_pending( 0 )
+{   }
+
+void    PixelReader::gl_consume_oldest( const consumer& consume )
+{
+  const size_t oldest = ( m_next + NUM_BUFFERS - m_pending ) % NUM_BUFFERS;
+
+  glBindBuffer( GL_PIXEL_PACK_BUFFER, m_buffers[ oldest ] );
+
+  const unsigned char* rgb = static_cast< const unsigned char* >( glMapBuffer( GL_PIXEL_PACK_BUFFER, GL_READ_ONLY ) );
+  if( rgb )
+  { consume( rgb, m_width, m_height );
+    glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+  }
+
+  glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+  --m_pending;
+}
+
+void    PixelReader::gl_read( const size_t width, const size_t height, const consumer& consume )
+{
+  if( !m_initialized )
+  { m_supported = has_pixel_buffer_objects();
+    if( m_supported ) glGenBuffers( NUM_BUFFERS, m_buffers );
+    m_initialized = true;
+  }
+
+  glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+
+  if( !m_supported )
+  { m_pixels.resize( 3 * width * height );
+    glReadPixels( 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, m_pixels.data() );
+    consume( m_pixels.data(), width, height );
+    return;
+  }
+
+  // the pending frames have the old size
+  if( width != m_width || height != m_height )
+  {
+    gl_flush( consume );
+
+    m_width  = width;
+    m_height = height;
+
+    for( size_t b = 0; b < NUM_BUFFERS; ++b )
+    { glBindBuffer( GL_PIXEL_PACK_BUFFER, m_buffers[b] );
+      glBufferData( GL_PIXEL_PACK_BUFFER, 3 * width * height, 0, GL_STREAM_READ );
+    }
+  }
+
+  glBindBuffer( GL_PIXEL_PACK_BUFFER, m_buffers[ m_next ] );
+  glReadPixels( 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, 0 );
+  glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+
+  m_next = ( m_next + 1 ) % NUM_BUFFERS;
+  ++m_pending;
+
+  // the next read reuses the oldest buffer
+  if( m_pending == NUM_BUFFERS )
+    gl_consume_oldest( consume );
+}
+
+void    PixelReader::gl_flush( const consumer& consume )
+{
+  while( m_pending )
+    gl_consume_oldest( consume );
+}
+
+void    PixelReader::gl_release()
+{
+  if( m_initialized && m_supported )
+    glDeleteBuffers( NUM_BUFFERS, m_buffers );
+
+  m_initialized = false;
+  m_width = m_height = m_next = m_pending = 0;
+}
@@ -0,0 +1,80 @@
+/***************************************************************************
+ *            pixel-reader.h
+ *
+ *  Copyright  2011  Peter Urban
+ *  <s9peurba@stud.uni-saarland.de>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+# pragma once
+
+# include "gl-tools.h"
+
+# include <functional>
+# include <vector>
+
+namespace gl
+{
+  // reads rendered frames back as 8 bit rgb rows, bottom row first
+  // - with pixel buffer objects glReadPixels returns at once and a frame is mapped
+  //   when the next one is read, so the transfer overlaps rendering
+  // - without them the pixels are read synchronously
+  // - all calls need the same current context
+  class PixelReader
+  {
+    public:
+
+      typedef std::function< void( const unsigned char* rgb, const size_t width, const size_t height ) >  consumer;
+
+    private:
+
+      enum { NUM_BUFFERS = 2 };
+
+      bool      m_initialized;
+      bool      m_supported;
+      GLuint    m_buffers[ NUM_BUFFERS ];
+
+      size_t    m_width;
+      size_t    m_height;
+
+      // buffer the next frame is read into and number of frames read but not consumed
+      size_t    m_next;
+      size_t    m_pending;
+
+      // used without buffer objects
+      std::vector< unsigned char >  m_pixels;
+
+      void      gl_consume_oldest( const consumer& consume );
+
+      PixelReader( const PixelReader& );
+      PixelReader&  operator=( const PixelReader& );
+
+    public:
+
+      PixelReader();
+
+      // reads the frame of the current read buffer and hands the oldest pending frame to consume
+      void      gl_read( const size_t width, const size_t height, const consumer& consume );
+
+      // hands all pending frames to consume
+      void      gl_flush( const consumer& consume );
+
+      // deletes the buffer objects - pending frames are lost
+      void      gl_release();
+  };
+}
@@ -0,0 +1,133 @@
+//           png-writer.cpp
+//  Copyright  2011  Peter Urban
+//  <s9peurba@stud.uni-saarland.de>
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+
+# include "png-writer.h"
+
+# include <png.h>
+
+# include <cerrno>
+# include <cstdio>
+# include <cstring>
+# include <stdexcept>
+
+using namespace flat;
+
+struct PngWriter::png_state
+{
+  std::string   path;
+  std::FILE*    file;
+  png_structp   png;
+  png_infop     info;
+
+  png_state( const std::string& o_path ) : path( o_path ), file( 0 ), png( 0 ), info( 0 )  {   }
+
+  ~png_state()  { release(); }
+
+  void  release()
+  {
+    if( png ) png_destroy_write_struct( &png, info ? &info : 0 );
+    if( file ) std::fclose( file );
+    png  = 0;
+    info = 0;
+    file = 0;
+  }
+
+  std::runtime_error    error()
+  {
+    release();
+    return std::runtime_error( "can not write png file \"" + path + "\"" );
+  }
+};
+
+PngWriter::PngWriter( const std::string& path, const size_t width, const size_t height )
+: m_png( new png_state( path ) ), m_width( width ), m_height( height ), m_rows( 0 )
+{
+  m_png->file = std::fopen( path.c_str(), "wb" );
+  if( !m_png->file )
+    throw std::runtime_error( "can not open \"" + path + "\" - " + std::strerror( errno ) );
+
+  m_png->png  = png_create_write_struct( PNG_LIBPNG_VER_STRING, 0, 0, 0 );
+  m_png->info = m_png->png ? png_create_info_struct( m_png->png ) : 0;
+
+  // libpng reports errors by jumping back here
+  if( !m_png->info || setjmp( png_jmpbuf( m_png->png ) ) )
+    throw m_png->error();
+
+  png_init_io( m_png->png, m_png->file );
+
+  png_set_IHDR( m_png->png, m_png->info, width, height, 8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT );
+  png_set_compression_level( m_png->png, 1 );
+  png_set_filter( m_png->png, PNG_FILTER_TYPE_BASE, PNG_FILTER_SUB );
+
+  png_write_info( m_png->png, m_png->info );
+}
+
+PngWriter::~PngWriter() {   }
+
+void    PngWriter::write_rows( const unsigned char* rgb, const size_t num_rows, const bool bottom_up )
+{
+  if( !m_png->png )
+    throw std::runtime_error( "png file \"" + m_png->path + "\" is already closed" );
+
+  if( m_rows + num_rows > m_height )
+    throw std::runtime_error( "too many rows for png file \"" + m_png->path + "\"" );
+
+  if( setjmp( png_jmpbuf( m_png->png ) ) )
+    throw m_png->error();
+
+  for( size_t row = 0; row < num_rows; ++row )
+    png_write_row( m_png->png, const_cast< png_bytep >( rgb + 3 * m_width * ( bottom_up ? num_rows - 1 - row : row ) ) );
+
+  m_rows += num_rows;
+}
+
+void    PngWriter::close()
+{
+  if( !m_png->png )
+    throw std::runtime_error( "png file \"" + m_png->path + "\" is already closed" );
+
+  if( m_rows != m_height )
+    throw std::runtime_error( "png file \"" + m_png->path + "\" is missing rows" );
+
+  if( setjmp( png_jmpbuf( m_png->png ) ) )
+    throw m_png->error();
+
+  png_write_end( m_png->png, m_png->info );
+
+  png_destroy_write_struct( &m_png->png, &m_png->info );
+  m_png->png  = 0;
+  m_png->info = 0;
+
+  std::FILE* file = m_png->file;
+  m_png->file = 0;
+
+  if( std::fclose( file ) )
+    throw std::runtime_error( "can not write \"" + m_png->path + "\" - " + std::strerror( errno ) );
+}
+
+void    flat::write_png( const std::string&   path
+                       , const size_t         width
+                       , const size_t         height
+                       , const unsigned char* rgb
+                       , const bool           bottom_up )
+{
+  PngWriter writer( path, width, height );
+
+  writer.write_rows( rgb, height, bottom_up );
+  writer.close();
+}
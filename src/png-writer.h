@@ -0,0 +1,75 @@
+/***************************************************************************
+ *            png-writer.h
+ *
+ *  Copyright  2011  Peter Urban
+ *  <s9peurba@stud.uni-saarland.de>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+# pragma once
+
+# include <cstddef>
+# include <memory>
+# include <string>
+
+namespace flat
+{
+  // writes a png file of 8 bit rgb pixels strip by strip, so images need not fit into memory
+  // - the rows of the image are passed in order, top row first
+  // - throws std::runtime_error if the file can not be written
+  class PngWriter
+  {
+      struct png_state;
+
+      std::unique_ptr< png_state >  m_png;
+
+      const size_t  m_width;
+      const size_t  m_height;
+      size_t        m_rows;
+
+      PngWriter( const PngWriter& );
+      PngWriter&    operator=( const PngWriter& );
+
+    public:
+
+      PngWriter( const std::string& path, const size_t width, const size_t height );
+
+      // an unfinished file is left incomplete
+      ~PngWriter();
+
+      size_t    width()         const   { return m_width; }
+      size_t    height()        const   { return m_height; }
+      size_t    rows_written()  const   { return m_rows; }
+
+      // appends num_rows rows without gaps between them - bottom_up strips are stored last row first
+      void      write_rows( const unsigned char* rgb, const size_t num_rows, const bool bottom_up = false );
+
+      // completes the file after the last row
+      void      close();
+  };
+
+  // writes 8 bit rgb pixels without gaps between the rows to a png file
+  // - bottom_up rows are stored last row first, as read by glReadPixels
+  // - the compression favours speed over size, frames are written per solver step
+  // - throws std::runtime_error if the file can not be written
+  void  write_png( const std::string&   path
+                 , const size_t         width
+                 , const size_t         height
+                 , const unsigned char* rgb
+                 , const bool           bottom_up = false );
+}
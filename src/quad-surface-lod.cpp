@@ -0,0 +1,382 @@
+//           quad-surface-lod.cpp
+//  Copyright  2011  Peter Urban
+//  <s9peurba@stud.uni-saarland.de>
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+
+# include "quad-surface-lod.h"
+
+# include "utk/parallel.h"
+
+# include <algorithm>
+# include <cassert>
+# include <cmath>
+# include <limits>
+
+using namespace flat;
+
+const size_t  QuadSurfaceLOD::NOT_DRAWN;
+
+namespace
+{
+  // the largest level whose stride divides both sides of the patch
+  size_t    max_level( const size_t columns, const size_t rows )
+  {
+    size_t level = 0;
+    while( ( size_t( 2 ) << level ) <= std::min( columns, rows ) && !( columns % ( size_t( 2 ) << level ) ) && !( rows % ( size_t( 2 ) << level ) ) )
+      ++level;
+    return level;
+  }
+}
+
+QuadSurfaceLOD::QuadSurfaceLOD( const size_pair& vertices_size, const size_t patch_cells )
+: m_vertices_size( vertices_size ), m_patch_cells( patch_cells ), m_patches_size( 0, 0 )
+, m_generation( 0 ), m_next_update( 0 ), m_dirty_patches( 0 ), m_triangles_valid( false ), m_lines_valid( false )
+{
+  assert( patch_cells );
+
+  if( vertices_size.first < 2 || vertices_size.second < 2 ) return;
+
+  const size_t cells[] = { vertices_size.first - 1, vertices_size.second - 1 };
+
+  m_patches_size = size_pair( ( cells[0] + patch_cells - 1 ) / patch_cells, ( cells[1] + patch_cells - 1 ) / patch_cells );
+
+  m_patches.resize( m_patches_size.first * m_patches_size.second );
+
+  for( size_t py = 0; py < m_patches_size.second; ++py )
+    for( size_t px = 0; px < m_patches_size.first; ++px )
+    {
+      patch& p = m_patches[ py * m_patches_size.first + px ];
+
+      p.column  = px * patch_cells;
+      p.row     = py * patch_cells;
+      p.columns = std::min( patch_cells, cells[0] - p.column );
+      p.rows    = std::min( patch_cells, cells[1] - p.row );
+      p.max_level  = max_level( p.columns, p.rows );
+      p.radius     = 0;
+      p.generation = 0;
+      p.level      = NOT_DRAWN;
+      std::fill( p.border_strides, p.border_strides + 4, 0 );
+      std::fill( p.triangles_key, p.triangles_key + 5, NOT_DRAWN );
+      p.lines_level = NOT_DRAWN;
+    }
+
+  m_dirty_patches = m_patches.size();
+}
+
+void    QuadSurfaceLOD::update_patch( patch& p, const std::vector< location_t >& locations, const size_t generation )  const
+{
+  location_t min(  std::numeric_limits< coord_t >::max() );
+  location_t max( -std::numeric_limits< coord_t >::max() );
+
+  for( size_t j = 0; j <= p.rows; ++j )
+    for( size_t i = 0; i <= p.columns; ++i )
+    {
+      const location_t& location = locations[ vertex_index( p.column + i, p.row + j ) ];
+      for( size_t d = 0; d < 3; ++d )
+      { min[d] = std::min( min[d], location[d] );
+        max[d] = std::max( max[d], location[d] );
+      }
+    }
+
+  p.center = ( min + max ) / coord_t( 2 );
+  p.radius = utk::length( max - min ) / 2;
+
+  // the skipped vertices are compared to the bilinear interpolation of their coarse cell
+  p.errors.assign( p.max_level + 1, 0 );
+
+  for( size_t level = 1; level <= p.max_level; ++level )
+  {
+    const size_t stride = size_t( 1 ) << level;
+    coord_t error = p.errors[ level - 1 ];
+
+    for( size_t j = 0; j <= p.rows; ++j )
+      for( size_t i = 0; i <= p.columns; ++i )
+      {
+        if( !( i % stride ) && !( j % stride ) ) continue;
+
+        // vertices on the last grid line belong to the cell before it
+        const size_t ci = std::min( i / stride * stride, p.columns - stride );
+        const size_t cj = std::min( j / stride * stride, p.rows - stride );
+        const coord_t u = coord_t( i - ci ) / stride;
+        const coord_t v = coord_t( j - cj ) / stride;
+
+        const location_t& a = locations[ vertex_index( p.column + ci         , p.row + cj ) ];
+        const location_t& b = locations[ vertex_index( p.column + ci + stride, p.row + cj ) ];
+        const location_t& c = locations[ vertex_index( p.column + ci         , p.row + cj + stride ) ];
+        const location_t& d = locations[ vertex_index( p.column + ci + stride, p.row + cj + stride ) ];
+
+        const location_t interpolated = ( a * ( 1 - u ) + b * u ) * ( 1 - v ) + ( c * ( 1 - u ) + d * u ) * v;
+
+        error = std::max( error, utk::length( locations[ vertex_index( p.column + i, p.row + j ) ] - interpolated ) );
+      }
+
+    p.errors[ level ] = error;
+  }
+
+  p.generation = generation;
+}
+
+void    QuadSurfaceLOD::update( const std::vector< location_t >& locations, const size_t generation, const size_t max_vertices )
+{
+  assert( locations.size() == m_vertices_size.first * m_vertices_size.second );
+
+  m_generation = generation;
+
+  if( m_patches.empty() ) return;
+
+  // patches without errors are always updated, the others in turns
+  std::vector< size_t > pending;
+  size_t vertices = 0;
+
+  for( size_t k = 0; k < m_patches.size(); ++k )
+  {
+    const size_t index = ( m_next_update + k ) % m_patches.size();
+    const patch& p = m_patches[ index ];
+
+    if( !is_dirty( p ) ) continue;
+
+    if( !p.errors.empty() && vertices >= max_vertices )
+    { m_next_update = index;
+      break;
+    }
+
+    pending.push_back( index );
+    vertices += ( p.columns + 1 ) * ( p.rows + 1 );
+  }
+
+  utk::parallel_for( 0, pending.size(), [&]( const size_t begin, const size_t end )
+  {
+    for( size_t k = begin; k < end; ++k )
+      update_patch( m_patches[ pending[k] ], locations, generation );
+  }, 1 );
+
+  m_dirty_patches = std::count_if( m_patches.begin(), m_patches.end(), [this]( const patch& p ) { return is_dirty( p ); } );
+}
+
+bool    QuadSurfaceLOD::select( const view_type& view, const coord_t tolerance )
+{
+  const double* m = view.modelview;
+  const double* proj = view.projection;
+
+  // clip = projection * modelview
+  double clip[16];
+  for( size_t c = 0; c < 4; ++c )
+    for( size_t r = 0; r < 4; ++r )
+      clip[ c * 4 + r ] = proj[r] * m[ c * 4 ] + proj[ 4 + r ] * m[ c * 4 + 1 ] + proj[ 8 + r ] * m[ c * 4 + 2 ] + proj[ 12 + r ] * m[ c * 4 + 3 ];
+
+  // frustum planes from the rows of the clip matrix - normals point inwards
+  double planes[6][4];
+  for( size_t k = 0; k < 3; ++k )
+    for( size_t i = 0; i < 4; ++i )
+    { planes[ 2 * k     ][i] = clip[ i * 4 + 3 ] + clip[ i * 4 + k ];
+      planes[ 2 * k + 1 ][i] = clip[ i * 4 + 3 ] - clip[ i * 4 + k ];
+    }
+
+  for( size_t k = 0; k < 6; ++k )
+  { const double length = std::sqrt( planes[k][0] * planes[k][0] + planes[k][1] * planes[k][1] + planes[k][2] * planes[k][2] );
+    if( length > 0 ) for( size_t i = 0; i < 4; ++i ) planes[k][i] /= length;
+  }
+
+  // object lengths grow by up to the largest column norm of the modelview matrix in eye space
+  double scale = 0;
+  for( size_t c = 0; c < 3; ++c )
+    scale = std::max( scale, std::sqrt( m[ c * 4 ] * m[ c * 4 ] + m[ c * 4 + 1 ] * m[ c * 4 + 1 ] + m[ c * 4 + 2 ] * m[ c * 4 + 2 ] ) );
+
+  // pixels per eye space unit at distance one - perspective projections divide by the distance
+  const double pixels      = proj[5] * view.viewport[3] / 2.;
+  const bool   perspective = proj[15] == 0.;
+
+  bool changed = false;
+
+  for( auto it = m_patches.begin(); it != m_patches.end(); ++it )
+  {
+    patch& current = *it;
+
+    size_t level = 0;
+
+    // patches with outdated bounds are never culled and choose from their previous errors
+    if( !current.errors.empty() )
+    {
+      const location_t& c = current.center;
+
+      bool visible = true;
+      for( size_t k = 0; k < 6 && visible; ++k )
+        visible = planes[k][0] * c[0] + planes[k][1] * c[1] + planes[k][2] * c[2] + planes[k][3] >= - current.radius;
+
+      if( !visible && !is_dirty( current ) )
+      { changed |= current.level != NOT_DRAWN;
+        current.level = NOT_DRAWN;
+        // culled patches give their indices back
+        std::vector< index_type >().swap( current.triangles );
+        std::vector< index_type >().swap( current.lines );
+        std::fill( current.triangles_key, current.triangles_key + 5, NOT_DRAWN );
+        current.lines_level = NOT_DRAWN;
+        continue;
+      }
+
+      double distance = 1.;
+      if( perspective )
+      { const double eye[] = { m[0] * c[0] + m[4] * c[1] + m[8]  * c[2] + m[12]
+                             , m[1] * c[0] + m[5] * c[1] + m[9]  * c[2] + m[13]
+                             , m[2] * c[0] + m[6] * c[1] + m[10] * c[2] + m[14] };
+        distance = std::sqrt( eye[0] * eye[0] + eye[1] * eye[1] + eye[2] * eye[2] ) - current.radius * scale;
+      }
+
+      // patches around the eye keep every vertex
+      if( distance > 0 )
+        while( level < current.max_level && current.errors[ level + 1 ] * scale * pixels / distance <= tolerance )
+          ++level;
+    }
+
+    changed |= current.level != level;
+    current.level = level;
+  }
+
+  for( size_t py = 0; py < m_patches_size.second; ++py )
+    for( size_t px = 0; px < m_patches_size.first; ++px )
+    {
+      patch& p = m_patches[ py * m_patches_size.first + px ];
+
+      if( p.level == NOT_DRAWN ) continue;
+
+      const size_t stride = size_t( 1 ) << p.level;
+
+      // top, right, bottom and left neighbor
+      const patch* neighbors[] = { py ? &m_patches[ ( py - 1 ) * m_patches_size.first + px ] : 0
+                                 , px + 1 < m_patches_size.first ? &m_patches[ py * m_patches_size.first + px + 1 ] : 0
+                                 , py + 1 < m_patches_size.second ? &m_patches[ ( py + 1 ) * m_patches_size.first + px ] : 0
+                                 , px ? &m_patches[ py * m_patches_size.first + px - 1 ] : 0 };
+
+      for( size_t side = 0; side < 4; ++side )
+      {
+        size_t border = stride;
+        if( neighbors[ side ] && neighbors[ side ]->level != NOT_DRAWN )
+          border = std::min( border, size_t( 1 ) << neighbors[ side ]->level );
+
+        changed |= p.border_strides[ side ] != border;
+        p.border_strides[ side ] = border;
+      }
+    }
+
+  if( changed )
+    m_triangles_valid = m_lines_valid = false;
+
+  return changed;
+}
+
+void    QuadSurfaceLOD::build_triangles( patch& p )    const
+{
+  const size_t key[] = { p.level, p.border_strides[0], p.border_strides[1], p.border_strides[2], p.border_strides[3] };
+  if( std::equal( key, key + 5, p.triangles_key ) ) return;
+
+  std::copy( key, key + 5, p.triangles_key );
+  p.triangles.clear();
+
+  const size_t stride = size_t( 1 ) << p.level;
+
+  for( size_t j = 0; j < p.rows; j += stride )
+    for( size_t i = 0; i < p.columns; i += stride )
+    {
+      const size_t x = p.column + i, y = p.row + j;
+
+      const size_t sides[] = { j ? stride : p.border_strides[0]
+                             , i + stride < p.columns ? stride : p.border_strides[1]
+                             , j + stride < p.rows ? stride : p.border_strides[2]
+                             , i ? stride : p.border_strides[3] };
+
+      if( sides[0] == stride && sides[1] == stride && sides[2] == stride && sides[3] == stride )
+      {
+        const index_type corners[] = { vertex_index( x, y ), vertex_index( x + stride, y ), vertex_index( x + stride, y + stride ), vertex_index( x, y + stride ) };
+        const index_type triangles[] = { corners[0], corners[1], corners[2], corners[0], corners[2], corners[3] };
+        p.triangles.insert( p.triangles.end(), triangles, triangles + 6 );
+        continue;
+      }
+
+      // the cell is a fan around its center through the vertices of its sides
+      std::vector< index_type > perimeter;
+      for( size_t k = 0; k < stride; k += sides[0] ) perimeter.push_back( vertex_index( x + k, y ) );
+      for( size_t k = 0; k < stride; k += sides[1] ) perimeter.push_back( vertex_index( x + stride, y + k ) );
+      for( size_t k = 0; k < stride; k += sides[2] ) perimeter.push_back( vertex_index( x + stride - k, y + stride ) );
+      for( size_t k = 0; k < stride; k += sides[3] ) perimeter.push_back( vertex_index( x, y + stride - k ) );
+
+      const index_type center = vertex_index( x + stride / 2, y + stride / 2 );
+
+      for( size_t k = 0; k < perimeter.size(); ++k )
+      { const index_type triangle[] = { center, perimeter[k], perimeter[ ( k + 1 ) % perimeter.size() ] };
+        p.triangles.insert( p.triangles.end(), triangle, triangle + 3 );
+      }
+    }
+}
+
+void    QuadSurfaceLOD::build_lines( patch& p )    const
+{
+  if( p.lines_level == p.level ) return;
+
+  p.lines_level = p.level;
+  p.lines.clear();
+
+  const size_t stride = size_t( 1 ) << p.level;
+
+  for( size_t j = 0; j <= p.rows; j += stride )
+    for( size_t i = 0; i < p.columns; i += stride )
+    { p.lines.push_back( vertex_index( p.column + i, p.row + j ) );
+      p.lines.push_back( vertex_index( p.column + i + stride, p.row + j ) );
+    }
+
+  for( size_t i = 0; i <= p.columns; i += stride )
+    for( size_t j = 0; j < p.rows; j += stride )
+    { p.lines.push_back( vertex_index( p.column + i, p.row + j ) );
+      p.lines.push_back( vertex_index( p.column + i, p.row + j + stride ) );
+    }
+}
+
+const std::vector< QuadSurfaceLOD::index_type >&   QuadSurfaceLOD::triangle_indices()
+{
+  if( m_triangles_valid ) return m_triangle_indices;
+
+  utk::parallel_for( 0, m_patches.size(), [this]( const size_t begin, const size_t end )
+  {
+    for( size_t k = begin; k < end; ++k )
+      if( m_patches[k].level != NOT_DRAWN ) build_triangles( m_patches[k] );
+  }, 16 );
+
+  m_triangle_indices.clear();
+  for( auto it = m_patches.begin(); it != m_patches.end(); ++it )
+    if( it->level != NOT_DRAWN )
+      m_triangle_indices.insert( m_triangle_indices.end(), it->triangles.begin(), it->triangles.end() );
+
+  m_triangles_valid = true;
+  return m_triangle_indices;
+}
+
+const std::vector< QuadSurfaceLOD::index_type >&   QuadSurfaceLOD::line_indices()
+{
+  if( m_lines_valid ) return m_line_indices;
+
+  utk::parallel_for( 0, m_patches.size(), [this]( const size_t begin, const size_t end )
+  {
+    for( size_t k = begin; k < end; ++k )
+      if( m_patches[k].level != NOT_DRAWN ) build_lines( m_patches[k] );
+  }, 16 );
+
+  m_line_indices.clear();
+  for( auto it = m_patches.begin(); it != m_patches.end(); ++it )
+    if( it->level != NOT_DRAWN )
+      m_line_indices.insert( m_line_indices.end(), it->lines.begin(), it->lines.end() );
+
+  m_lines_valid = true;
+  return m_line_indices;
+}
@@ -0,0 +1,134 @@
+/***************************************************************************
+ *            quad-surface-lod.h
+ *
+ *  Copyright  2011  Peter Urban
+ *  <s9peurba@stud.uni-saarland.de>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+# pragma once
+
+# include "common.h"
+
+# include <vector>
+
+namespace flat
+{
+  // level of detail hierarchy of the vertex grid of a QuadSurface
+  // - the grid is split into square patches, level l of a patch keeps every 2^l-th row and column
+  // - every level stores the largest distance of the skipped vertices from the coarser grid,
+  //   a patch is drawn at the coarsest level whose error projects to less than the tolerance in pixels
+  // - patch borders use the finer stride of both patches, the cells along a coarser border are
+  //   drawn as fans around their center vertex, so no cracks open between the patches
+  // - errors and bounds are recomputed for the patches whose locations changed, a limited number
+  //   of vertices per update, so the solver stepping does not stall the drawing
+  class QuadSurfaceLOD
+  {
+    public:
+
+      typedef unsigned int  index_type;
+
+      // the camera the levels are chosen for - matrices column major as returned by glGetDoublev
+      struct view_type
+      {
+        double  modelview[16];
+        double  projection[16];
+        int     viewport[4];
+      };
+
+      static const size_t   NOT_DRAWN = size_t( -1 );
+
+    private:
+
+      struct patch
+      {
+        // first vertex column and row and number of cells
+        size_t  column, row;
+        size_t  columns, rows;
+        size_t  max_level;
+
+        // largest distance of the skipped vertices from the grid of every level
+        std::vector< coord_t >  errors;
+
+        location_t  center;
+        coord_t     radius;
+
+        // location generation the errors were computed from - errors are empty before the first update
+        size_t  generation;
+
+        // selected level and border strides ( top, right, bottom, left ) of the cached indices
+        size_t  level;
+        size_t  border_strides[4];
+
+        std::vector< index_type >   triangles;
+        std::vector< index_type >   lines;
+        size_t  triangles_key[5];
+        size_t  lines_level;
+      };
+
+      size_pair     m_vertices_size;
+      size_t        m_patch_cells;
+      size_pair     m_patches_size;
+
+      std::vector< patch >  m_patches;
+
+      // location generation of the latest update and the next patch an update continues with
+      size_t        m_generation;
+      size_t        m_next_update;
+      size_t        m_dirty_patches;
+
+      bool          m_triangles_valid;
+      bool          m_lines_valid;
+
+      std::vector< index_type > m_triangle_indices;
+      std::vector< index_type > m_line_indices;
+
+      index_type    vertex_index( const size_t column, const size_t row )  const
+      { return index_type( row * m_vertices_size.first + column ); }
+
+      bool  is_dirty( const patch& p )  const   { return p.errors.empty() || p.generation != m_generation; }
+
+      void  update_patch( patch& p, const std::vector< location_t >& locations, const size_t generation )  const;
+
+      void  build_triangles( patch& p )    const;
+      void  build_lines( patch& p )        const;
+
+    public:
+
+      QuadSurfaceLOD( const size_pair& vertices_size, const size_t patch_cells = 64 );
+
+      const size_pair&  vertices_size() const   { return m_vertices_size; }
+
+      size_t    num_patches()   const   { return m_patches.size(); }
+
+      // patches whose errors belong to older locations
+      size_t    dirty_patches() const   { return m_dirty_patches; }
+
+      // recomputes the errors of patches from older generations - beyond the first update at most
+      // max_vertices vertices are visited, the remaining patches follow in later updates
+      void      update( const std::vector< location_t >& locations, const size_t generation, const size_t max_vertices );
+
+      // chooses the level of every patch and culls the patches outside the view frustum
+      // - returns true if the selection differs from the previous one
+      bool      select( const view_type& view, const coord_t tolerance );
+
+      // the selected grids as triangles and as lines between grid neighbors
+      const std::vector< index_type >&  triangle_indices();
+      const std::vector< index_type >&  line_indices();
+  };
+}
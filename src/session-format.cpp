@@ -0,0 +1,266 @@
+//           session-format.cpp
+//  Copyright  2011  Peter Urban
+//  <s9peurba@stud.uni-saarland.de>
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+
+# include "session-format.h"
+
+# include "utk/log.h"
+
+# include <cerrno>
+# include <cstdio>
+# include <cstring>
+# include <fstream>
+# include <stdexcept>
+
+using namespace flat;
+
+namespace
+{
+  typedef enum { NAME = 0, SOLVER, SOURCE, ORIGINAL_LOCATIONS, LOCATIONS, TEXTURE_COORDINATES, FACES, SOLVER_STATE, HISTORY, NUM_SECTIONS } section_type;
+
+  size_t    align( const size_t offset )    { return ( offset + 7 ) & ~size_t( 7 ); }
+
+  std::vector< double > flatten_locations( const std::vector< location_t >& locations )
+  {
+    std::vector< double > result( 3 * locations.size() );
+    for( size_t v = 0; v < locations.size(); ++v )
+      std::copy( locations[v].begin(), locations[v].end(), result.begin() + 3 * v );
+    return result;
+  }
+
+  std::vector< location_t > unflatten_locations( const double* values, const size_t num_vertices )
+  {
+    std::vector< location_t > result( num_vertices );
+    for( size_t v = 0; v < num_vertices; ++v )
+      result[v] = location_t( values[ 3 * v ], values[ 3 * v + 1 ], values[ 3 * v + 2 ] );
+    return result;
+  }
+}
+
+struct session::header
+{
+  char          magic[8];
+  std::uint64_t num_vertices, num_faces;
+  std::uint64_t field_size[2], texture_size[2], texture_stride[2];
+  std::uint64_t iteration;
+  std::uint64_t state_size, history_size;
+  // offset and size in bytes of every section
+  std::uint64_t sections[ NUM_SECTIONS ][2];
+};
+
+session::snapshot::snapshot( const metadata&                  meta
+                            , const Surface&                   surface
+                            , const std::vector< location_t >& original_locations
+                            , const std::vector< double >&     solver_state
+                            , const std::vector< double >&     history )
+: meta( meta ), original_locations( flatten_locations( original_locations ) ), locations( flatten_locations( surface.geometry().locations() ) )
+, texture_coordinates( 2 * surface.num_vertices() )
+, faces( surface.geometry().face_vertices().begin(), surface.geometry().face_vertices().end() )
+, solver_state( solver_state ), history( history )
+{
+  assert( original_locations.size() == surface.num_vertices() );
+  assert( history.size() % 2 == 0 );
+
+  for( size_t v = 0; v < surface.num_vertices(); ++v )
+  { const vertex_texture_coord_t::type& coordinate = surface.vertex( v ).texture_coordinate();
+    texture_coordinates[ 2 * v ]     = coordinate[0];
+    texture_coordinates[ 2 * v + 1 ] = coordinate[1];
+  }
+}
+
+void    session::write( const std::string& path, const snapshot& contents )
+{
+  const metadata& meta = contents.meta;
+
+  const void* data[ NUM_SECTIONS ] = { meta.name.data(), meta.solver.data(), meta.source.data()
+                                     , contents.original_locations.data(), contents.locations.data(), contents.texture_coordinates.data()
+                                     , contents.faces.data(), contents.solver_state.data(), contents.history.data() };
+
+  const size_t sizes[ NUM_SECTIONS ] = { meta.name.size(), meta.solver.size(), meta.source.size()
+                                       , contents.original_locations.size() * sizeof( double ), contents.locations.size() * sizeof( double )
+                                       , contents.texture_coordinates.size() * sizeof( float ), contents.faces.size() * sizeof( std::uint32_t )
+                                       , contents.solver_state.size() * sizeof( double ), contents.history.size() * sizeof( double ) };
+
+  //----| header
+
+  header head;
+  std::memset( &head, 0, sizeof( head ) );
+  std::memcpy( head.magic, magic, sizeof( magic ) );
+
+  head.num_vertices      = contents.locations.size() / 3;
+  head.num_faces         = contents.faces.size() / 3;
+  head.field_size[0]     = std::get<0>( meta.field_size );
+  head.field_size[1]     = std::get<1>( meta.field_size );
+  head.texture_size[0]   = std::get<0>( meta.texture_size );
+  head.texture_size[1]   = std::get<1>( meta.texture_size );
+  head.texture_stride[0] = std::get<0>( meta.texture_stride );
+  head.texture_stride[1] = std::get<1>( meta.texture_stride );
+  head.iteration         = meta.iteration;
+  head.state_size        = contents.solver_state.size();
+  head.history_size      = contents.history.size() / 2;
+
+  size_t offset = align( sizeof( head ) );
+  for( size_t s = 0; s < NUM_SECTIONS; ++s )
+  { head.sections[s][0] = offset;
+    head.sections[s][1] = sizes[s];
+    offset = align( offset + sizes[s] );
+  }
+
+  //----| write and replace
+
+  const std::string temporary( path + ".tmp" );
+  {
+    std::ofstream stream( temporary.c_str(), std::ios::binary | std::ios::trunc );
+    stream.exceptions( std::ofstream::failbit | std::ofstream::badbit );
+
+    const char padding[8] = { 0 };
+
+    stream.write( reinterpret_cast< const char* >( &head ), sizeof( head ) );
+    size_t position = sizeof( head );
+
+    for( size_t s = 0; s < NUM_SECTIONS; ++s )
+    {
+      stream.write( padding, head.sections[s][0] - position );
+      stream.write( static_cast< const char* >( data[s] ), sizes[s] );
+      position = head.sections[s][0] + sizes[s];
+    }
+  }
+
+  if( std::rename( temporary.c_str(), path.c_str() ) )
+    throw std::runtime_error( "can not replace \"" + path + "\" - " + std::strerror( errno ) );
+
+  UTK_LOG( INFO, "flat::session::write\t| " << head.num_vertices << " vertices " << head.num_faces << " faces iteration " << meta.iteration << " to \"" << path << '\"' );
+}
+
+void    session::write( const std::string&               path
+                      , const metadata&                  meta
+                      , const Surface&                   surface
+                      , const std::vector< location_t >& original_locations
+                      , const std::vector< double >&     solver_state
+                      , const std::vector< double >&     history )
+{ write( path, snapshot( meta, surface, original_locations, solver_state, history ) ); }
+
+session::file::file( const std::string& path )
+: m_file( path, utk::mapped_file::SEQUENTIAL ), m_header( reinterpret_cast< const header* >( m_file.data() ) )
+{
+  if( m_file.size() < sizeof( header ) || std::memcmp( m_header->magic, magic, sizeof( magic ) ) )
+    throw std::runtime_error( "\"" + path + "\" is no flattening session" );
+
+  // bound the counts by the file size before they are multiplied, a damaged header may hold any value
+  if( num_vertices() > m_file.size() / ( 3 * sizeof( double ) ) || num_faces() > m_file.size() / ( 3 * sizeof( std::uint32_t ) )
+      || state_size() > m_file.size() / sizeof( double )    || history_size() > m_file.size() / ( 2 * sizeof( double ) ) )
+    throw std::runtime_error( "\"" + path + "\" is a truncated or damaged session" );
+
+  const size_t expected[ NUM_SECTIONS ] = { 0, 0, 0
+                                          , 3 * num_vertices() * sizeof( double ), 3 * num_vertices() * sizeof( double )
+                                          , 2 * num_vertices() * sizeof( float ), 3 * num_faces() * sizeof( std::uint32_t )
+                                          , state_size() * sizeof( double ), 2 * history_size() * sizeof( double ) };
+
+  for( size_t s = 0; s < NUM_SECTIONS; ++s )
+  {
+    const std::uint64_t offset = m_header->sections[s][0];
+    const std::uint64_t size   = m_header->sections[s][1];
+
+    if( offset % 8 || offset > m_file.size() || size > m_file.size() - offset || ( s >= ORIGINAL_LOCATIONS && size != expected[s] ) )
+      throw std::runtime_error( "\"" + path + "\" is a truncated or damaged session" );
+  }
+
+  // the triangulator hands the faces to the mesh unchecked
+  const std::uint32_t* const face_vertices = faces();
+  for( size_t i = 0; i < 3 * num_faces(); ++i )
+    if( face_vertices[i] >= num_vertices() )
+      throw std::runtime_error( "\"" + path + "\" has a face with a vertex out of range" );
+
+  m_metadata.name           = std::string( section( NAME ),   m_header->sections[ NAME ][1] );
+  m_metadata.solver         = std::string( section( SOLVER ), m_header->sections[ SOLVER ][1] );
+  m_metadata.source         = std::string( section( SOURCE ), m_header->sections[ SOURCE ][1] );
+  m_metadata.field_size     = { m_header->field_size[0], m_header->field_size[1] };
+  m_metadata.texture_size   = { m_header->texture_size[0], m_header->texture_size[1] };
+  m_metadata.texture_stride = { m_header->texture_stride[0], m_header->texture_stride[1] };
+  m_metadata.iteration      = m_header->iteration;
+
+  UTK_LOG( INFO, "flat::session::file::file\t| " << num_vertices() << " vertices " << num_faces() << " faces iteration " << m_metadata.iteration
+                 << " solver \"" << m_metadata.solver << "\" from \"" << path << '\"' );
+}
+
+const char*     session::file::section( const size_t index )   const   { return m_file.data() + m_header->sections[ index ][0]; }
+
+size_t  session::file::num_vertices()  const   { return m_header->num_vertices; }
+size_t  session::file::num_faces()     const   { return m_header->num_faces; }
+size_t  session::file::state_size()    const   { return m_header->state_size; }
+size_t  session::file::history_size()  const   { return m_header->history_size; }
+
+const double*   session::file::original_locations()  const   { return reinterpret_cast< const double* >( section( ORIGINAL_LOCATIONS ) ); }
+const double*   session::file::locations()           const   { return reinterpret_cast< const double* >( section( LOCATIONS ) ); }
+const float*    session::file::texture_coordinates() const   { return reinterpret_cast< const float* >( section( TEXTURE_COORDINATES ) ); }
+const std::uint32_t*    session::file::faces()       const   { return reinterpret_cast< const std::uint32_t* >( section( FACES ) ); }
+const double*   session::file::solver_state()        const   { return reinterpret_cast< const double* >( section( SOLVER_STATE ) ); }
+const double*   session::file::history()             const   { return reinterpret_cast< const double* >( section( HISTORY ) ); }
+
+void    session::file::restore_locations( Surface& surface )   const
+{
+  assert( surface.num_vertices() == num_vertices() );
+
+  const std::vector< location_t > result( unflatten_locations( locations(), num_vertices() ) );
+  surface.set_locations( result.begin() );
+}
+
+bool    session::file::restore_solver( const std::string& solver_token, Solver& solver )    const
+{
+  if( solver_token != m_metadata.solver )
+  { UTK_LOG( WARNING, "flat::session::file::restore_solver\t| the session was written by solver \"" << m_metadata.solver << "\" - starting \"" << solver_token << "\" without state" );
+    return false;
+  }
+
+  if( state_size() )
+    solver.set_state( solver_state(), state_size() );
+
+  return true;
+}
+
+void    session::Generator::operator() ( const std::shared_ptr< Surface >& surface )
+{
+  assert( surface->num_vertices() == m_session.num_vertices() );
+
+  const std::vector< location_t > original( unflatten_locations( m_session.original_locations(), m_session.num_vertices() ) );
+  surface->set_locations( original.begin() );
+
+  const float* coordinates = m_session.texture_coordinates();
+  for( size_t v = 0; v < m_session.num_vertices(); ++v )
+    surface->vertex( v ).set_texture_coordinate( vertex_texture_coord_t::type( coordinates[ 2 * v ], coordinates[ 2 * v + 1 ] ) );
+
+  // the texture is decoded from the scan on first access
+  if( !m_session.meta().source.empty() && std::get<0>( texture_size() ) && std::get<1>( texture_size() ) )
+  {
+    const std::string       path( m_session.meta().source );
+    const stride_predicate  texture_predicate( m_session.meta().texture_stride );
+
+    surface->texture().set_loader( [path, texture_predicate]( Surface::texture_type& texture )
+    { 
+      try
+      { PdmFileReader< accept_none_predicate, stride_predicate >( path, accept_none_predicate(), texture_predicate ).read_texture( texture ); }
+      catch( const std::exception& error )
+      { UTK_LOG( ERROR, "flat::session::Generator::operator()\t| loading the texture failed - " << error.what() ); }
+    } );
+  }
+}
+
+void    session::Triangulator::operator() ( const std::shared_ptr< Surface >& surface )
+{
+  const std::vector< Surface::vertex_descriptor > triangles( m_session.faces(), m_session.faces() + 3 * m_session.num_faces() );
+  surface->create_faces( triangles );
+}
@@ -0,0 +1,160 @@
+//           session-format.h
+//  Copyright  2011  Peter Urban
+//  <s9peurba@stud.uni-saarland.de>
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+
+# pragma once
+
+# include "common.h"
+
+# include "surface.h"
+# include "solver.h"
+# include "surface-generators.h"
+
+# include "utk/mmap.h"
+
+# include <cstdint>
+# include <string>
+# include <vector>
+
+// flattening sessions
+//
+// a fixed size header followed by 8 byte aligned sections in native byte order
+//
+//   name, solver, source      - strings
+//   original locations        - 3 doubles per vertex, the surface before flattening
+//   locations                 - 3 doubles per vertex, the current result
+//   texture coordinates       - 2 floats per vertex
+//   faces                     - 3 uint32 vertex indices per face
+//   solver state              - doubles as returned by flat::Solver::get_state
+//   history                   - iteration and squared distance error pairs of doubles
+//
+// the sections are read in place from a memory mapping
+
+namespace flat
+{
+  namespace session
+  {
+    const char magic[8] = { 'F', 'L', 'A', 'T', 'S', 'E', 'S', '1' };
+
+    // fixed size part at the start of the file
+    struct header;
+
+    struct metadata
+    {
+      std::string   name;
+      // token of the solver the state belongs to
+      std::string   solver;
+      // pdm file the texture is decoded from - empty if there is none
+      std::string   source;
+      // columns and rows of quad surfaces
+      size_pair     field_size;
+      size_pair     texture_size;
+      size_pair     texture_stride;
+      // solver steps done so far
+      size_t        iteration;
+
+      metadata() : field_size( 0, 0 ), texture_size( 0, 0 ), texture_stride( 1, 1 ), iteration( 0 )   {   }
+    };
+
+    // copy of the section contents - taken on the solver thread, written on any other
+    struct snapshot
+    {
+      metadata                      meta;
+      std::vector< double >         original_locations;
+      std::vector< double >         locations;
+      std::vector< float >          texture_coordinates;
+      std::vector< std::uint32_t >  faces;
+      std::vector< double >         solver_state;
+      std::vector< double >         history;
+
+      snapshot( const metadata&                  meta
+              , const Surface&                   surface
+              , const std::vector< location_t >& original_locations
+              , const std::vector< double >&     solver_state
+              , const std::vector< double >&     history );
+    };
+
+    // writes the session to a temporary file that replaces path when complete,
+    // so an interrupted write never destroys the previous session
+    void    write( const std::string& path, const snapshot& contents );
+
+    void    write( const std::string&               path
+                 , const metadata&                  meta
+                 , const Surface&                   surface
+                 , const std::vector< location_t >& original_locations
+                 , const std::vector< double >&     solver_state
+                 , const std::vector< double >&     history );
+
+    // read only view of a session file
+    class file
+    {
+        const utk::mapped_file  m_file;
+        const header*   m_header;
+        metadata        m_metadata;
+
+        const char*     section( const size_t index )   const;
+
+      public:
+
+        // throws std::runtime_error if the file is no complete session
+        file( const std::string& path );
+
+        const metadata& meta()  const   { return m_metadata; }
+
+        size_t  num_vertices()  const;
+        size_t  num_faces()     const;
+        size_t  state_size()    const;
+        size_t  history_size()  const;
+
+        const double*           original_locations()    const;
+        const double*           locations()             const;
+        const float*            texture_coordinates()   const;
+        const std::uint32_t*    faces()                 const;
+        const double*           solver_state()          const;
+        const double*           history()               const;
+
+        // sets the locations of the session result
+        void    restore_locations( Surface& surface )   const;
+
+        // hands the solver its state if it is the solver the session was written with
+        bool    restore_solver( const std::string& solver_token, Solver& solver )    const;
+    };
+
+    // loads the original locations, texture coordinates and texture of a session
+    struct Generator : public RectlinearFieldGenerator, public TextureGenerator
+    {
+      const file&   m_session;
+
+      Generator( const file& session )
+      : RectlinearFieldGenerator( session.meta().field_size ), TextureGenerator( session.meta().texture_size ), m_session( session )   {   }
+
+      void  operator() ( const std::shared_ptr< Surface >& surface );
+
+      std::string   get_name() const    { return m_session.meta().name; }
+    };
+
+    // rebuilds the faces of a session
+    struct Triangulator
+    {
+      const file&   m_session;
+
+      Triangulator( const file& session ) : m_session( session )   {   }
+
+      void  operator() ( const std::shared_ptr< Surface >& surface );
+    };
+  }
+}
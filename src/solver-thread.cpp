@@ -0,0 +1,146 @@
+//           solver-thread.cpp
+//  Copyright  2011  Peter Urban
+//  <s9peurba@stud.uni-saarland.de>
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+
+# include "solver-thread.h"
+
+# include "utk/log.h"
+
+# include <chrono>
+
+using namespace flat;
+
+SolverThread::SolverThread( Model& model )
+: m_model( model ), m_playing( false ), m_stop( false ), m_stepping( false ), m_requested_steps( 0 ), m_steps( 0 ), m_step_time( 0. )
+, m_snapshot_surface( 0 )
+{
+  m_thread = std::thread( [this]() { run(); } );
+}
+
+SolverThread::~SolverThread()
+{
+  {
+    std::lock_guard< std::mutex > lock( m_mutex );
+    m_stop = true;
+  }
+  m_condition.notify_all();
+  m_thread.join();
+}
+
+void    SolverThread::play()
+{
+  {
+    std::lock_guard< std::mutex > lock( m_mutex );
+    m_playing = true;
+  }
+  m_condition.notify_all();
+}
+
+void    SolverThread::pause()
+{
+  std::lock_guard< std::mutex > lock( m_mutex );
+  m_playing = false;
+  m_requested_steps = 0;
+}
+
+void    SolverThread::step()
+{
+  {
+    std::lock_guard< std::mutex > lock( m_mutex );
+    if( !m_playing ) ++m_requested_steps;
+  }
+  m_condition.notify_all();
+}
+
+bool    SolverThread::is_playing()
+{
+  std::lock_guard< std::mutex > lock( m_mutex );
+  return m_playing;
+}
+
+bool    SolverThread::is_idle()
+{
+  std::lock_guard< std::mutex > lock( m_mutex );
+  return !m_playing && !m_requested_steps && !m_stepping;
+}
+
+std::pair< size_t, double >   SolverThread::statistics()
+{
+  std::lock_guard< std::mutex > lock( m_mutex );
+  return std::make_pair( m_steps, m_step_time );
+}
+
+void    SolverThread::take_snapshot( const size_t step )
+{
+  snapshot& result = m_snapshots.back();
+  const Surface& surface = *m_model.get_surface();
+
+  result.locations = surface.geometry().locations();
+  result.step      = step;
+  result.surface   = &surface;
+  result.topology_generation = surface.topology_generation();
+}
+
+void    SolverThread::run()
+{
+  for( ;; )
+  {
+    {
+      std::unique_lock< std::mutex > lock( m_mutex );
+      m_condition.wait( lock, [this]() { return m_stop || m_playing || m_requested_steps; } );
+
+      if( m_stop ) return;
+      if( !m_playing ) --m_requested_steps;
+      m_stepping = true;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    {
+      std::lock_guard< std::recursive_mutex > lock( m_model_mutex );
+
+      // a new surface is shown as it is while its first step runs
+      if( m_model.get_surface().get() != m_snapshot_surface )
+      { m_snapshot_surface = m_model.get_surface().get();
+        take_snapshot( m_steps );
+        m_snapshots.publish();
+      }
+
+      try
+      { m_model.step();
+      }catch( const std::exception& e )
+      { UTK_LOG( ERROR, "flat::SolverThread::run\t| step " << m_steps << " failed - " << e.what() );
+        std::lock_guard< std::mutex > lock( m_mutex );
+        m_playing = m_stepping = false;
+        m_requested_steps = 0;
+        continue;
+      }
+
+      take_snapshot( m_steps + 1 );
+    }
+    // published without the model lock, so the display thread will likely get it
+    m_snapshots.publish();
+
+    const double seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+    {
+      std::lock_guard< std::mutex > lock( m_mutex );
+      m_step_time = m_steps ? .9 * m_step_time + .1 * seconds : seconds;
+      ++m_steps;
+      m_stepping = false;
+    }
+  }
+}
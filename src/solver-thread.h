@@ -0,0 +1,124 @@
+/***************************************************************************
+ *            solver-thread.h
+ *
+ *  Copyright  2011  Peter Urban
+ *  <s9peurba@stud.uni-saarland.de>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+# pragma once
+
+# include "common.h"
+
+# include "model.h"
+
+# include "utk/triple-buffer.h"
+
+# include <condition_variable>
+# include <mutex>
+# include <thread>
+# include <utility>
+# include <vector>
+
+namespace flat
+{
+  // steps the solver of a model on a thread of its own
+  // - the surface and the solver belong to the thread while a step runs,
+  //   other threads lock model_mutex() to read or change them
+  // - the locations after every step are handed to the display thread through a triple buffer,
+  //   so drawing never waits for a step
+  // - play, pause and step only place a request and return immediately
+  class SolverThread
+  {
+    public:
+
+      struct snapshot
+      {
+        std::vector< location_t > locations;
+        // number of steps done by the thread
+        size_t  step;
+        // surface and topology the locations belong to - drawn only over the same ones
+        const Surface*  surface;
+        size_t  topology_generation;
+
+        snapshot() : step( 0 ), surface( 0 ), topology_generation( 0 )   {   }
+      };
+
+    private:
+
+      Model&    m_model;
+
+      std::recursive_mutex  m_model_mutex;
+
+      std::mutex                m_mutex;
+      std::condition_variable   m_condition;
+      bool      m_playing;
+      bool      m_stop;
+      bool      m_stepping;
+      size_t    m_requested_steps;
+      size_t    m_steps;
+      // running average in seconds
+      double    m_step_time;
+
+      utk::TripleBuffer< snapshot > m_snapshots;
+      // surface of the last snapshot
+      const Surface*    m_snapshot_surface;
+
+      std::thread   m_thread;
+
+      // fills the back buffer - called with the model lock held
+      void  take_snapshot( const size_t step );
+
+      void  run();
+
+      SolverThread( const SolverThread& );
+      SolverThread& operator=( const SolverThread& );
+
+    public:
+
+      SolverThread( Model& model );
+
+      // waits for the running step
+      ~SolverThread();
+
+      // recursive, so a thread holding it may call functions that lock it again
+      std::recursive_mutex& model_mutex()   { return m_model_mutex; }
+
+      void  play();
+      void  pause();
+      // one more step - ignored while playing
+      void  step();
+
+      bool  is_playing();
+
+      // true if no step runs or is requested - the surface then changes only on the calling thread
+      bool  is_idle();
+
+      // number of steps done and the average time they took in seconds
+      std::pair< size_t, double >   statistics();
+
+      //----| display thread
+
+      // returns true if a new snapshot became the latest one
+      bool  consume_snapshot()  { return m_snapshots.consume(); }
+
+      // empty until the first step is done
+      const snapshot&   latest_snapshot()   const   { return m_snapshots.front(); }
+  };
+}
@@ -62,6 +62,12 @@ namespace flat
 		  
 	  const std::shared_ptr< Surface >&	get_surface()	const	{ return m_surface;	}
 
+	  // state beyond the surface locations a run needs to continue - empty for stateless solvers
+	  virtual std::vector< double >	get_state()	const	{ return std::vector< double >(); }
+
+	  // restores a state returned by get_state for the same surface
+	  virtual void	set_state( const double* state, const size_t size )	{	}
+
   };
 
 }
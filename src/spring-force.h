@@ -48,7 +48,7 @@ namespace spring
   struct Spring : public Surface::vertex_pair
   {
     //Surface::vertex_descriptor 	a, b;
-    distance_t	length;
+    solver_distance_t	length;
 
     Spring() = default;
 
@@ -120,6 +120,11 @@ namespace spring
       virtual void    set_surface( std::shared_ptr< Surface > surface )
       { m_surface = surface; }
 
+      // per sample state - first order integrators have none
+      std::vector< double >	get_state()	const	{ return std::vector< double >(); }
+
+      void  set_state( const double* state, const size_t size )	{	}
+
   };
   
   template< size_t Dim >  
@@ -158,6 +163,23 @@ namespace spring
 		m_velocities.resize( surface->num_vertices(), velocity_type( 0 ) );
       }
 
+      // Dim velocity components per sample
+      std::vector< double >	get_state()	const
+      {
+        std::vector< double > state;
+        state.reserve( Dim * m_velocities.size() );
+        for( auto velocity = m_velocities.begin(); velocity != m_velocities.end(); ++velocity )
+          state.insert( state.end(), velocity->begin(), velocity->end() );
+        return state;
+      }
+
+      void  set_state( const double* state, const size_t size )
+      {
+        assert( size == Dim * m_velocities.size() );
+        for( size_t v = 0; v < m_velocities.size(); ++v )
+          std::copy( state + Dim * v, state + Dim * ( v + 1 ), m_velocities[v].begin() );
+      }
+
   };
 
   template< size_t Dim >  
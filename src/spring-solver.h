@@ -56,7 +56,8 @@ namespace spring
 	  integrator_type	m_integrator;
 	  force_type        m_force;
 
-	  mutable distance_t m_max_displacement;
+	  // keyed by the attribute generation of the surface
+	  GenerationCache< distance_t >   m_max_displacement;
 		  
 	  static void	initial_transform( const std::shared_ptr< Surface >& surface )
 	  {
@@ -68,7 +69,7 @@ namespace spring
 		}
 	  }
 		  
-	  void	comp_max_displacement()	const
+	  distance_t	comp_max_displacement()	const
 	  { 
   	    using namespace boost::accumulators;
 	    accumulator_set< coord_t, features< tag::max > > acc;
@@ -81,9 +82,9 @@ namespace spring
                    }
                  );
 		    
-	    m_max_displacement = max( acc );
+	    std::clog << "flat::Solver::comp_max_displacement\t|" << max( acc ) << std::endl;
 
-	    std::clog << "flat::Solver::comp_max_displacement\t|" << m_max_displacement << std::endl;
+	    return max( acc );
 	  }
 		  
     public:  
@@ -101,12 +102,6 @@ namespace spring
         std::clog << "spring::SpringSolver::" << class_name() << std::endl;
 	  }
 
-		
-	  virtual void	prepare_step()
-      { 
-		set_max_displacement();
-		Solver::prepare_step();
-	  }
 
 	  void  update_force() { m_integrator.update_force( m_force ); }
 	  
@@ -115,6 +110,7 @@ namespace spring
 	  void set_surface( const std::shared_ptr< Surface >& surface )
 	  { 
  	    Solver::set_surface( surface );
+	    m_max_displacement.invalidate();
         surface->initial_distances.compute_distances( surface, Surface::distance_function::NEIGHBORS );
 		initial_transform( surface );
 	    m_integrator.set_surface( Solver::get_surface() );
@@ -123,6 +119,15 @@ namespace spring
 	  }
 
 
+	  // the velocities of inertial solvers
+	  std::vector< double >	get_state()	const	{ return m_integrator.get_state(); }
+
+	  void	set_state( const double* state, const size_t size )
+	  { 
+	    m_integrator.set_state( state, size );
+	    update_force();
+	  }
+
       const force_type& force() const	{ return m_force; }
 
       force_type&		force()       	{ return m_force; }
@@ -131,14 +136,11 @@ namespace spring
 
       integrator_type&		 integrator()       { return m_integrator; }
 
-	  void  set_max_displacement( const distance_t displacement = -std::numeric_limits< distance_t >::infinity() ) const
-	  { m_max_displacement = displacement; }
+	  void  set_max_displacement( const distance_t displacement ) const
+	  { m_max_displacement.assign( displacement, get_surface()->attribute_generation() ); }
 		  
-	  const coord_t&	max_displacement() const							
-      { if( m_max_displacement == - std::numeric_limits< distance_t >::infinity() )
-      	  comp_max_displacement();
-        return m_max_displacement;
-	  }
+	  const distance_t&	max_displacement() const							
+      { return m_max_displacement.get( get_surface()->attribute_generation(), [this]() { return comp_max_displacement(); } ); }
   };
 
 }
@@ -22,16 +22,50 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
  */
 
+// buffer object entry points of gl 1.5 - must precede the first gl header
+# define GL_GLEXT_PROTOTYPES
+
 # include "surface-drawable.h"
 
+# include "quad-surface.h"
+
+# include "utk/log.h"
+# include "utk/parallel.h"
+
 # include <gtkmm/box.h>
 
-# include <boost/accumulators/accumulators.hpp>
-# include <boost/accumulators/statistics/min.hpp>
-# include <boost/accumulators/statistics/max.hpp>
+# include <cstdio>
 
 using namespace flat;
 
+namespace
+{
+  // buffer objects are core since gl 1.5 - older implementations draw from client memory
+  bool  has_buffer_objects()
+  {
+    const char* version = reinterpret_cast< const char* >( glGetString( GL_VERSION ) );
+
+    int major = 0, minor = 0;
+    if( version ) std::sscanf( version, "%d.%d", &major, &minor );
+
+    return major > 1 || ( major == 1 && minor >= 5 );
+  }
+
+  // smaller surfaces are drawn at full resolution
+  const size_t  LOD_MIN_VERTICES    = size_t( 1 ) << 16;
+
+  // vertices whose errors are recomputed per frame after the locations changed
+  const size_t  LOD_UPDATE_VERTICES = size_t( 1 ) << 20;
+
+  template< typename T >
+  void  buffer_data( const GLenum target, const GLuint handle, const std::vector< T >& data, const GLenum usage )
+  {
+    glBindBuffer( target, handle );
+    glBufferData( target, data.size() * sizeof( T ), data.data(), usage );
+    glBindBuffer( target, 0 );
+  }
+}
+
 const gl::SurfaceDrawable::mode_t gl::SurfaceDrawable::GAUSSIAN_CURVATURE_VERTEX_MODE = "gaussian curvature";
 const gl::SurfaceDrawable::mode_t gl::SurfaceDrawable::HEIGHT_VERTEX_MODE       = "height";
 const gl::SurfaceDrawable::mode_t gl::SurfaceDrawable::INVISIBLE_VERTEX_MODE    = "invisible";
@@ -70,46 +104,30 @@ void gl::SurfaceDrawable::gl_init_textures()	const
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST ); 
   
-    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, texture.size.first, texture.size.second, 0, GL_RGBA, GL_FLOAT, &texture.pixmap[0] );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, texture.size.first, texture.size.second, 0, GL_RGBA, GL_UNSIGNED_BYTE, texture.pixels() );
 }
 
 void gl::SurfaceDrawable::gl_draw_gaussian_curvature_vertices() const
 {
-  using namespace boost::accumulators;
-  
   // draw position samples with color dependent on the local gaussian curvature
-  accumulator_set< curvature_t, features< tag::min, tag::max > > curv_acc;
-
-  std::vector<rgb_color_t>			colors( get_surface()->num_vertices() );
-  std::vector<rgb_color_t>::iterator 	col_it = colors.begin();
+  // - curvature and extrema are cached by the surface until the next location change
+  const std::vector< curvature_t >&             curvature = get_surface()->gaussian_curvature();
+  const std::pair< curvature_t, curvature_t >&  extrema   = get_surface()->gaussian_curvature_extrema();
 
-  for( auto its = get_surface()->vertex_handles() ; its.first != its.second; its.first++ )
-  { 
-	assert( col_it!=colors.end());
+  get_surface()->set_curvature_extrema( extrema.first, extrema.second );
 
-	// the gaussian curvature at vertex
+  const curvature_t maxmag = std::max( std::fabs( extrema.first ), std::fabs( extrema.second ) );
 
-	const curvature_t	curvature = its.first->is_boundary_vertex() 
-									? 0 : ( 2*M_PI - its.first->total_angle() ) / its.first->one_ring_area() / 3; // use voronoy region???
+  std::vector<rgb_color_t>	colors( curvature.size() );
 
-    curv_acc( curvature );
-
-	std::cout << its.first->descriptor() << " curvature " << curvature << std::endl;
-		
-	*col_it++ = rgb_color_t( curvature < 0 ? - curvature : 0.,
-	                         curvature > 0 ?   curvature : 0., 
-	                         std::fabs( curvature ) 
-	                       );
-  }
+  for( size_t v = 0; v < colors.size(); v++ )
+	colors[v] = rgb_color_t( curvature[v] < 0 ? - curvature[v] : 0.,
+	                         curvature[v] > 0 ?   curvature[v] : 0., 
+	                         std::fabs( curvature[v] ) 
+	                       ) / maxmag;
 	
   //do the drawing 
   glPointSize(get_vertex_size());
-	
-  get_surface()->set_curvature_extrema( min( curv_acc ), max( curv_acc ) );
-
-  const curvature_t maxmag = std::max( std::fabs( min( curv_acc ) ), std::fabs( max( curv_acc ) ) );
-
-  for( auto it = colors.begin(); it != colors.end(); it++ ) std::cout << "color " << (*it /= maxmag) << std::endl;
 	  
   gl_draw_scaled_vertices( colors.begin() );
 }
@@ -124,8 +142,11 @@ bool	gl::SurfaceDrawable::gl_draw_vertices( const mode_t& mode )		const
   
   if( mode == HEIGHT_VERTEX_MODE )
   {
-	const coord_t maxmag = std::max(   get_surface()->max_height(),
-	                                 - get_surface()->min_height() );
+	const std::vector< location_t >& locations = this->locations();
+
+	coord_t maxmag = 0.;
+	for( size_t v = 0; v < locations.size(); ++v )
+	  maxmag = std::max( maxmag, std::fabs( locations[v][2] ) );
 	// draw position samples with color dependent on the samples velocity_t
 
 	glPushMatrix();
@@ -136,9 +157,9 @@ bool	gl::SurfaceDrawable::gl_draw_vertices( const mode_t& mode )		const
     
     glBegin( GL_POINTS );
     
-	for( PointCloud::vertex_descriptor id=0; id < get_surface()->num_vertices(); id++ )
+	for( PointCloud::vertex_descriptor id=0; id < locations.size(); id++ )
 	{ 
-      const location_t& location = get_surface()->vertex( id ).location();
+      const location_t& location = locations[ id ];
       gl::Color( rgb_color_t( fabsf( location[2] ) / maxmag ) );	  
 	  gl::Vertex( location );
 	}
@@ -162,14 +183,19 @@ bool	gl::SurfaceDrawable::gl_draw_vertices( const mode_t& mode )		const
     gl::Scale( get_global_scale() );
 
     glPointSize( get_vertex_size() );
+
+    if( uses_lod() )
+    { gl::Color( col );
+      gl_draw_lod_elements( GL_POINTS );
+      glPopMatrix();
+      return true;
+    }
     
     glBegin( GL_POINTS );
 
     gl::Color( col );
-	for( auto its = get_surface()->vertex_handles(); its.first != its.second; ++its.first )
-	{ const location_t loc = its.first->location();
-	  gl::Vertex( loc );
-	}  
+	for( auto it = locations().begin(); it != locations().end(); ++it )
+	  gl::Vertex( *it );
 
     glEnd();
 
@@ -192,7 +218,7 @@ bool	gl::SurfaceDrawable::gl_draw_vertices( const mode_t& mode )		const
 
 	for( auto its = get_surface()->vertex_handles(); its.first != its.second; ++its.first )
 	{
-      const location_t loc = its.first->location();
+      const location_t loc = locations()[ its.first->descriptor() ];
       const Surface::texture_type& texture = get_surface()->texture();
       const vertex_texture_coord_t::type texcoord = its.first->texture_coordinate();
       
@@ -220,6 +246,16 @@ bool	gl::SurfaceDrawable::gl_draw_edges( const mode_t& mode )    const
   
   if( mode == SOLID_EDGE_MODE )
   {
+    if( uses_lod() )
+    { glPushMatrix();
+      gl::Scale( get_global_scale() );
+      glLineWidth( 1 );
+      gl::Color( rgb_color_t( 0.f ) );
+      gl_draw_lod_elements( GL_LINES );
+      glPopMatrix();
+      return true;
+    }
+
     typedef std::vector< std::pair< Surface::vertex_descriptor, Surface::vertex_descriptor > > edges_t;
 
     edges_t edges( get_surface()->num_full_edges() );
@@ -243,9 +279,10 @@ bool	gl::SurfaceDrawable::gl_draw_edges( const mode_t& mode )    const
       glBegin( GL_LINES );
       {
         gl::Color( col );
+        const std::vector< location_t >& locations = this->locations();
         for( edges_t::iterator it = edges.begin() ; it != edges.end(); ++it )
-        { gl::Vertex( get_surface()->vertex( it->first ).location() );
-          gl::Vertex( get_surface()->vertex( it->second ).location() );
+        { gl::Vertex( locations[ it->first ] );
+          gl::Vertex( locations[ it->second ] );
         }
       } glEnd();
 
@@ -267,52 +304,315 @@ bool    gl::SurfaceDrawable::gl_draw_faces( const mode_t& mode )    const
     }
     gl_draw_textured_faces();
 
-	//glDeleteTextures( 1, & m_gl_texture_handle );
-
     return true; 
   }
   return false;
 }
 
+bool    gl::SurfaceDrawable::gl_update_face_arrays()    const
+{
+  const Surface& surface = *get_surface();
+
+  if( ! m_gl_buffers_initialized )
+  {
+    m_gl_buffers_supported = has_buffer_objects();
+
+    if( m_gl_buffers_supported )
+      glGenBuffers( NUM_BUFFERS, m_gl_buffer_handles );
+
+    m_gl_buffers_initialized = true;
+
+    UTK_LOG( INFO, "gl::SurfaceDrawable::gl_update_face_arrays\t| drawing faces from " 
+                   << ( m_gl_buffers_supported ? "buffer objects" : "client memory" ) );
+  }
+
+  const size_t location_generation = m_snapshot ? m_snapshot->step : surface.location_generation();
+  const size_t topology_generation = m_snapshot ? m_snapshot->topology_generation : surface.topology_generation();
+
+  const bool new_topology  = m_arrays_surface != &surface || m_arrays_topology_generation != topology_generation;
+  const bool new_locations = new_topology || m_arrays_from_snapshot != bool( m_snapshot ) || m_arrays_location_generation != location_generation;
+
+  // the faces of a surface stepped by another thread can not be read
+  if( m_snapshot && new_topology ) return false;
+
+  if( !new_locations ) return true;
+
+  const size_t num_vertices = surface.num_vertices();
+
+  if( new_topology )
+  {
+    const QuadSurface* quad_surface = dynamic_cast< const QuadSurface* >( &surface );
+
+    m_lod.reset( uses_lod() ? new QuadSurfaceLOD( quad_surface->vertices_size() ) : 0 );
+    m_lod_uploaded[0] = m_lod_uploaded[1] = false;
+
+    if( m_lod )
+      UTK_LOG( INFO, "gl::SurfaceDrawable::gl_update_face_arrays\t| " << m_lod->num_patches() << " level of detail patches" );
+
+    const std::vector< Surface::vertex_descriptor >& faces = surface.geometry().face_vertices();
+
+    m_indices.assign( faces.begin(), faces.end() );
+    m_num_indices = m_indices.size();
+
+    m_texture_coordinates.resize( 2 * num_vertices );
+
+    for( size_t v = 0; v < num_vertices; ++v )
+    {
+      const vertex_texture_coord_t::type texture_coordinate = surface.vertex( v ).texture_coordinate();
+      m_texture_coordinates[ 2 * v ]     = texture_coordinate[0];
+      m_texture_coordinates[ 2 * v + 1 ] = texture_coordinate[1];
+    }
+
+    if( m_gl_buffers_supported )
+    {
+      buffer_data( GL_ARRAY_BUFFER, m_gl_buffer_handles[ TEXTURE_COORDINATE_BUFFER ], m_texture_coordinates, GL_STATIC_DRAW );
+      // the selected grids replace the faces
+      if( !m_lod ) buffer_data( GL_ELEMENT_ARRAY_BUFFER, m_gl_buffer_handles[ INDEX_BUFFER ], m_indices, GL_STATIC_DRAW );
+
+      // the buffer objects hold the only copy needed
+      std::vector< GLfloat >().swap( m_texture_coordinates );
+      std::vector< GLuint  >().swap( m_indices );
+    }
+  }
+
+  const std::vector< location_t >& locations = this->locations();
+
+  m_positions.resize( 3 * num_vertices );
+
+  utk::parallel_for( 0, num_vertices, [this, &locations]( const size_t begin, const size_t end )
+  {
+    for( size_t v = begin; v < end; ++v )
+      std::copy( locations[v].begin(), locations[v].end(), m_positions.begin() + 3 * v );
+  } );
+
+  if( m_gl_buffers_supported )
+  {
+    if( new_topology )
+      buffer_data( GL_ARRAY_BUFFER, m_gl_buffer_handles[ POSITION_BUFFER ], m_positions, GL_DYNAMIC_DRAW );
+    else // same size as before - only the contents are replaced
+    { glBindBuffer( GL_ARRAY_BUFFER, m_gl_buffer_handles[ POSITION_BUFFER ] );
+      glBufferSubData( GL_ARRAY_BUFFER, 0, m_positions.size() * sizeof( GLfloat ), m_positions.data() );
+      glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    }
+  }
+
+  ++m_positions_version;
+
+  m_arrays_surface             = &surface;
+  m_arrays_topology_generation = topology_generation;
+  m_arrays_from_snapshot       = m_snapshot;
+  m_arrays_location_generation = location_generation;
+
+  return true;
+}
+
+void    gl::SurfaceDrawable::gl_release()
+{
+  if( m_gl_texture_initialized ) glDeleteTextures( 1, &m_gl_texture_handle );
+  m_gl_texture_initialized = false;
+
+  if( m_gl_buffers_supported ) glDeleteBuffers( NUM_BUFFERS, m_gl_buffer_handles );
+  m_gl_buffers_initialized = m_gl_buffers_supported = false;
+
+  // the arrays and the selected grids are uploaded again
+  m_arrays_surface  = 0;
+  m_lod_uploaded[0] = m_lod_uploaded[1] = false;
+
+  Drawable::gl_release();
+}
+
+bool    gl::SurfaceDrawable::uses_lod()   const
+{
+  return m_lod_tolerance > 0.f && get_surface()->num_vertices() >= LOD_MIN_VERTICES
+      && dynamic_cast< const QuadSurface* >( get_surface().get() );
+}
+
+size_t  gl::SurfaceDrawable::gl_update_lod( const bool lines, const GLvoid*& indices )  const
+{
+  assert( m_lod );
+
+  m_lod->update( locations(), m_positions_version, LOD_UPDATE_VERTICES );
+
+  QuadSurfaceLOD::view_type view;
+  glGetDoublev( GL_MODELVIEW_MATRIX, view.modelview );
+  glGetDoublev( GL_PROJECTION_MATRIX, view.projection );
+  glGetIntegerv( GL_VIEWPORT, view.viewport );
+
+  if( m_lod->select( view, m_lod_tolerance ) )
+    m_lod_uploaded[0] = m_lod_uploaded[1] = false;
+
+  const std::vector< QuadSurfaceLOD::index_type >& selected = lines ? m_lod->line_indices() : m_lod->triangle_indices();
+
+  if( m_gl_buffers_supported && !m_lod_uploaded[ lines ] )
+  { buffer_data( GL_ELEMENT_ARRAY_BUFFER, m_gl_buffer_handles[ lines ? LINE_INDEX_BUFFER : INDEX_BUFFER ], selected, GL_STREAM_DRAW );
+    m_lod_uploaded[ lines ] = true;
+  }
+
+  indices = m_gl_buffers_supported ? 0 : selected.data();
+  return selected.size();
+}
+
+void    gl::SurfaceDrawable::gl_draw_lod_elements( const GLenum mode )  const
+{
+  if( !gl_update_face_arrays() ) return;
+
+  // points are drawn at the ends of the grid lines
+  const GLvoid* indices   = 0;
+  const size_t  num_indices = gl_update_lod( true, indices );
+
+  glEnableClientState( GL_VERTEX_ARRAY );
+
+  if( m_gl_buffers_supported ) glBindBuffer( GL_ARRAY_BUFFER, m_gl_buffer_handles[ POSITION_BUFFER ] );
+  glVertexPointer( 3, GL_FLOAT, 0, m_gl_buffers_supported ? 0 : m_positions.data() );
+
+  if( m_gl_buffers_supported ) glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_gl_buffer_handles[ LINE_INDEX_BUFFER ] );
+  glDrawElements( mode, num_indices, GL_UNSIGNED_INT, indices );
+
+  if( m_gl_buffers_supported )
+  { glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+  }
+
+  glDisableClientState( GL_VERTEX_ARRAY );
+}
+
 void    gl::SurfaceDrawable::gl_draw_textured_faces()   const
 {
-  
+  if( !gl_update_face_arrays() ) return;
+
+  // offsets into the bound buffer objects or pointers to client memory
+  const GLvoid* positions           = m_gl_buffers_supported ? 0 : m_positions.data();
+  const GLvoid* texture_coordinates = m_gl_buffers_supported ? 0 : m_texture_coordinates.data();
+  const GLvoid* indices             = m_gl_buffers_supported ? 0 : m_indices.data();
+
   glPushMatrix();    
 
   Scale( get_global_scale() );
 
+  // the levels are chosen for the scaled surface
+  const size_t num_indices = m_lod ? gl_update_lod( false, indices ) : m_num_indices;
+
   //glEnable( GL_LIGHTING );
 
   glEnable( GL_TEXTURE_2D );
   glBindTexture( GL_TEXTURE_2D, m_gl_texture_handle );
-  
-  for( auto its = get_surface()->face_handles(); its.first != its.second; its.first++ )
-  {
-    const Surface::edge_handle e0 = its.first->edge();
-    const Surface::edge_handle e1 = e0.next();
-    const Surface::edge_handle e2 = e1.next();
-
-    const Surface::vertex_handle v0 = e0.source();
-    const Surface::vertex_handle v1 = e1.source();
-    const Surface::vertex_handle v2 = e2.source();
-
-    const location_t normal = its.first->normal();
-
-    glBegin( GL_TRIANGLES );
-	  gl::Color( rgba_color_t( 1., 1., 1., 1. ) );
-	  gl::Normal( normal );
-      gl::TexCoord2( v0.texture_coordinate() ); gl::Vertex( v0.location() );
-      gl::TexCoord2( v1.texture_coordinate() ); gl::Vertex( v1.location() );
-      gl::TexCoord2( v2.texture_coordinate() ); gl::Vertex( v2.location() );
-    glEnd();
+
+  gl::Color( rgba_color_t( 1., 1., 1., 1. ) );
+
+  glEnableClientState( GL_VERTEX_ARRAY );
+  glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+
+  if( m_gl_buffers_supported ) glBindBuffer( GL_ARRAY_BUFFER, m_gl_buffer_handles[ POSITION_BUFFER ] );
+  glVertexPointer( 3, GL_FLOAT, 0, positions );
+
+  if( m_gl_buffers_supported ) glBindBuffer( GL_ARRAY_BUFFER, m_gl_buffer_handles[ TEXTURE_COORDINATE_BUFFER ] );
+  glTexCoordPointer( 2, GL_FLOAT, 0, texture_coordinates );
+
+  if( m_gl_buffers_supported ) glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_gl_buffer_handles[ INDEX_BUFFER ] );
+  glDrawElements( GL_TRIANGLES, num_indices, GL_UNSIGNED_INT, indices );
+
+  if( m_gl_buffers_supported )
+  { glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
   }
 
+  glDisableClientState( GL_VERTEX_ARRAY );
+  glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+
   glPopMatrix();
 
   glDisable( GL_TEXTURE_2D );
   glDisable( GL_LIGHTING );
 }
 
+flat::SurfacePicker::hit    gl::SurfaceDrawable::pick( const flat::SurfacePicker::ray_type& ray, const coord_t snap )
+{
+  const Surface& surface = *get_surface();
+
+  const size_t location_generation = m_snapshot ? m_snapshot->step : surface.location_generation();
+  const size_t topology_generation = m_snapshot ? m_snapshot->topology_generation : surface.topology_generation();
+
+  const bool new_topology = m_picker_surface != &surface || m_picker_topology_generation != topology_generation;
+
+  // the faces of a surface stepped by another thread can not be read
+  if( m_snapshot && new_topology ) return m_picked;
+
+  const std::vector< location_t >& picked_locations = locations();
+
+  if( new_topology )
+  { m_picker.build( surface.geometry().face_vertices(), picked_locations );
+    m_picker_surface             = &surface;
+    m_picker_topology_generation = topology_generation;
+  }
+  else if( m_picker_from_snapshot != bool( m_snapshot ) || m_picker_location_generation != location_generation )
+    m_picker.refit( picked_locations );
+
+  m_picker_from_snapshot       = m_snapshot;
+  m_picker_location_generation = location_generation;
+
+  // the surface is drawn scaled
+  const location_t& scale = get_global_scale();
+  const location_t  source( ray.source()[0] / scale[0], ray.source()[1] / scale[1], ray.source()[2] / scale[2] );
+  const location_t  target( ray.target()[0] / scale[0], ray.target()[1] / scale[1], ray.target()[2] / scale[2] );
+
+  m_picked = m_picker.pick( picked_locations, flat::SurfacePicker::ray_type( source, target ), snap );
+
+  invalidate();
+
+  return m_picked;
+}
+
+void    gl::SurfaceDrawable::gl_draw_picked()   const
+{
+  typedef flat::SurfacePicker::hit hit;
+
+  if( m_picked.type == hit::NONE ) return;
+
+  const Surface& surface = *get_surface();
+
+  const size_t topology_generation = m_snapshot ? m_snapshot->topology_generation : surface.topology_generation();
+
+  // the surface may have changed since the pick
+  // - the faces are the copy of the picker as the ones of a surface stepped by another thread can not be read
+  if( m_picker_surface != &surface || m_picker_topology_generation != topology_generation ) return;
+
+  const std::vector< location_t >& picked_locations = locations();
+  const std::vector< Surface::vertex_descriptor >& faces = m_picker.face_vertices();
+
+  if( m_picked.face >= faces.size() / 3 ) return;
+
+  glPushMatrix();
+  Scale( get_global_scale() );
+
+  gl::Color( rgb_color_t( 1.f, 0.f, 0.f ) );
+
+  switch( m_picked.type )
+  {
+    case hit::VERTEX:
+      glPointSize( 3 * get_vertex_size() );
+      glBegin( GL_POINTS );
+        gl::Vertex( picked_locations[ m_picked.vertices[0] ] );
+      glEnd();
+      break;
+
+    case hit::EDGE:
+      glLineWidth( 3 );
+      glBegin( GL_LINES );
+        gl::Vertex( picked_locations[ m_picked.vertices[0] ] );
+        gl::Vertex( picked_locations[ m_picked.vertices[1] ] );
+      glEnd();
+      break;
+
+    default:
+      glBegin( GL_TRIANGLES );
+        for( size_t i = 0; i < 3; ++i )
+          gl::Vertex( picked_locations[ faces[ 3 * m_picked.face + i ] ] );
+      glEnd();
+  }
+
+  glPopMatrix();
+}
+
 
 gtk::SurfaceDrawableUI::SurfaceDrawableUI( const std::shared_ptr< gl::SurfaceDrawable >& drawable )
 : UI( get_builder_filename(), "surface_drawable_widget" ), m_drawable( drawable )
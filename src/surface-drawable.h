@@ -25,9 +25,12 @@
 # pragma once
 
 # include "surface.h"
+# include "quad-surface-lod.h"
+# include "surface-picker.h"
 # include "drawable.h"
 # include "interface.h"
 # include "gl-view.h"
+# include "solver-thread.h"
 
 # include <gtkmm/comboboxtext.h>
 # include <gtkmm/spinbutton.h>
@@ -115,6 +118,57 @@ namespace gl
 	  flat::location_t	m_global_scale;
 	  float			m_vertex_size;
 
+	  // vertex arrays of the faces - kept in buffer objects if the gl supports them
+	  // - texture coordinates and indices are uploaded when the surface or its topology changes,
+	  //   the positions whenever the locations change - the faces are not lit, so they have no normals
+	  // - with a level of detail hierarchy the index buffers hold the selected grids and are replaced when the selection changes
+	  enum { POSITION_BUFFER = 0, TEXTURE_COORDINATE_BUFFER, INDEX_BUFFER, LINE_INDEX_BUFFER, NUM_BUFFERS };
+
+	  mutable std::vector< GLfloat >	m_positions;
+	  mutable std::vector< GLfloat >	m_texture_coordinates;
+	  mutable std::vector< GLuint >		m_indices;
+	  mutable size_t	m_num_indices;
+
+	  mutable bool 		m_gl_buffers_initialized;
+	  mutable bool 		m_gl_buffers_supported;
+	  mutable GLuint	m_gl_buffer_handles[ NUM_BUFFERS ];
+
+	  // the surface and generations the arrays were built from - the step replaces the location generation for snapshots
+	  mutable const flat::Surface*	m_arrays_surface;
+	  mutable bool		m_arrays_from_snapshot;
+	  mutable size_t	m_arrays_location_generation;
+	  mutable size_t	m_arrays_topology_generation;
+
+	  // locations published by a solver thread - drawn instead of the surface locations while set
+	  const flat::SolverThread::snapshot*	m_snapshot;
+
+	  // level of detail of large grid surfaces - built with the face arrays
+	  mutable std::unique_ptr< flat::QuadSurfaceLOD >	m_lod;
+	  float				m_lod_tolerance;
+	  // counts the position uploads, so the hierarchy knows when its errors are outdated
+	  mutable size_t	m_positions_version;
+	  // the selected triangles and lines are in their index buffers
+	  mutable bool		m_lod_uploaded[2];
+
+	  // the solid vertices, solid edges and textured faces of large grid surfaces are decimated per view
+	  bool	uses_lod()	const;
+
+	  // selects the levels for the current matrices - returns the number of triangle or line indices
+	  // and sets indices to client memory if there are no buffer objects
+	  size_t	gl_update_lod( const bool lines, const GLvoid*& indices )	const;
+	  void	gl_draw_lod_elements( const GLenum mode )	const;
+
+	  // faces hierarchy for picking - refitted when the picked locations changed
+	  flat::SurfacePicker	m_picker;
+	  const flat::Surface*	m_picker_surface;
+	  bool				m_picker_from_snapshot;
+	  size_t			m_picker_location_generation;
+	  size_t			m_picker_topology_generation;
+
+	  flat::SurfacePicker::hit	m_picked;
+
+	  // returns false if the arrays do not hold the topology of the snapshot drawn - they are not rebuilt then
+	  bool	gl_update_face_arrays() const;
 	  void	gl_init_textures() const;
 	  void  gl_draw_gaussian_curvature_vertices() const;
 	  void  gl_draw_textured_faces()    const;
@@ -131,7 +185,13 @@ namespace gl
 	  , m_face_modes  ( { INVISIBLE_FACE_MODE, SOLID_FACE_MODE, TEXTURE_FACE_MODE } )
 	  , m_gl_texture_initialized( false )
 	  , m_global_scale( 1. ), m_vertex_size( 2. )	
-	  { std::clog << "gl::SurfaceDrawable::SurfaceDrawable" << std::endl; }
+	  , m_num_indices( 0 ), m_gl_buffers_initialized( false ), m_gl_buffers_supported( false )
+	  , m_arrays_surface( 0 ), m_arrays_from_snapshot( false ), m_arrays_location_generation( 0 ), m_arrays_topology_generation( 0 )
+	  , m_snapshot( 0 )
+	  , m_lod_tolerance( 1.f ), m_positions_version( 0 )
+	  , m_picker_surface( 0 ), m_picker_from_snapshot( false ), m_picker_location_generation( 0 ), m_picker_topology_generation( 0 )
+	  { m_lod_uploaded[0] = m_lod_uploaded[1] = false;
+	    std::clog << "gl::SurfaceDrawable::SurfaceDrawable" << std::endl; }
 
 	  virtual ~SurfaceDrawable() { std::clog << "gl::SurfaceDrawable::~SurfaceDrawable" << std::endl; }
 
@@ -141,11 +201,54 @@ namespace gl
 
 	  virtual void    gl_draw_others() const {	};		
 
+	  // frees the texture and the buffer objects of the faces as well
+	  virtual void	gl_release();
+
+	  // marks the vertex, edge or face picked last
+	  void	gl_draw_picked() const;
+
+	  // the surface locations and topology - the decimated grids change with the camera
+	  virtual size_t  data_generation()	const	{ return uses_lod() ? UNKNOWN_GENERATION : get_surface()->attribute_generation(); }
+
+	  // largest projected error of a decimated grid in pixels - 0 draws every vertex
+	  float	get_lod_tolerance()	const	{ return m_lod_tolerance; }
+
+	  void	set_lod_tolerance( const float pixels )
+	  { assert( pixels >= 0.f );
+	    if( pixels == m_lod_tolerance ) return;
+	    m_lod_tolerance = pixels;
+	    // the hierarchy is built or dropped with the face arrays
+	    m_arrays_surface = 0;
+	    invalidate();
+	  }
+
 	  void set_surface( const std::shared_ptr< flat::Surface >& surface )
-	  { m_surface = surface; invalidate(); } 
+	  { m_surface = surface; m_arrays_surface = 0; m_picker_surface = 0; m_picked = flat::SurfacePicker::hit(); invalidate(); } 
+
+	  // picks the primitive of the drawn surface hit first by a ray in view coordinates
+	  // - a vertex or an edge is picked within snap times the distance of the hit from the ray source
+	  virtual flat::SurfacePicker::hit	pick( const flat::SurfacePicker::ray_type& ray, const flat::coord_t snap );
+
+	  const flat::SurfacePicker::hit&	get_picked()	const	{ return m_picked; }
+
+	  void	clear_picked()
+	  { if( m_picked.type == flat::SurfacePicker::hit::NONE ) return;
+	    m_picked = flat::SurfacePicker::hit();
+	    invalidate();
+	  }
 
 	  const std::shared_ptr< const flat::Surface >& get_surface() const { return m_surface; }
 
+	  // the solid, height and texture vertices, solid edges and textured faces are drawn from the snapshot
+	  // until it is reset to null - the snapshot must belong to the surface and hold a location for every vertex,
+	  // faces and grids are only drawn if they were built for its topology before
+	  void set_snapshot( const flat::SolverThread::snapshot* snapshot )
+	  { assert( !snapshot || ( snapshot->surface == get_surface().get() && snapshot->locations.size() == get_surface()->num_vertices() ) );
+	    m_snapshot = snapshot; }
+
+	  const std::vector< flat::location_t >&	locations()	const
+	  { return m_snapshot ? m_snapshot->locations : get_surface()->geometry().locations(); }
+
 	  // specifying gl::Drawable::gl_draw
 	  virtual void gl_draw() 
 	  { 
@@ -163,6 +266,7 @@ namespace gl
 
 	    gl_draw_others();
 
+	    gl_draw_picked();
 	  };
 
 	  // sets the display mode of the surfaces vertices
@@ -243,17 +347,50 @@ namespace gl
 
   class SharedSurfaceDrawable  : public SurfaceDrawable, public flat::View< SurfaceDrawable >
   {
+	  // owns the surface while it steps - null if the surface is never changed concurrently
+	  flat::SolverThread*	m_solver_thread;
+
+	  // the snapshots of a previous surface may have as many vertices
+	  bool	is_snapshot_of_surface( const flat::SolverThread::snapshot& snapshot )	const
+	  { return snapshot.surface == get_surface().get() && snapshot.locations.size() == get_surface()->num_vertices(); }
+
+	  // draws the modes available from the latest snapshot of the solver thread
+	  void	gl_draw_snapshot()
+	  {
+	    const flat::SolverThread::snapshot& snapshot = m_solver_thread->latest_snapshot();
+	    // no step of this surface done yet
+	    if( !is_snapshot_of_surface( snapshot ) ) return;
+
+	    set_snapshot( &snapshot );
+
+	    if( get_vertex_mode() != GAUSSIAN_CURVATURE_VERTEX_MODE ) SurfaceDrawable::gl_draw_vertices( get_vertex_mode() );
+	    SurfaceDrawable::gl_draw_edges( get_edge_mode() );
+	    SurfaceDrawable::gl_draw_faces( get_face_mode() );
+	    gl_draw_picked();
+
+	    set_snapshot( 0 );
+	  }
+
 	public:
 
 	  SharedSurfaceDrawable( const std::shared_ptr< flat::Surface >& surface )
-	  : SurfaceDrawable( surface )	{ std::clog << "gl::SharedSurfaceDrawable::SharedSurfaceDrawable" << std::endl; }
+	  : SurfaceDrawable( surface ), m_solver_thread( 0 )	{ std::clog << "gl::SharedSurfaceDrawable::SharedSurfaceDrawable" << std::endl; }
 
       virtual ~SharedSurfaceDrawable()   { std::clog << "gl::SharedSurfaceDrawable::~SharedSurfaceDrawable" << std::endl; }
       
+	  void	set_solver_thread( flat::SolverThread* solver_thread )	{ m_solver_thread = solver_thread; }
+
 	  //----| Drawable interface
 
 	  void    gl_draw()
 	  { 
+	    // while a step runs only the modes stored in the snapshot can be drawn
+	    std::unique_lock< std::recursive_mutex > lock;
+	    if( m_solver_thread ) 
+	    { lock = std::unique_lock< std::recursive_mutex >( m_solver_thread->model_mutex(), std::try_to_lock );
+	      if( !lock.owns_lock() ) { gl_draw_snapshot(); return; }
+	    }
+
 		# if defined DBG_GL_SHAREDSURFACEDRAWABLE
 	    std::clog << "gl::SharedSurfaceDrawable::gl_draw\t|"
 	   	  		  << " vertex mode = \"" << get_vertex_mode() << "\""
@@ -272,8 +409,43 @@ namespace gl
 
 		  (*it)->gl_draw_others();
 	    }        
+
+	    gl_draw_picked();
 	  } 
 
+	  size_t  data_generation()	const
+	  { // a busy solver thread may change the surface at any time
+	    if( m_solver_thread && !m_solver_thread->is_idle() ) return UNKNOWN_GENERATION;
+	    return SurfaceDrawable::data_generation();
+	  }
+
+	  // picks from the latest snapshot while the solver thread steps the surface
+	  flat::SurfacePicker::hit	pick( const flat::SurfacePicker::ray_type& ray, const flat::coord_t snap )
+	  {
+	    std::unique_lock< std::recursive_mutex > lock;
+	    if( m_solver_thread ) 
+	    { lock = std::unique_lock< std::recursive_mutex >( m_solver_thread->model_mutex(), std::try_to_lock );
+	      if( !lock.owns_lock() ) 
+	      { const flat::SolverThread::snapshot& snapshot = m_solver_thread->latest_snapshot();
+	        if( !is_snapshot_of_surface( snapshot ) ) return get_picked();
+
+	        set_snapshot( &snapshot );
+	        const flat::SurfacePicker::hit picked = SurfaceDrawable::pick( ray, snap );
+	        set_snapshot( 0 );
+	        return picked;
+	      }
+	    }
+
+	    return SurfaceDrawable::pick( ray, snap );
+	  }
+
+	  void	gl_release()
+	  {
+	    for( auto it = flat::View< SurfaceDrawable >::begin(); it != flat::View< SurfaceDrawable >::end(); it++ )
+		  (*it)->gl_release();
+	    SurfaceDrawable::gl_release();
+	  }
+
 	  //----| View interface
 
 	  void    add_drawable( SurfaceDrawable* d )
@@ -281,6 +453,7 @@ namespace gl
 	    std::clog << "flat::SharedSurfaceDrawable::add_drawable" << std::endl << std::flush;
 
 	    flat::View< SurfaceDrawable >::add_drawable( d );
+	    SurfaceDrawable::invalidate();
 
 	    append_vertex_modes( d->get_vertex_mode_list() );
 	    append_edge_modes  ( d->get_edge_mode_list() );
@@ -30,8 +30,8 @@ void    SimpleRectlinearTriangulator::operator() ( const std::shared_ptr< Surfac
 
   assert( m * n == surface->num_vertices() );
   
-  std::clog << "SimpleRectlinearTriangulator()\t|" 
-            << " creating the triangulation of size (" << m << "," << n << ") ..." << std::endl;
+  UTK_LOG( INFO, "SimpleRectlinearTriangulator()\t|" 
+                 << " creating the triangulation of size (" << m << "," << n << ") ..." );
 
   for( Surface::vertex_descriptor descriptor = m + 1 ; descriptor < m*n; ++descriptor )
   {
@@ -48,12 +48,13 @@ void    SimpleRectlinearTriangulator::operator() ( const std::shared_ptr< Surfac
     	        << " quad (" << a << "," << b << "," << c << "," << d << ")" << std::endl;
       # endif
       
+	  // the valence of the grid is at most six, so the per-face edge search beats create_faces here
 	  surface->create_face( a, c, d ); //right face
 	  surface->create_face( a, b, c ); //left face	
     }
   }
   
-  std::clog << "SimpleRectlinearTriangulator()\t|"  << "complete"<<std::endl;	 
+  UTK_LOG( INFO, "SimpleRectlinearTriangulator()\t|"  << "complete" );
 }
 	  
 void RandomHeightGenerator::add_noise( const std::shared_ptr< Surface >& surface, const coord_t amplitude )
@@ -128,8 +129,8 @@ void	CenterRescaleTransform::operator() ( const std::shared_ptr< PointCloud> & c
 		    << "\t|fit-box flags " << rescale_flags
 		    << std::endl;
   
-  location_t  old_min = cloud->min_location();
-  location_t  old_max = cloud->max_location();
+  const location_t  old_min = cloud->min_location();
+  const location_t  old_max = cloud->max_location();
   
   const location_t	extent(	  old_max - old_min        );
   const location_t  mid   ( ( old_max + old_min ) / 2 );
@@ -153,12 +154,5 @@ void	CenterRescaleTransform::operator() ( const std::shared_ptr< PointCloud> & c
     vertex_it.first->set_location( new_location );
   }
 
-  old_min += shift;
-  old_min /= invscale;
-  old_max += shift;
-  old_max /= invscale;
-
-  cloud->set_min_max( old_min, old_max );
-  
   std::clog<< "flat::CenterRescaleTransform" << "\t|complete" << std::endl;
 }
@@ -27,18 +27,19 @@
 # include "common.h"
 
 # include "surface.h"
+# include "pdm-format.h"
 
-# include <boost/lexical_cast.hpp>
+# include "utk/log.h"
+# include "utk/parallel.h"
 
-# include <fstream>
+# include <boost/lexical_cast.hpp>
 
-# include <sstream>
+# include <stdexcept>
 
 //# define DBG_FLAT_SIMPLE_RECTLINEAR_TRIAGULATOR__PER_QUAD
 
 # define DBG_FLAT_PDM_FILE_READER
 //# define DBG_FLAT_PDM_FILE_READER_VERTEX_SAMPLE
-//# define DBG_FLAT_PDM_FILE_READER_TEXTURE_SAMPLE
 
 namespace flat
 {
@@ -224,38 +225,38 @@ namespace flat
       
     private:
 	  
-      typedef enum { VERTEX = 1, TEXTURE = 2, END = 4 }  sample_type_t;
-      typedef int   sample_mask_t;
+      // line aligned part of the file holding a contiguous range of samples
+      struct chunk
+      {
+        const char* begin;
+        const char* end;
+        size_t      first_sample, num_samples;
+        // index of the first vertex and texel the chunk contributes
+        size_t      first_vertex, first_texel;
+      };
 
       std::string   m_filename;
-      std::ifstream m_stream;
+
+      const utk::mapped_file    m_file;
+      // binary files are read by record index, text files line by line
+      bool          m_binary;
+      const char*   m_samples;
 
       mutable VertexPredicate  m_vertex_predicate;
       mutable TexturePredicate m_texture_predicate;
 
-      size_t m_index;
-
       size_pair m_field_size;
 
-	  rgba_color_t                 	texture_color;
-      location_t                    vertex_location;
-      vertex_texture_coord_t::type  vertex_texture_coordinate;
+      size_t    num_samples()   const   { return get<0>( m_field_size ) * get<1>( m_field_size ); }
 
-      sample_mask_t  next_sample();
+      // splits the samples into line aligned chunks - one per thread
+      std::vector< chunk >  split_chunks()  const;
 
-      bool advance_index()  { return ++m_index < ( get<0>(m_field_size) * get<1>(m_field_size) ); }
+      // parses the sample and advances the cursor of text files to the next line
+      void  read_sample( const size_t index, const char*& cursor, location_t& location, rgba_color_t& color )  const;
 
-      bool skip_sample()    
-      { 
-        # if defined DBG_FLAT_PDM_FILE_READER
-        //std::clog << "flat::PdmFileReader()\t| " << " skip sample " << m_index << std::endl;
-        # endif
-          
-        m_stream.ignore( 256, '\n' ); 
-        return advance_index();
-      }
-
-      bool read_sample();
+      // texels are only read if a texture is passed
+      void  read_chunk( const chunk&, std::vector< location_t >&, std::vector< vertex_texture_coord_t::type >&, Surface::texture_type* )    const;
 
     public:
       
@@ -263,14 +264,21 @@ namespace flat
 
       PdmFileReader( const PdmFileReader& ) = delete;
       
+      // throws unknown_magic_number_exception for other files and std::runtime_error
+      // if the file can not be mapped or a binary file is shorter than its header says
       PdmFileReader( const std::string& path
                    , VertexPredicate
-                   , TexturePredicate texture_predicate = TexturePredicate() ) throw( unknown_magic_number_exception );
+                   , TexturePredicate texture_predicate = TexturePredicate() );
 
-      ~PdmFileReader() { m_stream.close(); }
+      ~PdmFileReader()  {   }
 
+	  // parses the chunks of the file on concurrent threads and hands the samples to the surface in bulk
+	  // - the texture is not read here, the surface gets a loader that decodes it from the file on first access
 	  void operator() ( const std::shared_ptr< Surface >& surface );
 
+	  // decodes the texels accepted by the texture predicate
+	  void read_texture( Surface::texture_type& texture )  const;
+
       std::string   get_name() const { return m_filename; }
 
   };
@@ -284,129 +292,238 @@ template< typename VertexPredicate, typename TexturePredicate >
 flat::PdmFileReader< VertexPredicate, TexturePredicate >
                    ::PdmFileReader( const std::string& path
                                   , VertexPredicate    vertex_predicate
-                                  , TexturePredicate   texture_predicate ) throw( unknown_magic_number_exception )
+                                  , TexturePredicate   texture_predicate )
 : RectlinearFieldGenerator( { 0, 0 } ), TextureGenerator( { 0, 0 } )
-, m_filename( path ), m_stream(), m_vertex_predicate( vertex_predicate ), m_texture_predicate( texture_predicate )
-, texture_color( 1. ), m_index( 0 ), m_field_size( 0, 0 )
+, m_filename( path ), m_file( path ), m_binary( false ), m_samples( 0 )
+, m_vertex_predicate( vertex_predicate ), m_texture_predicate( texture_predicate ), m_field_size( 0, 0 )
 
 {
-  m_stream.exceptions( std::ifstream::failbit | std::ifstream::badbit );
-
-  m_stream.open( path.c_str() );
-  
-  std::string   token;
-
   # if defined DBG_FLAT_PDM_FILE_READER
   std::clog << "flat::PdmFileReader::PdmFileReader\t|" << " path \"" << path << '\"' << std::endl;
   # endif
     
+  const pdm::header header( pdm::read_header( m_file ) );
+
   // check magic number
-  m_stream >> token;
-  if( token != "P9" )
-  {
-    m_stream.close();
-    throw unknown_magic_number_exception( token, path );
-  }
+  if( header.magic != pdm::text_magic && header.magic != pdm::binary_magic )
+    throw unknown_magic_number_exception( header.magic, path );
 
-  size_pair field_size{ 0, 0 };
   // read grid dimensions
-  m_stream >> token >> token >> get<1>( m_field_size ) >> get<0>( m_field_size ) >> token;
+  m_field_size = header.field_size;
+  m_binary     = header.is_binary();
+  m_samples    = m_file.begin() + header.data_offset;
 
   # if defined DBG_FLAT_PDM_FILE_READER
-  std::clog << "flat::PdmFileReader::PdmFileReader\t|" << " size (" << get<0>( m_field_size ) << ',' << get<1>( m_field_size ) << ')' << std::endl;
+  std::clog << "flat::PdmFileReader::PdmFileReader\t|" << " size (" << get<0>( m_field_size ) << ',' << get<1>( m_field_size ) << ')' 
+            << ( m_binary ? " binary" : " text" ) << std::endl;
   # endif
     
   assert( get<0>( m_field_size ) > 1 && get<1>( m_field_size ) > 1 );
+
+  if( m_binary && !header.fits_binary( m_file.size() ) )
+    throw std::runtime_error( "\"" + path + "\" is truncated" );
+
+  // strided loads of binary files touch only the records they keep
+  if( m_binary ) m_file.advise( utk::mapped_file::RANDOM );
   
   // resize storage
   m_vertices_size = m_vertex_predicate.result_field_size( m_field_size );
   m_texture_size  = m_texture_predicate.result_field_size( m_field_size );
-
-  m_stream.ignore( 256, '\n' );
-
 }
 
 template< typename VertexPredicate, typename TexturePredicate >
-void flat::PdmFileReader< VertexPredicate, TexturePredicate >::operator() ( const std::shared_ptr< Surface >& surface )
+std::vector< typename flat::PdmFileReader< VertexPredicate, TexturePredicate >::chunk >
+  flat::PdmFileReader< VertexPredicate, TexturePredicate >::split_chunks()  const
 {
+  const size_t num_chunks = m_binary ? utk::parallel_blocks( num_samples(), 4096 )
+                                     : utk::parallel_blocks( m_file.end() - m_samples, 1 << 20 );
+
+  std::vector< chunk > chunks( num_chunks );
+
+  if( m_binary )
+  { // records have a fixed size - split the sample range
+    for( size_t c = 0; c < num_chunks; ++c )
+    { chunks[c].first_sample = num_samples() * c / num_chunks;
+      chunks[c].num_samples  = num_samples() * ( c + 1 ) / num_chunks - chunks[c].first_sample;
+      chunks[c].begin = m_samples + chunks[c].first_sample * pdm::binary_record_size;
+      chunks[c].end   = chunks[c].begin + chunks[c].num_samples * pdm::binary_record_size;
+    }
+  }else
+  { // split the bytes at line ends and count the lines of every chunk
+    const size_t size = m_file.end() - m_samples;
+    
+    for( size_t c = 0; c < num_chunks; ++c )
+    { chunks[c].begin = c == 0 ? m_samples : std::max( chunks[c - 1].begin, pdm::next_line( m_samples + size * c / num_chunks - 1, m_file.end() ) );
+      if( c ) chunks[c - 1].end = chunks[c].begin;
+    }
+    chunks.back().end = m_file.end();
 
-  assert( num_vertices() == surface->num_vertices() );
+    // the last chunk takes the remaining samples, so its lines are not counted
+    chunks.back().num_samples = num_samples();
+
+    utk::parallel_invoke_blocks( num_chunks - 1, [&chunks]( const size_t c )
+    { 
+      size_t lines = 0;
+      for( const char* line = chunks[c].begin; line != chunks[c].end; line = pdm::next_line( line, chunks[c].end ) )
+        ++lines;
+      chunks[c].num_samples = lines;
+    } );
+
+    size_t first_sample = 0;
+    for( auto c = chunks.begin(); c != chunks.end(); ++c )
+    { // lines beyond the last sample are ignored
+      c->first_sample = first_sample;
+      c->num_samples  = std::min( c->num_samples, num_samples() - first_sample );
+      first_sample   += c->num_samples;
+    }
+  }
+
+  // count the accepted samples of every chunk - the predicates only look at the index
+  std::vector< size_pair > accepted( num_chunks, size_pair( 0, 0 ) );
 
-  const size_t field_size = get<0>( m_field_size ) * get<1>( m_field_size );
+  utk::parallel_invoke_blocks( num_chunks - 1, [&]( const size_t c )
+  {
+    for( size_t index = chunks[c].first_sample; index < chunks[c].first_sample + chunks[c].num_samples; ++index )
+    { if( m_vertex_predicate ( index ) ) ++get<0>( accepted[c] );
+      if( m_texture_predicate( index ) ) ++get<1>( accepted[c] );
+    }
+  } );
+
+  size_t first_vertex = 0, first_texel = 0;
+  for( size_t c = 0; c < num_chunks; ++c )
+  { chunks[c].first_vertex = first_vertex;
+    chunks[c].first_texel  = first_texel;
+    first_vertex += get<0>( accepted[c] );
+    first_texel  += get<1>( accepted[c] );
+  }
 
-  size_t vertex_index = 0, texture_index = 0;
+  return chunks;
+}
 
-  sample_mask_t sample_type;
+template< typename VertexPredicate, typename TexturePredicate >
+void flat::PdmFileReader< VertexPredicate, TexturePredicate >::read_chunk( const chunk& part
+                                                                         , std::vector< location_t >& locations
+                                                                         , std::vector< vertex_texture_coord_t::type >& texture_coordinates
+                                                                         , Surface::texture_type* texture )   const
+{
+  const char*   cursor        = part.begin;
+  size_t        vertex_index  = part.first_vertex;
+  size_t        texture_index = part.first_texel;
+
+  location_t    location;
+  rgba_color_t  color( 1. );
 
-  do // iterate over all samples in file
+  for( size_t index = part.first_sample; index < part.first_sample + part.num_samples; ++index )
   {
-    sample_type = next_sample();
-	
-	if( sample_type & VERTEX )
-    {
-      Surface::vertex_handle current_vertex = surface->vertex( vertex_index++ );
-      current_vertex.set_location( vertex_location );
-      current_vertex.set_texture_coordinate( vertex_texture_coordinate );
-
-      # if defined DBG_FLAT_PDM_FILE_READER_VERTEX_SAMPLE
-      std::clog << "flat::PdmFileReader()\t| " << " sample " << m_index
-	    		<< current_vertex  << std::endl;
-      # endif
+    const bool vertex_ready  = m_vertex_predicate ( index );
+    const bool texture_ready = texture && m_texture_predicate( index );
+
+    if( !vertex_ready && !texture_ready )
+    { // skip the sample without parsing it
+      if( !m_binary ) cursor = pdm::next_line( cursor, part.end );
+      continue;
     }
 
-    if( sample_type & TEXTURE )
+    read_sample( index, cursor, location, color );
+
+    if( vertex_ready )
     {
-      surface->texture().set_pixel( texture_index++, texture_color );
-      
-      # if defined DBG_FLAT_PDM_FILE_READER_TEXTURE_SAMPLE
-      std::clog << "flat::PdmFileReader()\t| " << " sample " << m_index
-                << " pixel " + boost::lexical_cast< std::string >( texture_index )
-                << " " << texture_color << std::endl;
-      # endif
+      locations[ vertex_index ] = location;
+      texture_coordinates[ vertex_index ][0] = ( index % get<0>( m_field_size ) ) / ( get<0>(m_field_size) - 1. );
+      texture_coordinates[ vertex_index ][1] = ( index / get<0>( m_field_size ) ) / ( get<1>(m_field_size) - 1. );
+      ++vertex_index;
     }
-    
-  } while( sample_type != END && advance_index() );// of while next sample
 
+    if( texture_ready )
+      texture->set_pixel( texture_index++, color );
+  }
 }
 
-
 template< typename VertexPredicate, typename TexturePredicate >
-typename flat::PdmFileReader< VertexPredicate, TexturePredicate >::sample_mask_t  
-  flat::PdmFileReader< VertexPredicate, TexturePredicate >::next_sample()
+void flat::PdmFileReader< VertexPredicate, TexturePredicate >::operator() ( const std::shared_ptr< Surface >& surface )
 {
-  bool vertex_ready  = m_vertex_predicate ( m_index );
-  bool texture_ready = m_texture_predicate( m_index );
+  assert( num_vertices() == surface->num_vertices() );
+
+  const std::vector< chunk > chunks( split_chunks() );
+
+  std::vector< location_t >                     locations( surface->num_vertices() );
+  std::vector< vertex_texture_coord_t::type >   texture_coordinates( surface->num_vertices() );
+
+  # if defined DBG_FLAT_PDM_FILE_READER
+  std::clog << "flat::PdmFileReader()\t| " << " reading " << chunks.size() << " chunks" << std::endl;
+  # endif
+
+  // every chunk writes to its own range of the arrays and the texture
+  utk::parallel_invoke_blocks( chunks.size(), [&]( const size_t c )
+  { read_chunk( chunks[c], locations, texture_coordinates, 0 ); } );
+
+  surface->set_locations( locations.begin() );
+
+  for( size_t vertex_index = 0; vertex_index < texture_coordinates.size(); ++vertex_index )
+  {
+    Surface::vertex_handle current_vertex = surface->vertex( vertex_index );
+    current_vertex.set_texture_coordinate( texture_coordinates[ vertex_index ] );
+
+    # if defined DBG_FLAT_PDM_FILE_READER_VERTEX_SAMPLE
+    std::clog << "flat::PdmFileReader()\t| " << " vertex " << current_vertex  << std::endl;
+    # endif
+  }
 
-  while( !vertex_ready && !texture_ready )
+  // the texture is decoded by a reader of its own that only accepts texels
+  const std::string         path( m_filename );
+  const TexturePredicate    texture_predicate( m_texture_predicate );
+
+  // the loader runs on first access, possibly while drawing - a file gone meanwhile leaves the texture white
+  surface->texture().set_loader( [path, texture_predicate]( Surface::texture_type& texture )
   { 
-    if( !skip_sample() ) return END;
-    
-    vertex_ready  = m_vertex_predicate ( m_index );
-    texture_ready = m_texture_predicate( m_index );
-  } 
+    try
+    { PdmFileReader< accept_none_predicate, TexturePredicate >( path, accept_none_predicate(), texture_predicate ).read_texture( texture ); }
+    catch( const std::exception& error )
+    { UTK_LOG( ERROR, "flat::PdmFileReader::operator()\t| loading the texture failed - " << error.what() ); }
+  } );
+}
 
-  read_sample();
-    
-  return vertex_ready ? ( texture_ready ? VERTEX|TEXTURE : VERTEX ) : TEXTURE;
+template< typename VertexPredicate, typename TexturePredicate >
+void flat::PdmFileReader< VertexPredicate, TexturePredicate >::read_texture( Surface::texture_type& texture )  const
+{
+  assert( texture.size == texture_size() );
+
+  const std::vector< chunk > chunks( split_chunks() );
+
+  std::vector< location_t >                     no_locations;
+  std::vector< vertex_texture_coord_t::type >   no_texture_coordinates;
+
+  # if defined DBG_FLAT_PDM_FILE_READER
+  std::clog << "flat::PdmFileReader::read_texture\t| " << " reading " << chunks.size() << " chunks" << std::endl;
+  # endif
+
+  // the pixmap has to exist before the chunks write to it concurrently
+  texture.load();
+
+  utk::parallel_invoke_blocks( chunks.size(), [&]( const size_t c )
+  { read_chunk( chunks[c], no_locations, no_texture_coordinates, &texture ); } );
 }
 
 
 template< typename VertexPredicate, typename TexturePredicate >
-bool flat::PdmFileReader< VertexPredicate, TexturePredicate >::read_sample()
+void flat::PdmFileReader< VertexPredicate, TexturePredicate >::read_sample( const size_t index, const char*& cursor
+                                                                          , location_t& location, rgba_color_t& color )  const
 {
-  std::string token;
-  
-  // reading line from file
-  std::getline( m_stream, token, '\n' );
-
   // extract position and color
-  std::istringstream ss( token );
+  if( m_binary )
+  {
+    float values[6];
+    pdm::read_binary_record( m_samples + index * pdm::binary_record_size, values );
 
-  ss >> vertex_location[0] >> vertex_location[1] >> vertex_location[2];
-  ss >> texture_color[0] >> texture_color[1] >> texture_color[2];
+    std::copy( values,     values + 3, location.begin() );
+    std::copy( values + 3, values + 6, color.begin() );
+  }else
+  {
+    const char* const end = m_file.end();
 
-  vertex_texture_coordinate[0] = ( m_index % get<0>( m_field_size ) ) / ( get<0>(m_field_size) - 1. );
-  vertex_texture_coordinate[1] = ( m_index / get<0>( m_field_size ) ) / ( get<1>(m_field_size) - 1. );
+    for( size_t i = 0; i < 3; ++i ) location[i] = pdm::parse_float( cursor, end );
+    for( size_t i = 0; i < 3; ++i ) color[i]    = pdm::parse_float( cursor, end );
 
-  return true;
+    cursor = pdm::next_line( cursor, end );
+  }
 }
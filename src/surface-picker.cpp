@@ -0,0 +1,315 @@
+//           surface-picker.cpp
+//  Copyright  2011  Peter Urban
+//  <s9peurba@stud.uni-saarland.de>
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+
+# include "surface-picker.h"
+
+# include "utk/parallel.h"
+
+# include <algorithm>
+# include <limits>
+
+using namespace flat;
+
+const size_t  SurfacePicker::LEAF_FACES;
+const size_t  SurfacePicker::REBUILD_FACTOR;
+
+namespace
+{
+  // the tree is balanced, so this bounds the traversal stack for any surface in memory
+  const size_t  MAX_DEPTH = 64;
+
+  coord_t   box_area( const location_t& min, const location_t& max )
+  {
+    const location_t size = max - min;
+    return 2 * ( size[0] * size[1] + size[1] * size[2] + size[2] * size[0] );
+  }
+
+  // parameter interval of the ray inside the box - empty if first > second
+  std::pair< coord_t, coord_t >  slab( const location_t& source, const location_t& inverse_direction
+                                     , const location_t& min, const location_t& max, const coord_t t_max )
+  {
+    coord_t first = 0, second = t_max;
+    for( size_t i = 0; i < 3; ++i )
+    {
+      coord_t t0 = ( min[i] - source[i] ) * inverse_direction[i];
+      coord_t t1 = ( max[i] - source[i] ) * inverse_direction[i];
+      if( t0 > t1 ) std::swap( t0, t1 );
+      // a direction parallel to the slab gives nan for a source on its plane - max and min skip it
+      first  = std::max( first, t0 );
+      second = std::min( second, t1 );
+    }
+    return std::make_pair( first, second );
+  }
+
+  // ray parameter of the intersection with the triangle, both sides count - infinity if there is none
+  coord_t   intersect( const location_t& source, const location_t& direction
+                     , const location_t& a, const location_t& b, const location_t& c )
+  {
+    const coord_t none = std::numeric_limits< coord_t >::infinity();
+
+    const location_t  ab = b - a, ac = c - a;
+    const location_t  p = utk::cross( direction, ac );
+    const coord_t     determinant = utk::dot( ab, p );
+
+    if( determinant == 0 ) return none;
+
+    const coord_t     inverse = 1 / determinant;
+    const location_t  s = source - a;
+
+    const coord_t u = utk::dot( s, p ) * inverse;
+    if( u < 0 || u > 1 ) return none;
+
+    const location_t  q = utk::cross( s, ab );
+
+    const coord_t v = utk::dot( direction, q ) * inverse;
+    if( v < 0 || u + v > 1 ) return none;
+
+    const coord_t t = utk::dot( ac, q ) * inverse;
+    return t >= 0 ? t : none;
+  }
+
+  coord_t   segment_distance( const location_t& p, const location_t& a, const location_t& b )
+  {
+    const location_t  ab = b - a;
+    const coord_t     squared = utk::dot( ab, ab );
+    const coord_t     t = squared > 0 ? std::min( coord_t( 1 ), std::max( coord_t( 0 ), utk::dot( p - a, ab ) / squared ) ) : 0;
+    return utk::length( p - ( a + ab * t ) );
+  }
+}
+
+void    SurfacePicker::build_node( const size_t index, const size_t begin, const size_t end, const std::vector< location_t >& centers )
+{
+  if( end - begin <= LEAF_FACES )
+  { m_nodes[ index ].first_child = 0;
+    m_nodes[ index ].first_face  = begin;
+    m_nodes[ index ].num_faces   = end - begin;
+    return;
+  }
+
+  // split at the median center along the longest side of the center bounds
+  location_t min(  std::numeric_limits< coord_t >::infinity() );
+  location_t max( -std::numeric_limits< coord_t >::infinity() );
+
+  for( size_t f = begin; f < end; ++f )
+    for( size_t i = 0; i < 3; ++i )
+    { min[i] = std::min( min[i], centers[ m_faces[f] ][i] );
+      max[i] = std::max( max[i], centers[ m_faces[f] ][i] );
+    }
+
+  const location_t size = max - min;
+  const size_t axis = size[0] >= size[1] && size[0] >= size[2] ? 0 : ( size[1] >= size[2] ? 1 : 2 );
+
+  const size_t middle = begin + ( end - begin ) / 2;
+  std::nth_element( m_faces.begin() + begin, m_faces.begin() + middle, m_faces.begin() + end
+                  , [&centers, axis]( const size_t a, const size_t b ) { return centers[a][axis] < centers[b][axis]; } );
+
+  const size_t first_child = m_nodes.size();
+  m_nodes.resize( first_child + 2 );
+
+  m_nodes[ index ].first_child = first_child;
+  m_nodes[ index ].first_face  = 0;
+  m_nodes[ index ].num_faces   = 0;
+
+  build_node( first_child,     begin,  middle, centers );
+  build_node( first_child + 1, middle, end,    centers );
+}
+
+void    SurfacePicker::fit_leaf( node& leaf, const std::vector< location_t >& locations )  const
+{
+  leaf.min = location_t(  std::numeric_limits< coord_t >::infinity() );
+  leaf.max = location_t( -std::numeric_limits< coord_t >::infinity() );
+
+  for( size_t f = leaf.first_face; f < leaf.first_face + leaf.num_faces; ++f )
+    for( size_t corner = 0; corner < 3; ++corner )
+    {
+      const location_t& location = locations[ m_face_vertices[ 3 * m_faces[f] + corner ] ];
+      for( size_t i = 0; i < 3; ++i )
+      { leaf.min[i] = std::min( leaf.min[i], location[i] );
+        leaf.max[i] = std::max( leaf.max[i], location[i] );
+      }
+    }
+}
+
+coord_t SurfacePicker::fit( const std::vector< location_t >& locations )
+{
+  utk::parallel_for( 0, m_nodes.size(), [this, &locations]( const size_t begin, const size_t end )
+  {
+    for( size_t n = begin; n < end; ++n )
+      if( m_nodes[n].num_faces ) fit_leaf( m_nodes[n], locations );
+  } );
+
+  coord_t area = 0;
+
+  // children follow their parents
+  for( size_t n = m_nodes.size(); n-- > 0; )
+  {
+    node& current = m_nodes[n];
+
+    if( current.num_faces == 0 )
+    { const node& left  = m_nodes[ current.first_child ];
+      const node& right = m_nodes[ current.first_child + 1 ];
+      for( size_t i = 0; i < 3; ++i )
+      { current.min[i] = std::min( left.min[i], right.min[i] );
+        current.max[i] = std::max( left.max[i], right.max[i] );
+      }
+    }
+
+    area += box_area( current.min, current.max );
+  }
+
+  return area;
+}
+
+void    SurfacePicker::build( const std::vector< vertex_descriptor >& face_vertices, const std::vector< location_t >& locations )
+{
+  assert( face_vertices.size() % 3 == 0 );
+
+  const size_t num_faces = face_vertices.size() / 3;
+
+  if( &face_vertices != &m_face_vertices )
+    m_face_vertices = face_vertices;
+
+  m_nodes.clear();
+  m_faces.resize( num_faces );
+
+  if( !num_faces ) { m_build_area = 0; return; }
+
+  std::vector< location_t > centers( num_faces );
+
+  utk::parallel_for( 0, num_faces, [this, &centers, &locations]( const size_t begin, const size_t end )
+  {
+    for( size_t f = begin; f < end; ++f )
+    { m_faces[f] = f;
+      centers[f] = ( locations[ m_face_vertices[ 3 * f ] ] + locations[ m_face_vertices[ 3 * f + 1 ] ] + locations[ m_face_vertices[ 3 * f + 2 ] ] ) / 3.;
+    }
+  } );
+
+  m_nodes.reserve( 2 * ( num_faces / LEAF_FACES + 1 ) );
+  m_nodes.resize( 1 );
+  build_node( 0, 0, num_faces, centers );
+
+  m_build_area = fit( locations );
+
+  UTK_LOG( INFO, "flat::SurfacePicker::build\t| " << m_nodes.size() << " nodes for " << num_faces << " faces" );
+}
+
+bool    SurfacePicker::refit( const std::vector< location_t >& locations )
+{
+  if( m_nodes.empty() ) return true;
+
+  const coord_t area = fit( locations );
+
+  // the boxes of faces moved far apart overlap - splitting them anew pays off
+  if( m_build_area > 0 && area > REBUILD_FACTOR * m_build_area )
+  { build( m_face_vertices, locations );
+    return false;
+  }
+
+  return true;
+}
+
+SurfacePicker::hit  SurfacePicker::pick( const std::vector< location_t >& locations, const ray_type& ray, const coord_t snap )  const
+{
+  hit result;
+
+  if( m_nodes.empty() ) return result;
+
+  const location_t source( ray.source() );
+  const location_t direction( ray.direction() );
+  const location_t inverse_direction( 1. / direction[0], 1. / direction[1], 1. / direction[2] );
+
+  coord_t best = std::numeric_limits< coord_t >::infinity();
+  size_t  best_face = 0;
+
+  size_t stack[ MAX_DEPTH + 1 ];
+  size_t size = 0;
+
+  if( slab( source, inverse_direction, m_nodes[0].min, m_nodes[0].max, best ).first <= best )
+    stack[ size++ ] = 0;
+
+  while( size )
+  {
+    const node& current = m_nodes[ stack[ --size ] ];
+
+    // the box may lie behind a hit found after it was pushed
+    if( slab( source, inverse_direction, current.min, current.max, best ).first > best ) continue;
+
+    if( current.num_faces )
+    {
+      for( size_t f = current.first_face; f < current.first_face + current.num_faces; ++f )
+      {
+        const vertex_descriptor* corners = &m_face_vertices[ 3 * m_faces[f] ];
+        const coord_t t = intersect( source, direction, locations[ corners[0] ], locations[ corners[1] ], locations[ corners[2] ] );
+        if( t < best ) { best = t; best_face = m_faces[f]; }
+      }
+      continue;
+    }
+
+    // the nearer child is visited first
+    const std::pair< coord_t, coord_t > left  = slab( source, inverse_direction, m_nodes[ current.first_child ].min, m_nodes[ current.first_child ].max, best );
+    const std::pair< coord_t, coord_t > right = slab( source, inverse_direction, m_nodes[ current.first_child + 1 ].min, m_nodes[ current.first_child + 1 ].max, best );
+
+    const bool left_hit  = left.first  <= left.second;
+    const bool right_hit = right.first <= right.second;
+
+    if( left_hit && right_hit )
+    { const bool left_first = left.first <= right.first;
+      stack[ size++ ] = current.first_child + ( left_first ? 1 : 0 );
+      stack[ size++ ] = current.first_child + ( left_first ? 0 : 1 );
+    }
+    else if( left_hit )  stack[ size++ ] = current.first_child;
+    else if( right_hit ) stack[ size++ ] = current.first_child + 1;
+
+    assert( size <= MAX_DEPTH + 1 );
+  }
+
+  if( best == std::numeric_limits< coord_t >::infinity() ) return result;
+
+  result.type      = hit::FACE;
+  result.face      = best_face;
+  result.parameter = best;
+  result.location  = ray.at( best );
+
+  const vertex_descriptor* corners = &m_face_vertices[ 3 * best_face ];
+  const coord_t radius = snap * best * utk::length( direction );
+
+  // the nearest corner within the radius wins over the edges
+  coord_t nearest = radius;
+  for( size_t i = 0; i < 3; ++i )
+  { const coord_t distance = utk::length( locations[ corners[i] ] - result.location );
+    if( distance <= nearest )
+    { nearest = distance;
+      result.type = hit::VERTEX;
+      result.vertices[0] = result.vertices[1] = corners[i];
+    }
+  }
+
+  if( result.type == hit::VERTEX ) return result;
+
+  for( size_t i = 0; i < 3; ++i )
+  { const coord_t distance = segment_distance( result.location, locations[ corners[i] ], locations[ corners[ ( i + 1 ) % 3 ] ] );
+    if( distance <= nearest )
+    { nearest = distance;
+      result.type = hit::EDGE;
+      result.vertices[0] = corners[i];
+      result.vertices[1] = corners[ ( i + 1 ) % 3 ];
+    }
+  }
+
+  return result;
+}
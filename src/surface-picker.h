@@ -0,0 +1,115 @@
+/***************************************************************************
+ *            surface-picker.h
+ *
+ *  Copyright  2011  Peter Urban
+ *  <s9peurba@stud.uni-saarland.de>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+# pragma once
+
+# include "surface.h"
+
+# include "utk/ray.h"
+
+# include <vector>
+
+namespace flat
+{
+  // finds the face of a surface hit first by a ray and the vertex or edge next to the hit point
+  // - the faces are kept in a bounding volume hierarchy built once per topology
+  // - after the vertices moved the boxes are refitted bottom up, the tree is only rebuilt
+  //   if the refitted boxes grew much larger than the ones it was built with
+  class SurfacePicker
+  {
+    public:
+
+      typedef Surface::vertex_descriptor  vertex_descriptor;
+      typedef utk::ray< coord_t, 3 >      ray_type;
+
+      struct hit
+      {
+        typedef enum { NONE = 0, VERTEX, EDGE, FACE } type_t;
+
+        type_t  type;
+        // index of the face hit ( in face index order )
+        size_t  face;
+        // the vertex picked or the two ends of the edge picked
+        vertex_descriptor   vertices[2];
+        // ray parameter and location of the hit point
+        coord_t     parameter;
+        location_t  location;
+
+        hit() : type( NONE ), face( 0 ), parameter( 0 ), location( 0. )
+        { vertices[0] = vertices[1] = 0; }
+      };
+
+    private:
+
+      struct node
+      {
+        location_t  min, max;
+        // children are first_child and first_child + 1 - leaves have no children and
+        // hold the faces [ first_face, first_face + num_faces ) of m_faces
+        size_t      first_child;
+        size_t      first_face;
+        size_t      num_faces;
+      };
+
+      std::vector< node >   m_nodes;
+
+      // face indices in leaf order and their vertices
+      std::vector< size_t >             m_faces;
+      std::vector< vertex_descriptor >  m_face_vertices;
+
+      // summed box areas after the last build - a refit beyond REBUILD_FACTOR times that rebuilds
+      coord_t   m_build_area;
+
+      void      build_node( const size_t index, const size_t begin, const size_t end, const std::vector< location_t >& centers );
+
+      void      fit_leaf( node& leaf, const std::vector< location_t >& locations )  const;
+
+      // fits the leaves to the locations and the inner nodes to their children - returns the summed box areas
+      coord_t   fit( const std::vector< location_t >& locations );
+
+    public:
+
+      static const size_t   LEAF_FACES      = 4;
+      static const size_t   REBUILD_FACTOR  = 4;
+
+      SurfacePicker() : m_build_area( 0 )  {   }
+
+      bool      empty()         const   { return m_nodes.empty(); }
+      size_t    num_faces()     const   { return m_faces.size(); }
+      size_t    num_nodes()     const   { return m_nodes.size(); }
+
+      // the face vertices of the last build
+      const std::vector< vertex_descriptor >&   face_vertices() const   { return m_face_vertices; }
+
+      // builds the hierarchy for the faces given as three vertices each
+      void      build( const std::vector< vertex_descriptor >& face_vertices, const std::vector< location_t >& locations );
+
+      // fits the boxes to moved vertices of the same faces - returns false if it rebuilt the tree instead
+      bool      refit( const std::vector< location_t >& locations );
+
+      // the nearest face hit in front of the ray source - a corner or an edge closer to the hit point
+      // than snap times its distance from the source is picked instead of the face
+      // - locations are the ones of the last build or refit
+      hit       pick( const std::vector< location_t >& locations, const ray_type& ray, const coord_t snap = 0 )  const;
+  };
+}
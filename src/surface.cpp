@@ -19,55 +19,21 @@
 # include "surface.h"
 
 # include "mmp-visualizer.h"
+# include "utk/log.h"
 //# include "spring-force.h"
 
-# include <boost/accumulators/accumulators.hpp>
-# include <boost/accumulators/statistics/min.hpp>
-# include <boost/accumulators/statistics/max.hpp>
-# include <boost/accumulators/statistics/sum.hpp>
+# include "utk/parallel.h"
 
 using namespace flat;
 
-void	flat::PointCloud::comp_min_max_xy()	const	
-{ 
-  using namespace boost::accumulators;
-
-  accumulator_set< coord_t, features< tag::min, tag::max > > xacc,yacc;
-
-  for( auto vertex_it = vertex_handles(); vertex_it.first != vertex_it.second; vertex_it.first++ )
-  { 
-    xacc( vertex_it.first->location()[0] );
-	yacc( vertex_it.first->location()[1] );
-  }
-	
-  m_min_location[0] = min(xacc);
-  m_min_location[1] = min(yacc);
-  m_max_location[0] = max(xacc);
-  m_max_location[1] = max(yacc);
-}
-
-void	flat::PointCloud::comp_min_max_z()	const
-{ 
-  using namespace boost::accumulators;
-
-  accumulator_set< coord_t, features< tag::min, tag::max > > zacc;
-
-  for( auto vertex_it = vertex_handles(); vertex_it.first != vertex_it.second; vertex_it.first++ )
-    zacc( vertex_it.first->location()[2] );
-		
-  m_min_location[2] = min( zacc );
-  m_max_location[2] = max( zacc );
-}
-
 Surface::Surface( const vertices_size_type  num_vertices
                 , const size_pair& 			texture_size
                 , const std::string&        name )
 : PointCloud( num_vertices ), m_name( name ), m_texture( texture_size )
 { 
-  std::clog << "flat::Surface::Surface\t|"
-            << " vertex size (" << num_vertices << ')' 
-            << " texture size (" << std::get<0>(texture_size) << ", " << std::get<1>(texture_size) << ')' 
-            << std::endl; 
+  UTK_LOG( INFO, "flat::Surface::Surface\t|"
+                 << " vertex size (" << num_vertices << ')' 
+                 << " texture size (" << std::get<0>(texture_size) << ", " << std::get<1>(texture_size) << ')' );
 }
 
 void Surface::distance_function::compute_all_to_all( const std::shared_ptr< Surface >& surface )
@@ -119,8 +85,7 @@ void Surface::distance_function::compute_all_to_neighbors( const std::shared_ptr
 
 void Surface::distance_function::compute_distances( const std::shared_ptr< Surface >& surface, neighborhood_mask_type nb )
 {
-  std::clog << "flat::Surface::compute_distances"
-            << std::endl;
+  UTK_LOG( DEBUG, "flat::Surface::compute_distances" );
 
   std::time_t start_time = std::clock();
   
@@ -133,9 +98,8 @@ void Surface::distance_function::compute_distances( const std::shared_ptr< Surfa
 
   std::time_t end_time = std::clock();
   
-  std::clog << "flat::Surface::compute_distances\t|" 
-            << "complete - after " << ( (end_time - start_time)/double(CLOCKS_PER_SEC) ) 
-            << std::endl;
+  UTK_LOG( INFO, "flat::Surface::compute_distances\t|" 
+                 << "complete - after " << ( (end_time - start_time)/double(CLOCKS_PER_SEC) ) );
 }
 
 std::vector< Surface::vertex_pair > Surface::neighbors() const 
@@ -153,31 +117,81 @@ std::vector< Surface::vertex_pair > Surface::neighbors() const
                  );
   }
                               
-  std::clog << "flat::Surface::neighbors\t| complete - " <<  neighbor_pairs.size() << " springs created" << std::endl;
+  UTK_LOG( DEBUG, "flat::Surface::neighbors\t| complete - " <<  neighbor_pairs.size() << " springs created" );
 
   return neighbor_pairs;
 }
 
+const std::vector< curvature_t >&   flat::Surface::gaussian_curvature()  const
+{
+  return m_gaussian_curvature.get( attribute_generation(), [this]()
+  {
+    const std::vector< angle_t >& angle_defects = geometry().angle_defects();
+    const std::vector< area_t >&  vertex_areas  = geometry().vertex_areas();
+    
+    std::vector< curvature_t > curvature( angle_defects.size() );
+    
+    utk::parallel_for( 0, curvature.size(), [&]( const size_t begin, const size_t end )
+    { for( size_t v = begin; v < end; ++v )
+        curvature[v] = angle_defects[v] / vertex_areas[v] / 3; // use voronoy region???
+    } );
+    
+    UTK_LOG( DEBUG, "flat::Surface::gaussian_curvature\t| recomputed for generation " << attribute_generation() );
+    
+    return curvature;
+  } );
+}
+
+const std::pair< curvature_t, curvature_t >&   flat::Surface::gaussian_curvature_extrema()  const
+{
+  return m_gaussian_curvature_extrema.get( attribute_generation(), [this]()
+  {
+    const std::vector< curvature_t >& curvature = gaussian_curvature();
+    
+    if( curvature.empty() ) return std::pair< curvature_t, curvature_t >( 0, 0 );
+    
+    const auto extrema = std::minmax_element( curvature.begin(), curvature.end() );
+    return std::make_pair( *extrema.first, *extrema.second );
+  } );
+}
+
 std::pair< flat::coord_t, Surface::distance_function::neighborhood_mask_type > 
     flat::Surface::get_squared_distance_error()    const
 {
-  namespace acc = boost::accumulators;
+  const std::vector< location_t >& locations = geometry().locations();
+
+  auto squared_error = [&]( const vertex_descriptor a, const vertex_descriptor b ) -> coord_t
+  { return utk::sqr( utk::distance( location2d_ref_t( locations[a] ), location2d_ref_t( locations[b] ) ) - initial_distances( a, b ) ); };
+
+  auto sum = []( const coord_t a, const coord_t b ) { return a + b; };
+
+  coord_t total_sq_error = 0;
 
-  typedef location2d_ref_t handle;
-  
-  acc::accumulator_set< coord_t, acc::features< acc::tag::sum > >  total_sq_error;
   if( initial_distances.neighborhood & distance_function::ALL )
-  { for( auto it1 = vertex_handles(); it1.first != it1.second; it1.first++ )
-      for( vertex_descriptor v2 = *it1.first + 1; v2 < num_vertices(); ++v2 )
-        total_sq_error( utk::sqr( utk::distance( handle( it1.first->location() ), handle( vertex( v2 ).location() ) ) - initial_distances( *it1.first, v2 ) ) );
+  { // rows get shorter towards the end - small blocks keep the threads balanced
+    total_sq_error = utk::parallel_reduce( 0, num_vertices(), coord_t( 0 )
+                                         , [&]( const size_t begin, const size_t end )
+                                           { coord_t partial = 0;
+                                             for( vertex_descriptor v1 = begin; v1 < end; ++v1 )
+                                               for( vertex_descriptor v2 = v1 + 1; v2 < num_vertices(); ++v2 )
+                                                 partial += squared_error( v1, v2 );
+                                             return partial;
+                                           }
+                                         , sum, 64 );
   }else 
   if( initial_distances.neighborhood & distance_function::NEIGHBORS )
   {
-    std::vector< vertex_pair > neighbors( this->neighbors() );
-    for( auto pair = neighbors.begin(); pair != neighbors.end(); ++pair )
-      total_sq_error( utk::sqr( utk::distance( handle( vertex( pair->first ).location() ), handle( vertex( pair->second ).location() ) ) - initial_distances( pair->first, pair->second ) ) );
+    const std::vector< vertex_pair > neighbors( this->neighbors() );
+    total_sq_error = utk::parallel_reduce( 0, neighbors.size(), coord_t( 0 )
+                                         , [&]( const size_t begin, const size_t end )
+                                           { coord_t partial = 0;
+                                             for( size_t p = begin; p < end; ++p )
+                                               partial += squared_error( neighbors[p].first, neighbors[p].second );
+                                             return partial;
+                                           }
+                                         , sum );
   }
 
-  return { acc::sum( total_sq_error ), initial_distances.neighborhood };
+  return { total_sq_error, initial_distances.neighborhood };
 }
 
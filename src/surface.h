@@ -27,6 +27,10 @@
 
 # include "common.h"
 # include "he-mesh.h"
+# include "he-indexed-mesh.h"
+# include "mesh-geometry.h"
+
+# include "utk/cache.h"
 
 namespace flat
 {
@@ -51,7 +55,7 @@ namespace flat
 	  typedef typename MeshT::vertex_handle     vertex_handle;
       typedef typename MeshT::edge_handle       edge_handle;
 
-	  typedef typename boost::property_map<typename MeshT::graph_t, vertex_texture_coord_t >::const_type	
+	  typedef typename MeshT::template property_map< vertex_texture_coord_t >::const_type	
 																				const_texture_coord_map_t;
 	  
 	  typedef typename boost::property_traits<const_texture_coord_map_t>::value_type 	color_t;
@@ -74,14 +78,20 @@ namespace flat
       
 	  void	set_texture_coordinate( const vertex_texture_coord_t::type& value )	
       { 
-        return this->mesh().put< vertex_texture_coord_t >( this->descriptor(), value ); 
+        return this->mesh().template put< vertex_texture_coord_t >( this->descriptor(), value ); 
       }
   };
 
-  // the mesh type 
+  // the mesh type - FLAT_INDEXED_MESH selects the array based half-edge backend
+# if defined FLAT_INDEXED_MESH
+  typedef he::IndexedMesh< VertexHandle, he::DefaultEdgeHandle, he::DefaultFaceHandle
+			             , boost::property< vertex_texture_coord_t, vertex_texture_coord_t::type >
+                         , boost::no_property, boost::no_property >	surface_mesh_t;
+# else
   typedef he::Mesh< VertexHandle, he::DefaultEdgeHandle, he::DefaultFaceHandle
 			      , boost::property< vertex_texture_coord_t, vertex_texture_coord_t::type >
                   , boost::no_property, boost::no_property >	surface_mesh_t;
+# endif
 
   
   class PointCloud : public surface_mesh_t
@@ -89,18 +99,13 @@ namespace flat
 
     private:
 	  
-	  mutable location_t	m_min_location;
-	  mutable location_t	m_max_location;
+	  MeshGeometry< surface_mesh_t >  m_geometry;
 
-	  void	comp_min_max_xy()	const;
-	  void	comp_min_max_z()	const;
-	  
     protected:
 	  
 	  PointCloud( vertices_size_type vertex_count )
 	  :	surface_mesh_t( vertex_count ) 
-	  , m_min_location(   std::numeric_limits<coord_t>::infinity() )
-	  ,	m_max_location( - std::numeric_limits<coord_t>::infinity() )			
+	  , m_geometry( *this )
 	  {	}
 
     public:
@@ -110,49 +115,23 @@ namespace flat
 	  const distance_t	distance( vertex_descriptor a, vertex_descriptor b)	const   
       { return utk::distance( vertex( a ).location(), vertex( b ).location() ); }		  
 
-	  virtual void	prepare_step()  { set_min_max(); }
+	  virtual void	prepare_step()  {   }
 
-      
-	  void	set_min_max( const location_ref_t& min = location_t( std::numeric_limits<coord_t>::infinity()), 
-			           	 const location_ref_t& max = location_t(-std::numeric_limits<coord_t>::infinity()) )										
-      { m_min_location = min;
-	    m_max_location = max;
-	  }
+	  // batch geometry - cached until the vertex locations or the topology change
+	  const MeshGeometry< surface_mesh_t >&   geometry()  const   { return m_geometry; }
 
-	  void	set_min_max_z( const coord_t min =  std::numeric_limits<coord_t>::infinity(), 
-			           	   const coord_t max = -std::numeric_limits<coord_t>::infinity() )
-	  { m_min_location.z() = min;
-	    m_max_location.z() = max;
-	  }
+	  // changes with every location write and every change of the triangulation
+	  // - derived attributes cached in a GenerationCache are keyed by it
+	  const size_t  attribute_generation()  const   { return location_generation() + topology_generation(); }
 
-	  const coord_t&	min_height()    const
-      { if( m_min_location.z() == std::numeric_limits<coord_t>::infinity() )
-          comp_min_max_z();
-        return m_min_location.z();
-	  }
+	  const coord_t&	min_height()    const   { return m_geometry.bounding_box().first.z(); }
       
-	  const coord_t&  	max_height()	const	
-      { if( m_max_location.z() == - std::numeric_limits<coord_t>::infinity() )
-          comp_min_max_z();
-        return m_max_location.z();
-	  }							
+	  const coord_t&  	max_height()	const	{ return m_geometry.bounding_box().second.z(); }
 
 	  // TODO use bounding box interface
-	  location_t    min_location()	const
-      { if( ( m_min_location.xy() == std::numeric_limits<coord_t>::infinity() ) == true )
-		  comp_min_max_xy();
-		if( m_min_location.z() == std::numeric_limits<coord_t>::infinity() )
-          comp_min_max_z();
-        return m_min_location;
-	  }
+	  location_t    min_location()	const   { return m_geometry.bounding_box().first; }
 
-	  location_t    max_location()  const
-      { if( ( m_max_location.xy() == - std::numeric_limits<coord_t>::infinity() ) == true )
-          comp_min_max_xy();
-        if( m_max_location.z() == - std::numeric_limits<coord_t>::infinity() )
-          comp_min_max_z();
-        return m_max_location;
-      }
+	  location_t    max_location()  const   { return m_geometry.bounding_box().second; }
 	  
   };
 
@@ -167,40 +146,81 @@ namespace flat
       static vertex_handle_pair make_vertex_handle_pair( const vertex_pair& pair, const Surface& surface )
       { return { vertex_handle( pair.first, surface ), vertex_handle( pair.second, surface ) }; }
       
+      // rgba texture with 8 bits per channel
+      // - the pixmap is allocated on first access, an optional loader fills it at that point,
+      //   so surfaces that are never rendered do not decode their texture at all
       struct texture_type
       {
-		typedef	color_channel_t	channel_type;
+		typedef	unsigned char	channel_type;
+
+        typedef std::function< void( texture_type& ) >  loader_type;
 
         static const size_t num_components = 4;
 		
         size_pair size;
-        std::vector< channel_type > 	pixmap;
+
+        private:
+
+          mutable std::vector< channel_type > 	m_pixmap;
+          mutable loader_type                   m_loader;
+
+          static channel_type   encode( const color_channel_t value )
+          { return channel_type( std::min< color_channel_t >( std::max< color_channel_t >( value, 0 ), 1 ) * 255 + .5 ); }
+
+        public:
 
         texture_type( texture_type&& other )
-        : size( std::move( other.size ) ), pixmap( std::move( other.pixmap ) )
+        : size( std::move( other.size ) ), m_pixmap( std::move( other.m_pixmap ) ), m_loader( std::move( other.m_loader ) )
         {   }
 
         texture_type( const size_pair& o_size )
-        : size( o_size ), pixmap( std::get<0>(o_size) * std::get<1>(o_size) * num_components ) 
+        : size( o_size ) 
         {   }  
 
+        // replaces the texels by the result of the loader on next access
+        void    set_loader( const loader_type& loader )
+        { m_pixmap.clear();
+          m_loader = loader;
+        }
+
+        bool    is_loaded() const   { return !m_loader && m_pixmap.size() == std::get<0>( size ) * std::get<1>( size ) * num_components; }
+
+        // allocates the pixmap and runs the loader - call it before writing texels from several threads
+        void    load()  const
+        {
+          if( is_loaded() ) return;
+
+          m_pixmap.assign( std::get<0>( size ) * std::get<1>( size ) * num_components, 255 );
+
+          loader_type loader;
+          std::swap( loader, m_loader );
+          if( loader ) loader( const_cast< texture_type& >( *this ) );
+        }
+
+        // texels in rows of size.first, num_components channels each
+        const channel_type* pixels()    const   { load(); return m_pixmap.empty() ? 0 : &m_pixmap[0]; }
+
 		void	set_pixel( size_t pixel_index
 			             , const rgba_color_ref_t& color ) 
 		{ 
+		  load();
 		  for( size_t i = 0; i < num_components; ++i ) 
-		   pixmap[ pixel_index * num_components + i ] = color[i];
+		   m_pixmap[ pixel_index * num_components + i ] = encode( color[i] );
 		}
         
-        const rgba_color_t get_pixel( const size_t index ) const
-        { return rgba_color_t( pixmap[ index + 0 ], pixmap[ index + 1 ], pixmap[ index + 2 ], pixmap[ index + 3 ] ); }
+        const rgba_color_t get_pixel( const size_t pixel_index ) const
+        { 
+          const channel_type* pixel = pixels() + pixel_index * num_components;
+          return rgba_color_t( pixel[0] / 255.f, pixel[1] / 255.f, pixel[2] / 255.f, pixel[3] / 255.f ); 
+        }
         
         const rgba_color_t get_pixel( const size_t s, const size_t t ) const
-        { return get_pixel( ( s + t * size.first ) * num_components ); }
+        { return get_pixel( s + t * size.first ); }
       };
 
       struct distance_function
       {
-        typedef boost::numeric::ublas::symmetric_matrix< distance_t, boost::numeric::ublas::upper > distance_matrix_type;
+        typedef boost::numeric::ublas::symmetric_matrix< solver_distance_t, boost::numeric::ublas::upper > distance_matrix_type;
 
         typedef enum { NONE = 0, NEIGHBORS = 1, ALL = 2 } neighborhood_type;
         typedef int neighborhood_mask_type;
@@ -241,11 +261,15 @@ namespace flat
 
 	  std::string	m_name;
 	  
-	  // vector containing three (rgb-)color components per texel
+	  // four 8 bit color components per texel
 	  texture_type  m_texture;
 
-	  // the minimum and maximum value of the gaussian curvature on ther surface
-	  mutable std::pair<coord_t,coord_t>	curvature_extrema;
+	  // gaussian curvature per vertex and its extrema
+	  GenerationCache< std::vector< curvature_t > >             m_gaussian_curvature;
+	  GenerationCache< std::pair< curvature_t, curvature_t > >  m_gaussian_curvature_extrema;
+
+	  // the minimum and maximum value of the curvature displayed last
+	  GenerationCache< std::pair< coord_t, coord_t > >          m_curvature_extrema;
       
     protected:
      
@@ -276,9 +300,12 @@ namespace flat
       
       virtual std::vector< vertex_descriptor > neighbors( const vertex_descriptor descriptor ) const
       { 
-        auto adj = adjacent_vertices( descriptor, get_graph() ); 
-       
-        return std::vector< vertex_descriptor >( adj.first, adj.second ); 
+        std::vector< vertex_descriptor > adjacent;
+        
+        for( auto out_its = out_edges( descriptor ); out_its.first != out_its.second; ++out_its.first )
+          adjacent.push_back( target( *out_its.first ) );
+        
+        return adjacent; 
       }
       
       virtual std::vector< vertex_pair > neighbors() const;
@@ -288,16 +315,20 @@ namespace flat
       texture_type&         texture()           { return m_texture; }
       const texture_type&   texture()   const   { return m_texture; }
 
-      const std::pair<coord_t,coord_t>&	get_curvature_extrema()	const	{ return curvature_extrema; }
-		  
-	  void		set_curvature_extrema( const float min =  std::numeric_limits<float>::infinity() 
-									 , const float max = -std::numeric_limits<float>::infinity() ) const
-	  { curvature_extrema = { min, max }; }
+      // gaussian curvature at the vertices - zero on the boundary
+      const std::vector< curvature_t >&                 gaussian_curvature()    const;
 
-	  virtual void	prepare_step()	
-      { set_curvature_extrema();
-	    PointCloud::prepare_step();
-	  }
+      const std::pair< curvature_t, curvature_t >&      gaussian_curvature_extrema()    const;
+
+      // extrema set by the drawable showing the curvature - defaults to the gaussian curvature extrema
+      const std::pair<coord_t,coord_t>&	get_curvature_extrema()	const	
+      { if( m_curvature_extrema.is_valid( attribute_generation() ) ) 
+          return m_curvature_extrema;
+        return gaussian_curvature_extrema();
+      }
+		  
+	  void		set_curvature_extrema( const coord_t min, const coord_t max ) const
+	  { m_curvature_extrema.assign( { min, max }, attribute_generation() ); }
 
       // triangulation
       
@@ -0,0 +1,340 @@
+//           texture-rasterizer.cpp
+//  Copyright  2011  Peter Urban
+//  <s9peurba@stud.uni-saarland.de>
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+
+# include "texture-rasterizer.h"
+
+# include "png-writer.h"
+
+# include "utk/log.h"
+# include "utk/parallel.h"
+
+# include <algorithm>
+# include <atomic>
+# include <chrono>
+# include <cmath>
+# include <stdexcept>
+
+using namespace flat;
+
+namespace
+{
+  // columns per tile - the unit of work of the threads
+  const size_t  TILE_COLUMNS = 256;
+
+  // bytes of an automatically sized strip
+  const size_t  STRIP_BYTES  = size_t( 64 ) << 20;
+
+  // the largest width and height of a png image
+  const size_t  MAX_PNG_SIZE = 0x7fffffff;
+
+  const unsigned char   TEXEL_OUTLINE_SHADE = 96;
+  const unsigned char   BLOCK_OUTLINE_SHADE = 0;
+
+  // texture coordinates closer than this ( in texels ) count as equal
+  const coord_t TEXEL_EPSILON = 1e-3;
+}
+
+TextureRasterizer::TextureRasterizer( const Surface& surface, const options& o_options )
+: m_surface( surface ), m_options( o_options ), m_scale( 0 ), m_width( 0 ), m_height( 0 )
+{
+  const Surface::texture_type& texture = surface.texture();
+
+  if( !texture.size.first || !texture.size.second )
+    throw std::runtime_error( "the surface has no texture" );
+
+  if( !( m_options.texel_size > 0.f ) )
+    throw std::runtime_error( "the texel size must be positive" );
+
+  // decoded before the threads sample it
+  texture.load();
+
+  const location_t min    = surface.min_location();
+  const location_t max    = surface.max_location();
+  const location_t extent = max - min;
+
+  if( !( extent.x() > 0 ) || !( extent.y() > 0 ) )
+    throw std::runtime_error( "the surface has no extent in the plane" );
+
+  m_scale  = m_options.texel_size / std::min( extent.x() / texture.size.first, extent.y() / texture.size.second );
+  const coord_t width  = std::ceil( m_scale * extent.x() );
+  const coord_t height = std::ceil( m_scale * extent.y() );
+
+  if( width > MAX_PNG_SIZE || height > MAX_PNG_SIZE )
+    throw std::runtime_error( "the image is too large for a png file - reduce the texel size" );
+
+  m_width  = std::max< size_t >( 1, width );
+  m_height = std::max< size_t >( 1, height );
+
+  const std::vector< location_t >& locations = surface.geometry().locations();
+
+  m_pixel_locations.resize( locations.size() );
+  m_texel_locations.resize( locations.size() );
+
+  utk::parallel_for( 0, locations.size(), [&]( const size_t begin, const size_t end )
+  {
+    for( size_t v = begin; v < end; ++v )
+    {
+      // the top row shows the largest y like the gl view
+      m_pixel_locations[v] = location2d_t( ( locations[v].x() - min.x() ) * m_scale, ( max.y() - locations[v].y() ) * m_scale );
+
+      const vertex_texture_coord_t::type& coordinate = surface.vertex( v ).texture_coordinate();
+      m_texel_locations[v] = location2d_t( coordinate[0] * ( texture.size.first - 1 ), coordinate[1] * ( texture.size.second - 1 ) );
+    }
+  } );
+
+  setup_triangles();
+}
+
+void    TextureRasterizer::setup_triangles()
+{
+  const std::vector< Surface::vertex_descriptor >& faces = m_surface.geometry().face_vertices();
+
+  m_triangles.clear();
+  m_triangles.reserve( faces.size() / 3 );
+
+  for( size_t f = 0; f < faces.size(); f += 3 )
+  {
+    triangle tri;
+
+    coord_t min_x = m_width, max_x = 0, min_y = m_height, max_y = 0;
+
+    for( size_t i = 0; i < 3; ++i )
+    {
+      tri.vertices[i] = faces[ f + i ];
+
+      const location2d_t& p = m_pixel_locations[ tri.vertices[i] ];
+      min_x = std::min( min_x, p.x() );
+      max_x = std::max( max_x, p.x() );
+      min_y = std::min( min_y, p.y() );
+      max_y = std::max( max_y, p.y() );
+    }
+
+    // pixels are sampled at their centers
+    tri.min_column = std::max< long >( 0, std::ceil( min_x - .5 ) );
+    tri.max_column = std::min< long >( m_width - 1, std::floor( max_x - .5 ) );
+    tri.min_row    = std::max< long >( 0, std::ceil( min_y - .5 ) );
+    tri.max_row    = std::min< long >( m_height - 1, std::floor( max_y - .5 ) );
+
+    if( tri.min_column > tri.max_column || tri.min_row > tri.max_row )
+      continue;
+
+    // the diagonals of a triangulated grid cell run along neither texture axis
+    for( size_t i = 0; i < 3; ++i )
+    {
+      const location2d_t& a = m_texel_locations[ tri.vertices[i] ];
+      const location2d_t& b = m_texel_locations[ tri.vertices[ ( i + 1 ) % 3 ] ];
+      tri.block_edge[i] = std::abs( a.x() - b.x() ) < TEXEL_EPSILON || std::abs( a.y() - b.y() ) < TEXEL_EPSILON;
+    }
+
+    m_triangles.push_back( tri );
+  }
+}
+
+void    TextureRasterizer::rasterize_tile( const std::vector< size_t >& triangles
+                                         , const size_t first_row
+                                         , const size_t num_rows
+                                         , const size_t begin
+                                         , const size_t end
+                                         , unsigned char* strip )  const
+{
+  const Surface::texture_type& texture = m_surface.texture();
+  const Surface::texture_type::channel_type* texels = texture.pixels();
+
+  const long texture_width  = texture.size.first;
+  const long texture_height = texture.size.second;
+
+  const long last_row = first_row + num_rows - 1;
+
+  for( auto it = triangles.begin(); it != triangles.end(); ++it )
+  {
+    const triangle& tri = m_triangles[ *it ];
+
+    if( tri.min_column >= long( end ) || tri.max_column < long( begin ) )
+      continue;
+
+    const location2d_t* p[3];
+    const location2d_t* uv[3];
+    for( size_t i = 0; i < 3; ++i )
+    { p[i]  = &m_pixel_locations[ tri.vertices[i] ];
+      uv[i] = &m_texel_locations[ tri.vertices[i] ];
+    }
+
+    const coord_t area2 = ( p[1]->x() - p[0]->x() ) * ( p[2]->y() - p[0]->y() ) - ( p[1]->y() - p[0]->y() ) * ( p[2]->x() - p[0]->x() );
+
+    if( std::abs( area2 ) < 1e-12 )
+      continue;
+
+    // barycentric coordinate i = dx[i] * x + dy[i] * y + d0[i] - the sign of the area handles mirrored faces
+    coord_t dx[3], dy[3], d0[3];
+    // distance in pixels to the edge opposite vertex i per barycentric unit
+    coord_t edge_distance[3];
+    bool    block_edge[3];
+
+    for( size_t i = 0; i < 3; ++i )
+    {
+      const location2d_t& a = *p[ ( i + 1 ) % 3 ];
+      const location2d_t& b = *p[ ( i + 2 ) % 3 ];
+
+      dx[i] = ( a.y() - b.y() ) / area2;
+      dy[i] = ( b.x() - a.x() ) / area2;
+      d0[i] = ( a.x() * b.y() - b.x() * a.y() ) / area2;
+
+      edge_distance[i] = std::abs( area2 ) / std::sqrt( ( b.x() - a.x() ) * ( b.x() - a.x() ) + ( b.y() - a.y() ) * ( b.y() - a.y() ) );
+      block_edge[i]    = m_options.block_outline && tri.block_edge[ ( i + 1 ) % 3 ];
+    }
+
+    // the texel coordinates are affine in the image, so neighbors differ by the gradient
+    const coord_t du_dx = dx[0] * uv[0]->x() + dx[1] * uv[1]->x() + dx[2] * uv[2]->x();
+    const coord_t du_dy = dy[0] * uv[0]->x() + dy[1] * uv[1]->x() + dy[2] * uv[2]->x();
+    const coord_t dv_dx = dx[0] * uv[0]->y() + dx[1] * uv[1]->y() + dx[2] * uv[2]->y();
+    const coord_t dv_dy = dy[0] * uv[0]->y() + dy[1] * uv[1]->y() + dy[2] * uv[2]->y();
+
+    const long column_begin = std::max< long >( tri.min_column, begin );
+    const long column_end   = std::min< long >( tri.max_column, end - 1 );
+    const long row_begin    = std::max< long >( tri.min_row, first_row );
+    const long row_end      = std::min< long >( tri.max_row, last_row );
+
+    for( long row = row_begin; row <= row_end; ++row )
+    {
+      unsigned char* pixel = strip + 3 * ( ( row - first_row ) * m_width + column_begin );
+
+      for( long column = column_begin; column <= column_end; ++column, pixel += 3 )
+      {
+        const coord_t x = column + .5, y = row + .5;
+
+        coord_t bary[3];
+        bool    inside = true;
+        for( size_t i = 0; i < 3; ++i )
+        { bary[i] = dx[i] * x + dy[i] * y + d0[i];
+          inside &= bary[i] >= -1e-9;
+        }
+
+        if( !inside ) continue;
+
+        if( block_edge[0] || block_edge[1] || block_edge[2] )
+        {
+          bool outline = false;
+          for( size_t i = 0; i < 3; ++i )
+            outline |= block_edge[i] && bary[i] * edge_distance[i] < .5;
+
+          if( outline )
+          { std::fill( pixel, pixel + 3, BLOCK_OUTLINE_SHADE );
+            continue;
+          }
+        }
+
+        const coord_t u = bary[0] * uv[0]->x() + bary[1] * uv[1]->x() + bary[2] * uv[2]->x();
+        const coord_t v = bary[0] * uv[0]->y() + bary[1] * uv[1]->y() + bary[2] * uv[2]->y();
+
+        // the texel centers lie at whole coordinates, their borders half way between
+        if( m_options.texel_outline )
+        {
+          const coord_t nearest_u = std::floor( u + .5 ), nearest_v = std::floor( v + .5 );
+
+          if( nearest_u != std::floor( u + du_dx + .5 ) || nearest_u != std::floor( u + du_dy + .5 )
+           || nearest_v != std::floor( v + dv_dx + .5 ) || nearest_v != std::floor( v + dv_dy + .5 ) )
+          { std::fill( pixel, pixel + 3, TEXEL_OUTLINE_SHADE );
+            continue;
+          }
+        }
+
+        float color[4] = { 0.f, 0.f, 0.f, 0.f };
+
+        if( m_options.weighted_alignment )
+        {
+          const coord_t cu = std::min< coord_t >( std::max< coord_t >( u, 0 ), texture_width - 1 );
+          const coord_t cv = std::min< coord_t >( std::max< coord_t >( v, 0 ), texture_height - 1 );
+
+          const long  s0 = long( cu ), t0 = long( cv );
+          const long  s1 = std::min( s0 + 1, texture_width - 1 ), t1 = std::min( t0 + 1, texture_height - 1 );
+          const float fs = cu - s0, ft = cv - t0;
+
+          const Surface::texture_type::channel_type* corners[4] = { texels + 4 * ( t0 * texture_width + s0 ), texels + 4 * ( t0 * texture_width + s1 )
+                                                                  , texels + 4 * ( t1 * texture_width + s0 ), texels + 4 * ( t1 * texture_width + s1 ) };
+          const float weights[4] = { ( 1.f - fs ) * ( 1.f - ft ), fs * ( 1.f - ft ), ( 1.f - fs ) * ft, fs * ft };
+
+          for( size_t c = 0; c < 4; ++c )
+            for( size_t k = 0; k < 4; ++k )
+              color[k] += weights[c] * corners[c][k];
+        }
+        else
+        {
+          const long s = std::min( std::max( long( std::floor( u + .5 ) ), 0l ), texture_width - 1 );
+          const long t = std::min( std::max( long( std::floor( v + .5 ) ), 0l ), texture_height - 1 );
+
+          std::copy( texels + 4 * ( t * texture_width + s ), texels + 4 * ( t * texture_width + s + 1 ), color );
+        }
+
+        // transparent texels show the white background
+        const float alpha = color[3] / 255.f;
+        for( size_t k = 0; k < 3; ++k )
+          pixel[k] = static_cast< unsigned char >( color[k] * alpha + 255.f * ( 1.f - alpha ) + .5f );
+      }
+    }
+  }
+}
+
+void    TextureRasterizer::write_png( const std::string& path )  const
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  const size_t strip_rows = std::min( m_height, m_options.strip_rows ? m_options.strip_rows : std::max< size_t >( 1, STRIP_BYTES / ( 3 * m_width ) ) );
+  const size_t num_strips = ( m_height + strip_rows - 1 ) / strip_rows;
+  const size_t num_tiles  = ( m_width + TILE_COLUMNS - 1 ) / TILE_COLUMNS;
+
+  UTK_LOG( INFO, "flat::TextureRasterizer::write_png\t| file \"" << path << "\" size " << m_width << 'x' << m_height
+                 << " scale " << m_scale << " strips " << num_strips << " of " << strip_rows << " rows"
+                 << " alignment " << ( m_options.weighted_alignment ? "weighted" : "regular" )
+                 << " texel outline " << ( m_options.texel_outline ? "yes" : "no" )
+                 << " block outline " << ( m_options.block_outline ? "yes" : "no" ) );
+
+  // the triangles overlapping every strip
+  std::vector< std::vector< size_t > > bins( num_strips );
+  for( size_t t = 0; t < m_triangles.size(); ++t )
+    for( size_t s = m_triangles[t].min_row / strip_rows; s <= m_triangles[t].max_row / strip_rows; ++s )
+      bins[s].push_back( t );
+
+  PngWriter writer( path, m_width, m_height );
+
+  std::vector< unsigned char > strip( 3 * m_width * strip_rows );
+
+  for( size_t s = 0; s < num_strips; ++s )
+  {
+    const size_t first_row = s * strip_rows;
+    const size_t num_rows  = std::min( strip_rows, m_height - first_row );
+
+    std::fill( strip.begin(), strip.begin() + 3 * m_width * num_rows, 255 );
+
+    // tiles are handed out one by one, so threads with empty tiles take over the rest
+    std::atomic< size_t > next_tile( 0 );
+    utk::parallel_invoke_blocks( utk::parallel_blocks( num_tiles, 1 ), [&]( const size_t )
+    {
+      for( size_t tile; ( tile = next_tile++ ) < num_tiles; )
+        rasterize_tile( bins[s], first_row, num_rows, tile * TILE_COLUMNS, std::min( m_width, ( tile + 1 ) * TILE_COLUMNS ), strip.data() );
+    } );
+
+    std::vector< size_t >().swap( bins[s] );
+
+    writer.write_rows( strip.data(), num_rows );
+  }
+
+  writer.close();
+
+  UTK_LOG( INFO, "flat::TextureRasterizer::write_png\t| completed in "
+                 << std::chrono::duration_cast< std::chrono::milliseconds >( std::chrono::steady_clock::now() - start ).count() << " ms" );
+}
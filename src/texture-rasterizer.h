@@ -0,0 +1,107 @@
+/***************************************************************************
+ *            texture-rasterizer.h
+ *
+ *  Copyright  2011  Peter Urban
+ *  <s9peurba@stud.uni-saarland.de>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+# pragma once
+
+# include "surface.h"
+
+# include <string>
+# include <vector>
+
+namespace flat
+{
+  // draws the texture of a surface onto its flattened triangles into a png image
+  // - the image covers the bounding box of the x and y coordinates, seen from +z like the gl view
+  // - the image is rendered in strips of rows that are written before the next one is drawn,
+  //   so its size is limited by the disk rather than the memory
+  // - every strip is split into tiles that are rasterized on concurrent threads
+  class TextureRasterizer
+  {
+    public:
+
+      struct options
+      {
+        // blends the four nearest texels by their distance ( weighted ) or takes the nearest one ( regular )
+        bool    weighted_alignment;
+        // lines between adjacent texels
+        bool    texel_outline;
+        // lines along the face edges that follow a texture axis - the cells of a grid surface
+        bool    block_outline;
+        // pixels per texel along the axis where the texels are densest
+        float   texel_size;
+        // rows per strip - 0 chooses strips of about 64 MiB
+        size_t  strip_rows;
+
+        options()
+        : weighted_alignment( true ), texel_outline( false ), block_outline( false ), texel_size( 1.f ), strip_rows( 0 )
+        {   }
+      };
+
+    private:
+
+      struct triangle
+      {
+        size_t  vertices[3];
+        // pixel bounding box ( inclusive )
+        long    min_column, max_column, min_row, max_row;
+        // edge ( i, i+1 ) is drawn as a block outline
+        bool    block_edge[3];
+      };
+
+      const Surface&    m_surface;
+      options           m_options;
+
+      coord_t   m_scale;
+      size_t    m_width;
+      size_t    m_height;
+
+      // image coordinates of the vertices and texture coordinates in texels
+      std::vector< location2d_t >   m_pixel_locations;
+      std::vector< location2d_t >   m_texel_locations;
+
+      std::vector< triangle >       m_triangles;
+
+      void  setup_triangles();
+
+      // draws the triangles overlapping columns [begin, end) of the strip starting at row first_row
+      void  rasterize_tile( const std::vector< size_t >& triangles
+                          , const size_t first_row
+                          , const size_t num_rows
+                          , const size_t begin
+                          , const size_t end
+                          , unsigned char* strip )  const;
+
+    public:
+
+      // the texture is loaded here, so the surface must not be changed until the image is written
+      TextureRasterizer( const Surface& surface, const options& o_options );
+
+      size_t    width()     const   { return m_width; }
+      size_t    height()    const   { return m_height; }
+
+      // image pixels per unit of the surface coordinates
+      coord_t   scale()     const   { return m_scale; }
+
+      void      write_png( const std::string& path )  const;
+  };
+}
@@ -0,0 +1,385 @@
+//           tiled-flattener.cpp
+//  Copyright  2011  Peter Urban
+//  <s9peurba@stud.uni-saarland.de>
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+
+# include "tiled-flattener.h"
+
+# include "surface-generators.h"
+
+# include "utk/log.h"
+# include "utk/parallel.h"
+
+# include <cmath>
+# include <fstream>
+# include <limits>
+# include <sstream>
+# include <stdexcept>
+
+using namespace flat;
+
+namespace
+{
+  // hands a window of scan samples that was read in advance to the surface
+  struct TileGenerator : public RectlinearFieldGenerator, public TextureGenerator
+  {
+    const std::vector< location_t >&    m_locations;
+
+    TileGenerator( const size_pair& size, const std::vector< location_t >& locations )
+    : RectlinearFieldGenerator( size ), TextureGenerator( { 0, 0 } ), m_locations( locations )  {   }
+
+    void operator() ( const std::shared_ptr< Surface >& surface )
+    { surface->set_locations( m_locations.begin() ); }
+
+    std::string   get_name() const { return "Tile"; }
+  };
+
+  // rotation, optional reflection at the y axis and translation in the plane
+  struct rigid_transform_2d
+  {
+    bool        mirror;
+    coord_t     cos, sin;
+    location2d_t shift;
+
+    rigid_transform_2d() : mirror( false ), cos( 1 ), sin( 0 ), shift( 0. )  {   }
+
+    location2d_t  operator() ( const location2d_t& p )  const
+    {
+      const coord_t x = mirror ? -p[0] : p[0];
+      return location2d_t( cos * x - sin * p[1] + shift[0], sin * x + cos * p[1] + shift[1] );
+    }
+  };
+
+  // least squares fit of the transform moving the points of from onto the points of to
+  // - both orientations are tried, the one with the smaller squared error is returned
+  rigid_transform_2d    fit_rigid_transform( const std::vector< location2d_t >& from, const std::vector< location2d_t >& to, coord_t& squared_error )
+  {
+    assert( from.size() == to.size() );
+
+    rigid_transform_2d best;
+    squared_error = 0;
+
+    if( from.empty() ) return best;
+
+    squared_error = std::numeric_limits< coord_t >::infinity();
+
+    for( size_t mirror = 0; mirror < 2; ++mirror )
+    {
+      location2d_t from_center( 0. ), to_center( 0. );
+      for( size_t p = 0; p < from.size(); ++p )
+      { from_center += location2d_t( mirror ? -from[p][0] : from[p][0], from[p][1] );
+        to_center   += to[p];
+      }
+      from_center /= coord_t( from.size() );
+      to_center   /= coord_t( from.size() );
+
+      // the optimal angle only depends on the summed dot and cross products of the centered pairs
+      coord_t dot_sum = 0, cross_sum = 0;
+      for( size_t p = 0; p < from.size(); ++p )
+      {
+        const coord_t fx = ( mirror ? -from[p][0] : from[p][0] ) - from_center[0];
+        const coord_t fy = from[p][1] - from_center[1];
+        const coord_t tx = to[p][0] - to_center[0];
+        const coord_t ty = to[p][1] - to_center[1];
+
+        dot_sum   += fx * tx + fy * ty;
+        cross_sum += fx * ty - fy * tx;
+      }
+
+      rigid_transform_2d transform;
+      const coord_t angle = std::atan2( cross_sum, dot_sum );
+      transform.mirror = mirror;
+      transform.cos    = std::cos( angle );
+      transform.sin    = std::sin( angle );
+      transform.shift  = to_center - location2d_t( transform.cos * from_center[0] - transform.sin * from_center[1]
+                                                 , transform.sin * from_center[0] + transform.cos * from_center[1] );
+
+      coord_t error = 0;
+      for( size_t p = 0; p < from.size(); ++p )
+      { const location2d_t d( transform( from[p] ) - to[p] );
+        error += d[0] * d[0] + d[1] * d[1];
+      }
+
+      if( error < squared_error )
+      { squared_error = error;
+        best = transform;
+      }
+    }
+
+    return best;
+  }
+}
+
+TiledFlattener::TiledFlattener( const std::string&    path
+                              , const size_pair&      stride
+                              , const size_t          tile_size
+                              , const size_t          overlap
+                              , const size_t          iterations
+                              , const solver_factory& create_solver )
+: m_file( path, utk::mapped_file::RANDOM ), m_header( pdm::read_header( m_file ) ), m_samples( m_file.begin() + m_header.data_offset )
+, m_stride( stride ), m_grid_size( 0, 0 ), m_tile_size( tile_size ), m_overlap( overlap ), m_iterations( iterations )
+, m_create_solver( create_solver ), m_shift( 0. ), m_invscale( 1 )
+{
+  if( !m_header.is_binary() )
+    throw not_binary_exception( path );
+
+  // the overlap has to span more than a line of samples to fix a rigid transform
+  if( m_overlap < 2 || m_tile_size <= m_overlap )
+    throw std::invalid_argument( "tiles need an overlap of at least two samples and a size larger than the overlap" );
+
+  const size_pair& field_size = m_header.field_size;
+
+  assert( std::get<0>( field_size ) > 1 && std::get<1>( field_size ) > 1 );
+  assert( std::get<0>( m_stride ) && std::get<1>( m_stride ) );
+
+  if( !m_header.fits_binary( m_file.size() ) )
+    throw std::runtime_error( "\"" + path + "\" is truncated" );
+
+  // same grid as the stride_predicate
+  m_grid_size = { ( std::get<0>( field_size ) - 2 ) / std::get<0>( m_stride ) + 2
+                , ( std::get<1>( field_size ) - 2 ) / std::get<1>( m_stride ) + 2 };
+
+  compute_transform();
+
+  UTK_LOG( INFO, "flat::TiledFlattener::TiledFlattener\t| grid (" << std::get<0>( m_grid_size ) << ',' << std::get<1>( m_grid_size ) << ')'
+                 << " tiles " << tile_origins( 0 ).size() << 'x' << tile_origins( 1 ).size() << " of size " << m_tile_size << " overlap " << m_overlap );
+}
+
+size_t  TiledFlattener::sample_coordinate( const size_t grid, const size_t dim )   const
+{
+  const size_t samples = dim ? std::get<1>( m_header.field_size ) : std::get<0>( m_header.field_size );
+  const size_t cells   = dim ? std::get<1>( m_grid_size ) : std::get<0>( m_grid_size );
+  const size_t stride  = dim ? std::get<1>( m_stride ) : std::get<0>( m_stride );
+
+  return grid + 1 < cells ? grid * stride : samples - 1;
+}
+
+std::vector< size_t >   TiledFlattener::tile_origins( const size_t dim )   const
+{
+  const size_t cells = dim ? std::get<1>( m_grid_size ) : std::get<0>( m_grid_size );
+  const size_t size  = std::min( m_tile_size, cells );
+
+  // the last tile ends at the border and overlaps its predecessor at least by m_overlap
+  std::vector< size_t > origins;
+  for( size_t origin = 0; ; origin += m_tile_size - m_overlap )
+  {
+    if( origin + size >= cells )
+    { origins.push_back( cells - size );
+      break;
+    }
+    origins.push_back( origin );
+  }
+
+  return origins;
+}
+
+void    TiledFlattener::compute_transform()
+{
+  typedef std::pair< location_t, location_t > bounding_box_type;
+
+  const bounding_box_type empty( location_t(  std::numeric_limits<coord_t>::infinity() )
+                               , location_t( -std::numeric_limits<coord_t>::infinity() ) );
+
+  // bounding box of the strided samples - the same the CenterRescaleTransform sees for the whole surface
+  const bounding_box_type box = utk::parallel_reduce( 0, std::get<1>( m_grid_size ), empty
+                                                    , [this, &empty]( const size_t begin, const size_t end )
+                                                      {
+                                                        bounding_box_type box( empty );
+                                                        float values[6];
+                                                        for( size_t j = begin; j < end; ++j )
+                                                          for( size_t i = 0; i < std::get<0>( m_grid_size ); ++i )
+                                                          {
+                                                            read_record( sample_coordinate( i, 0 ), sample_coordinate( j, 1 ), values );
+                                                            for( size_t d = 0; d < 3; ++d )
+                                                            { box.first[d]  = std::min< coord_t >( box.first[d], values[d] );
+                                                              box.second[d] = std::max< coord_t >( box.second[d], values[d] );
+                                                            }
+                                                          }
+                                                        return box;
+                                                      }
+                                                    , []( const bounding_box_type& a, const bounding_box_type& b )
+                                                      {
+                                                        bounding_box_type box( a );
+                                                        for( size_t d = 0; d < 3; ++d )
+                                                        { box.first[d]  = std::min( box.first[d], b.first[d] );
+                                                          box.second[d] = std::max( box.second[d], b.second[d] );
+                                                        }
+                                                        return box;
+                                                      }
+                                                    , 1 );
+
+  const location_t extent( box.second - box.first );
+
+  m_shift    = -( box.second + box.first ) / 2;
+  m_invscale = std::max( extent[0], std::max( extent[1], extent[2] ) );
+  if( !( m_invscale > 0 ) ) m_invscale = 1;
+}
+
+std::vector< location2d_t >   TiledFlattener::flatten_tile( const size_pair& origin, const size_pair& size )  const
+{
+  const size_t columns = std::get<0>( size );
+  const size_t rows    = std::get<1>( size );
+
+  std::vector< location_t > locations( columns * rows );
+
+  float values[6];
+  for( size_t j = 0; j < rows; ++j )
+    for( size_t i = 0; i < columns; ++i )
+    {
+      read_record( sample_coordinate( std::get<0>( origin ) + i, 0 ), sample_coordinate( std::get<1>( origin ) + j, 1 ), values );
+      locations[ j * columns + i ] = ( location_t( values[0], values[1], values[2] ) + m_shift ) / m_invscale;
+    }
+
+  TileGenerator                 generator( size, locations );
+  SimpleRectlinearTriangulator  triangulator( size );
+  NoTransform                   transform;
+
+  const std::shared_ptr< QuadSurface > surface = QuadSurface::create_with_generator( generator, triangulator, transform );
+
+  const std::shared_ptr< Solver > solver = m_create_solver( surface );
+  if( !solver )
+    throw std::runtime_error( "no solver for the tile" );
+
+  for( size_t iteration = 0; iteration < m_iterations; ++iteration )
+    solver->step();
+
+  const std::vector< location_t >& flat_locations = surface->geometry().locations();
+
+  std::vector< location2d_t > result( flat_locations.size() );
+  for( size_t v = 0; v < flat_locations.size(); ++v )
+    result[v] = location2d_t( flat_locations[v][0], flat_locations[v][1] );
+
+  return result;
+}
+
+void    TiledFlattener::operator() ( const std::string& output_path )  const
+{
+  const size_t columns = std::get<0>( m_grid_size );
+  const size_t rows    = std::get<1>( m_grid_size );
+
+  const std::vector< size_t > tile_columns( tile_origins( 0 ) );
+  const std::vector< size_t > tile_rows   ( tile_origins( 1 ) );
+
+  const size_pair tile_size( std::min( m_tile_size, columns ), std::min( m_tile_size, rows ) );
+
+  //----| output file with the strided grid size
+
+  pdm::header output_header( m_header );
+  std::ostringstream  row_token, column_token;
+  row_token << rows;
+  column_token << columns;
+  output_header.tokens[2] = row_token.str();
+  output_header.tokens[3] = column_token.str();
+
+  std::ofstream output( output_path.c_str(), std::ios::binary | std::ios::trunc );
+  output.exceptions( std::ofstream::failbit | std::ofstream::badbit );
+
+  pdm::write_binary_header( output, output_header );
+  const std::streamoff data_offset = output.tellp();
+
+  //----| placed samples of the current tile row
+
+  // band of tile height over all grid columns starting at band_top
+  size_t band_top = 0;
+  std::vector< location2d_t > band( std::get<1>( tile_size ) * columns, location2d_t( 0. ) );
+  std::vector< char >         placed( band.size(), false );
+
+  std::vector< float > records;
+  coord_t total_squared_error = 0;
+  size_t  total_pairs = 0;
+
+  for( size_t tile_row = 0; tile_row < tile_rows.size(); ++tile_row )
+  {
+    const size_t top = tile_rows[ tile_row ];
+
+    // shift the band - rows shared with the previous tile row stay placed
+    if( top != band_top )
+    {
+      const size_t shift = top - band_top;
+      for( size_t j = 0; j < std::get<1>( tile_size ); ++j )
+        for( size_t i = 0; i < columns; ++i )
+        {
+          const bool kept = j + shift < std::get<1>( tile_size );
+          band  [ j * columns + i ] = kept ? band  [ ( j + shift ) * columns + i ] : location2d_t( 0. );
+          placed[ j * columns + i ] = kept ? placed[ ( j + shift ) * columns + i ] : false;
+        }
+      band_top = top;
+    }
+
+    for( size_t tile_column = 0; tile_column < tile_columns.size(); ++tile_column )
+    {
+      const size_t left = tile_columns[ tile_column ];
+
+      const std::vector< location2d_t > tile( flatten_tile( { left, top }, tile_size ) );
+
+      //----| fit the tile to the placed samples it shares with its neighbors
+
+      std::vector< location2d_t > from, to;
+      for( size_t j = 0; j < std::get<1>( tile_size ); ++j )
+        for( size_t i = 0; i < std::get<0>( tile_size ); ++i )
+          if( placed[ j * columns + left + i ] )
+          { from.push_back( tile[ j * std::get<0>( tile_size ) + i ] );
+            to.push_back( band[ j * columns + left + i ] );
+          }
+
+      coord_t squared_error;
+      const rigid_transform_2d transform( fit_rigid_transform( from, to, squared_error ) );
+
+      total_squared_error += squared_error;
+      total_pairs         += from.size();
+
+      UTK_LOG( DEBUG, "flat::TiledFlattener()\t| tile (" << tile_column << ',' << tile_row << ") fitted to " << from.size() << " samples"
+                      << ( transform.mirror ? " mirrored" : "" ) << " rms " << ( from.empty() ? 0. : std::sqrt( squared_error / from.size() ) ) * m_invscale );
+
+      //----| place and write the new samples row by row in runs of consecutive columns
+
+      for( size_t j = 0; j < std::get<1>( tile_size ); ++j )
+      {
+        size_t i = 0;
+        while( i < std::get<0>( tile_size ) )
+        {
+          if( placed[ j * columns + left + i ] ) { ++i; continue; }
+
+          const size_t run_begin = i;
+          records.clear();
+
+          float values[6];
+          for( ; i < std::get<0>( tile_size ) && !placed[ j * columns + left + i ]; ++i )
+          {
+            const location2d_t location( transform( tile[ j * std::get<0>( tile_size ) + i ] ) );
+
+            band  [ j * columns + left + i ] = location;
+            placed[ j * columns + left + i ] = true;
+
+            read_record( sample_coordinate( left + i, 0 ), sample_coordinate( top + j, 1 ), values );
+
+            // the result is scaled back to the units of the scan
+            records.push_back( location[0] * m_invscale );
+            records.push_back( location[1] * m_invscale );
+            records.push_back( 0.f );
+            records.insert( records.end(), values + 3, values + 6 );
+          }
+
+          output.seekp( data_offset + std::streamoff( ( ( top + j ) * columns + left + run_begin ) * pdm::binary_record_size ) );
+          output.write( reinterpret_cast< const char* >( &records[0] ), records.size() * sizeof( float ) );
+        }
+      }
+    }
+  }
+
+  UTK_LOG( INFO, "flat::TiledFlattener()\t| " << tile_columns.size() * tile_rows.size() << " tiles written to \"" << output_path << '\"'
+                 << " overlap rms " << ( total_pairs ? std::sqrt( total_squared_error / total_pairs ) : 0. ) * m_invscale );
+}
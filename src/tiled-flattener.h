@@ -0,0 +1,113 @@
+/***************************************************************************
+ *            tiled-flattener.h
+ *
+ *  Copyright  2011  Peter Urban
+ *  <s9peurba@stud.uni-saarland.de>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+# pragma once
+
+# include "common.h"
+
+# include "pdm-format.h"
+# include "quad-surface.h"
+# include "solver.h"
+
+# include "utk/mmap.h"
+
+# include <functional>
+# include <string>
+# include <vector>
+
+namespace flat
+{
+  // flattens a binary pdm scan in overlapping tiles of the strided sample grid
+  // - every tile is loaded, triangulated and flattened as a QuadSurface of its own,
+  //   so distances and geodesics never leave the tile
+  // - tiles are visited row by row and fitted to the samples their left and upper
+  //   neighbors already placed by a rigid ( possibly mirrored ) 2d transform
+  // - the flattened samples are written to a binary pdm file as soon as a tile is placed,
+  //   only the placed samples of the current tile row stay in memory
+  class TiledFlattener
+  {
+    public:
+
+      typedef std::function< std::shared_ptr< Solver >( const std::shared_ptr< QuadSurface >& ) >  solver_factory;
+
+    private:
+
+      const utk::mapped_file    m_file;
+      pdm::header   m_header;
+      const char*   m_samples;
+
+      size_pair     m_stride;
+      // strided grid - the last row and column of the scan are always kept
+      size_pair     m_grid_size;
+
+      size_t        m_tile_size;
+      size_t        m_overlap;
+      size_t        m_iterations;
+
+      solver_factory    m_create_solver;
+
+      // center and scale of the whole scan - every tile is transformed alike
+      location_t    m_shift;
+      coord_t       m_invscale;
+
+      // scan column or row of a grid column or row
+      size_t    sample_coordinate( const size_t grid, const size_t dim )   const;
+
+      void      read_record( const size_t column, const size_t row, float ( &values )[6] )   const
+      { pdm::read_binary_record( m_samples + ( row * get<0>( m_header.field_size ) + column ) * pdm::binary_record_size, values ); }
+
+      // first grid column or row of every tile along a dimension
+      std::vector< size_t >     tile_origins( const size_t dim )   const;
+
+      void      compute_transform();
+
+      // flattens the tile and returns the planar locations of its vertices row by row
+      std::vector< location2d_t >   flatten_tile( const size_pair& origin, const size_pair& size )  const;
+
+    public:
+
+      struct not_binary_exception : public std::exception
+      {
+        std::string m_file;
+
+        not_binary_exception( const std::string& file ) : m_file( file ) {  }
+
+        virtual ~not_binary_exception() throw() { };
+
+        const char* what() const throw()  { return "tiled flattening needs a binary pdm file"; }
+      };
+
+      TiledFlattener( const std::string&    path
+                    , const size_pair&      stride
+                    , const size_t          tile_size
+                    , const size_t          overlap
+                    , const size_t          iterations
+                    , const solver_factory& create_solver );
+
+      const size_pair&  grid_size() const   { return m_grid_size; }
+
+      // flattens all tiles and writes the result to a binary pdm file of grid_size() samples
+      // - the colors of the scan are kept and the height is set to zero
+      void  operator() ( const std::string& output_path )  const;
+  };
+}
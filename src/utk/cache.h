@@ -25,6 +25,8 @@
 
 #pragma once
 
+# include <cstddef>
+
 template<class T>
 class Cache
 {
@@ -45,3 +47,40 @@ class Cache
 	
 	operator T&()		const	{ return value;	}
 };
+
+// value derived from data that carries a generation counter
+// - the value stays valid as long as the generation it was computed for is current
+// - a single counter increment on the source data invalidates every derived value
+template<class T>
+class GenerationCache
+{
+    mutable T           value;
+    mutable std::size_t generation;
+    mutable bool        valid;
+  public:
+	GenerationCache() : value(), generation(0), valid(false)	{	}
+
+    void invalidate()	const	{ valid=false; }
+
+    const bool is_valid( const std::size_t current )	const	{ return valid && generation==current; }
+
+    const T&	assign( const T& val, const std::size_t current )	const
+	{ value=val;
+	  generation=current;
+	  valid=true;
+	  return value;
+	}
+
+	// returns the cached value, calls compute() only if the generation changed
+	template<typename F>
+	const T&	get( const std::size_t current, F compute )	const
+	{ if( !is_valid( current ) )
+	  { value=compute();
+	    generation=current;
+	    valid=true;
+	  }
+	  return value;
+	}
+
+	operator const T&()	const	{ return value;	}
+};
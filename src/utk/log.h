@@ -0,0 +1,84 @@
+//libutk - a utility library 
+//Copyright (C) 2006  Peter Urban (peter.urban@s2003.tu-chemnitz.de)
+//
+//This program is free software; you can redistribute it and/or
+//modify it under the terms of the GNU General Public License
+//as published by the Free Software Foundation; either version 2
+//of the License, or (at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with this program; if not, write to the Free Software
+//Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#pragma once
+
+# include <iostream>
+# include <string>
+
+// messages above this level are removed by the compiler
+// 0 - none, 1 - error, 2 - warning, 3 - info, 4 - debug, 5 - trace
+# if !defined UTK_LOG_MAX_LEVEL
+#   if defined NDEBUG
+#     define UTK_LOG_MAX_LEVEL 3
+#   else
+#     define UTK_LOG_MAX_LEVEL 5
+#   endif
+# endif
+
+#pragma GCC visibility push(default)
+
+namespace utk
+{
+  namespace log
+  {
+    typedef enum { LEVEL_NONE    = 0
+                 , LEVEL_ERROR   = 1
+                 , LEVEL_WARNING = 2
+                 , LEVEL_INFO    = 3
+                 , LEVEL_DEBUG   = 4
+                 , LEVEL_TRACE   = 5 } level_type;
+
+    // runtime threshold - messages above it are skipped without evaluating their arguments
+    inline level_type&  threshold()
+    {
+      static level_type level = LEVEL_INFO;
+      return level;
+    }
+
+    inline void set_threshold( const level_type level )  { threshold() = level; }
+
+    inline bool enabled( const level_type level )
+    { return level <= UTK_LOG_MAX_LEVEL && level <= threshold(); }
+
+    inline std::ostream&  stream()  { return std::clog; }
+
+    // accepts "none", "error", "warning", "info", "debug", "trace" or a number
+    inline bool  parse_level( const std::string& token, level_type& level )
+    {
+      static const char* const names[] = { "none", "error", "warning", "info", "debug", "trace" };
+
+      for( int l = LEVEL_NONE; l <= LEVEL_TRACE; l++ )
+        if( token == names[l] || ( token.size() == 1 && token[0] == '0' + l ) )
+        {
+          level = level_type( l );
+          return true;
+        }
+      return false;
+    }
+  }
+}
+
+#pragma GCC visibility pop
+
+// UTK_LOG( DEBUG, "flat::Class::method\t| message " << value );
+// the condition folds to false for levels above UTK_LOG_MAX_LEVEL, so disabled messages cost nothing
+# define UTK_LOG( level, message )                                          \
+  do { if( utk::log::LEVEL_##level <= UTK_LOG_MAX_LEVEL                     \
+           && utk::log::enabled( utk::log::LEVEL_##level ) )                \
+         utk::log::stream() << message << '\n';                             \
+     } while( false )
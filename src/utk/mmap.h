@@ -0,0 +1,91 @@
+//libutk - a utility library
+//Copyright (C) 2006-2011  Peter Urban (peter.urban@s2003.tu-chemnitz.de)
+//
+//This program is free software; you can redistribute it and/or
+//modify it under the terms of the GNU General Public License
+//as published by the Free Software Foundation; either version 2
+//of the License, or (at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with this program; if not, write to the Free Software
+//Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+# pragma once
+
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+
+# include <cerrno>
+# include <cstring>
+# include <stdexcept>
+# include <string>
+
+# pragma GCC visibility push(default)
+
+namespace utk
+{
+  // read only memory mapping of a whole file
+  class mapped_file
+  {
+      const char*   m_data;
+      size_t        m_size;
+
+      mapped_file( const mapped_file& );
+      mapped_file&  operator=( const mapped_file& );
+
+    public:
+
+      typedef enum { SEQUENTIAL, RANDOM } access_type;
+
+      // throws std::runtime_error if the file can not be opened or mapped
+      mapped_file( const std::string& path, const access_type access = SEQUENTIAL )
+      : m_data( 0 ), m_size( 0 )
+      {
+        const int fd = ::open( path.c_str(), O_RDONLY );
+        if( fd < 0 ) throw std::runtime_error( "can not open \"" + path + "\" - " + std::strerror( errno ) );
+
+        struct stat status;
+        if( ::fstat( fd, &status ) < 0 )
+        { ::close( fd );
+          throw std::runtime_error( "can not stat \"" + path + "\" - " + std::strerror( errno ) );
+        }
+
+        m_size = status.st_size;
+
+        if( m_size )
+        {
+          void* data = ::mmap( 0, m_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+          if( data == MAP_FAILED )
+          { ::close( fd );
+            throw std::runtime_error( "can not map \"" + path + "\" - " + std::strerror( errno ) );
+          }
+          m_data = static_cast< const char* >( data );
+
+          ::madvise( data, m_size, access == SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM );
+        }
+
+        // the mapping stays valid after closing the descriptor
+        ::close( fd );
+      }
+
+      ~mapped_file()    { if( m_data ) ::munmap( const_cast< char* >( m_data ), m_size ); }
+
+      // changes the read ahead hint of the kernel
+      void  advise( const access_type access )  const
+      { if( m_data ) ::madvise( const_cast< char* >( m_data ), m_size, access == SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM ); }
+
+      const char*   data()  const   { return m_data; }
+      const char*   begin() const   { return m_data; }
+      const char*   end()   const   { return m_data + m_size; }
+      size_t        size()  const   { return m_size; }
+  };
+}
+
+# pragma GCC visibility pop
@@ -0,0 +1,94 @@
+//libutk - a utility library
+//Copyright (C) 2006-2011  Peter Urban (peter.urban@s2003.tu-chemnitz.de)
+//
+//This program is free software; you can redistribute it and/or
+//modify it under the terms of the GNU General Public License
+//as published by the Free Software Foundation; either version 2
+//of the License, or (at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with this program; if not, write to the Free Software
+//Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+# pragma once
+
+# include <algorithm>
+# include <thread>
+# include <vector>
+
+# pragma GCC visibility push(default)
+
+namespace utk
+{
+  // number of threads used by the parallel algorithms - defaults to the hardware concurrency
+  inline size_t&  parallel_threads()
+  {
+    static size_t threads = std::max( 1u, std::thread::hardware_concurrency() );
+    return threads;
+  }
+
+  // number of contiguous blocks a range of the given size is split into
+  inline size_t   parallel_blocks( const size_t size, const size_t min_block )
+  { return std::max< size_t >( 1, std::min( parallel_threads(), size / std::max< size_t >( 1, min_block ) ) ); }
+
+  // calls block( b ) for b = 0 ... blocks-1 - block 0 runs on the calling thread
+  template< typename F >
+  void  parallel_invoke_blocks( const size_t blocks, F block )
+  {
+    if( !blocks ) return;
+
+    std::vector< std::thread > threads;
+    threads.reserve( blocks );
+
+    for( size_t b = 1; b < blocks; ++b )
+      threads.push_back( std::thread( [&block, b]() { block( b ); } ) );
+
+    block( 0 );
+
+    std::for_each( threads.begin(), threads.end(), []( std::thread& thread ) { thread.join(); } );
+  }
+
+  // calls f( block_begin, block_end ) for contiguous blocks of [begin, end) on concurrent threads
+  // - blocks have at least min_block elements, smaller ranges run on the calling thread
+  template< typename F >
+  void  parallel_for( const size_t begin, const size_t end, F f, const size_t min_block = 4096 )
+  {
+    if( end <= begin ) return;
+
+    const size_t size   = end - begin;
+    const size_t blocks = parallel_blocks( size, min_block );
+
+    if( blocks == 1 ) { f( begin, end ); return; }
+
+    parallel_invoke_blocks( blocks, [&]( const size_t b ) { f( begin + size * b / blocks, begin + size * ( b + 1 ) / blocks ); } );
+  }
+
+  // reduces the results of f( block_begin, block_end ) for contiguous blocks of [begin, end) with reduce( a, b )
+  // - the blocks are reduced in order, so the result does not depend on the thread timing
+  template< typename T, typename F, typename R >
+  T     parallel_reduce( const size_t begin, const size_t end, const T& identity, F f, R reduce, const size_t min_block = 4096 )
+  {
+    if( end <= begin ) return identity;
+
+    const size_t size   = end - begin;
+    const size_t blocks = parallel_blocks( size, min_block );
+
+    if( blocks == 1 ) return reduce( identity, f( begin, end ) );
+
+    std::vector< T > partial( blocks, identity );
+
+    parallel_invoke_blocks( blocks, [&]( const size_t b ) { partial[b] = f( begin + size * b / blocks, begin + size * ( b + 1 ) / blocks ); } );
+
+    T result = identity;
+    for( auto it = partial.begin(); it != partial.end(); ++it )
+      result = reduce( result, *it );
+    return result;
+  }
+}
+
+# pragma GCC visibility pop
@@ -0,0 +1,68 @@
+//libutk - a utility library
+//Copyright (C) 2006-2011  Peter Urban (peter.urban@s2003.tu-chemnitz.de)
+//
+//This program is free software; you can redistribute it and/or
+//modify it under the terms of the GNU General Public License
+//as published by the Free Software Foundation; either version 2
+//of the License, or (at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with this program; if not, write to the Free Software
+//Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+# pragma once
+
+# include <atomic>
+
+# pragma GCC visibility push(default)
+
+namespace utk
+{
+  // lock free hand over of values from one writer to one reader thread
+  // - the writer fills back() and publishes it, the reader consumes the latest published value into front()
+  // - neither side ever waits, values published faster than consumed are overwritten
+  template< typename T >
+  class TripleBuffer
+  {
+      enum { INDEX = 3, FRESH = 4 };
+
+      T         m_buffers[3];
+      // index of the buffer between writer and reader - FRESH while it holds an unconsumed value
+      std::atomic< unsigned >   m_middle;
+      // owned by the writer and the reader thread
+      unsigned  m_back;
+      unsigned  m_front;
+
+      TripleBuffer( const TripleBuffer& );
+      TripleBuffer& operator=( const TripleBuffer& );
+
+    public:
+
+      TripleBuffer() : m_middle( 1 ), m_back( 2 ), m_front( 0 )   {   }
+
+      //----| writer thread
+
+      T&    back()      { return m_buffers[ m_back ]; }
+
+      void  publish()   { m_back = m_middle.exchange( m_back | FRESH ) & INDEX; }
+
+      //----| reader thread
+
+      // returns false if nothing was published since the last call
+      bool  consume()
+      {
+        if( !( m_middle.load() & FRESH ) ) return false;
+        m_front = m_middle.exchange( m_front ) & INDEX;
+        return true;
+      }
+
+      const T&  front() const   { return m_buffers[ m_front ]; }
+  };
+}
+
+# pragma GCC visibility pop
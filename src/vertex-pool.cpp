@@ -0,0 +1,169 @@
+//           vertex-pool.cpp
+//  Copyright  2011  Peter Urban
+//  <s9peurba@stud.uni-saarland.de>
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+
+// buffer object entry points of gl 1.5 - must precede the first gl header
+# define GL_GLEXT_PROTOTYPES
+
+# include "vertex-pool.h"
+
+# include "utk/log.h"
+
+# include <cassert>
+# include <cstdio>
+# include <limits>
+
+using namespace gl;
+
+const size_t  VertexPool::NONE;
+
+namespace
+{
+  // buffer objects are core since gl 1.5 - older implementations draw from client memory
+  bool  has_buffer_objects()
+  {
+    const char* version = reinterpret_cast< const char* >( glGetString( GL_VERSION ) );
+
+    int major = 0, minor = 0;
+    if( version ) std::sscanf( version, "%d.%d", &major, &minor );
+
+    return major > 1 || ( major == 1 && minor >= 5 );
+  }
+}
+
+VertexPool::VertexPool( const size_t vertex_floats, const size_t primitive_vertices )
+: m_vertex_floats( vertex_floats ), m_primitive_vertices( primitive_vertices ), m_size( 0 )
+, m_dirty_begin( std::numeric_limits< size_t >::max() ), m_dirty_end( 0 )
+, m_initialized( false ), m_supported( false ), m_buffer( 0 ), m_buffer_vertices( 0 )
+{ assert( vertex_floats > 0 && primitive_vertices > 0 ); }
+
+VertexPool::slot  VertexPool::allocate( const size_t num_vertices )
+{
+  slot s;
+  while( slot_vertices( s.size_class ) < num_vertices ) ++s.size_class;
+
+  if( s.size_class < m_free.size() && !m_free[ s.size_class ].empty() )
+  { s.first = m_free[ s.size_class ].back();
+    m_free[ s.size_class ].pop_back();
+    return s;
+  }
+
+  s.first = m_size;
+  m_size += slot_vertices( s.size_class );
+
+  // the new vertices are zero and so already degenerate
+  if( m_size * m_vertex_floats > m_data.size() )
+    m_data.resize( std::max( 2 * m_data.size(), m_size * m_vertex_floats ), 0.f );
+
+  return s;
+}
+
+VertexPool::slot  VertexPool::assign( const slot& s, const GLfloat* vertices, const size_t num_vertices )
+{
+  assert( num_vertices % m_primitive_vertices == 0 );
+
+  slot result = s;
+
+  if( !num_vertices )
+  { release( result );
+    return result;
+  }
+
+  if( result.empty() || slot_vertices( result.size_class ) < num_vertices )
+  { release( result );
+    result = allocate( num_vertices );
+  }
+
+  const size_t end = result.first + slot_vertices( result.size_class );
+
+  GLfloat* data = m_data.data() + result.first * m_vertex_floats;
+  std::copy( vertices, vertices + num_vertices * m_vertex_floats, data );
+  std::fill( data + num_vertices * m_vertex_floats, m_data.data() + end * m_vertex_floats, 0.f );
+
+  mark_dirty( result.first, end );
+
+  return result;
+}
+
+void    VertexPool::release( slot& s )
+{
+  if( s.empty() ) return;
+
+  const size_t end = s.first + slot_vertices( s.size_class );
+
+  std::fill( m_data.begin() + s.first * m_vertex_floats, m_data.begin() + end * m_vertex_floats, 0.f );
+  mark_dirty( s.first, end );
+
+  if( m_free.size() <= s.size_class ) m_free.resize( s.size_class + 1 );
+  m_free[ s.size_class ].push_back( s.first );
+
+  s = slot();
+}
+
+void    VertexPool::clear()
+{
+  std::fill( m_data.begin(), m_data.begin() + m_size * m_vertex_floats, 0.f );
+  mark_dirty( 0, m_size );
+
+  m_size = 0;
+  m_free.clear();
+}
+
+const GLfloat*  VertexPool::gl_bind()
+{
+  if( !m_initialized )
+  { m_supported = has_buffer_objects();
+    if( m_supported ) glGenBuffers( 1, &m_buffer );
+    m_initialized = true;
+
+    UTK_LOG( INFO, "gl::VertexPool::gl_bind\t| drawing from "
+                   << ( m_supported ? "buffer objects" : "client memory" ) );
+  }
+
+  if( !m_supported ) return m_data.data();
+
+  glBindBuffer( GL_ARRAY_BUFFER, m_buffer );
+
+  const size_t capacity = m_data.size() / m_vertex_floats;
+
+  if( capacity != m_buffer_vertices )
+  { glBufferData( GL_ARRAY_BUFFER, m_data.size() * sizeof( GLfloat ), m_data.data(), GL_DYNAMIC_DRAW );
+    m_buffer_vertices = capacity;
+  }
+  else if( m_dirty_begin < m_dirty_end )
+    glBufferSubData( GL_ARRAY_BUFFER, m_dirty_begin * stride(), ( m_dirty_end - m_dirty_begin ) * stride()
+                   , m_data.data() + m_dirty_begin * m_vertex_floats );
+
+  m_dirty_begin = std::numeric_limits< size_t >::max();
+  m_dirty_end   = 0;
+
+  return 0;
+}
+
+void    VertexPool::gl_unbind()
+{
+  if( m_supported ) glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+void    VertexPool::gl_release()
+{
+  if( m_supported && m_buffer ) glDeleteBuffers( 1, &m_buffer );
+
+  m_buffer = 0;
+  m_buffer_vertices = 0;
+  m_initialized = false;
+}
@@ -0,0 +1,119 @@
+/***************************************************************************
+ *            vertex-pool.h
+ *
+ *  Copyright  2011  Peter Urban
+ *  <s9peurba@stud.uni-saarland.de>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+# pragma once
+
+# include "gl-tools.h"
+
+# include <algorithm>
+# include <vector>
+
+namespace gl
+{
+  // interleaved float vertices of many independently changing pieces, drawn with one call
+  // - every piece owns a slot of a power of two number of primitives, a piece outgrowing its
+  //   slot moves to a larger one and freed slots are reused by pieces of the same size
+  // - the unused vertices of a slot lie at the origin, so their primitives cover no pixels
+  // - only the vertices written since the last upload are sent to the buffer object
+  // - all gl calls need the same current context
+  class VertexPool
+  {
+    public:
+
+      static const size_t   NONE = size_t( -1 );
+
+      struct slot
+      {
+        // first vertex and number of primitives as power of two
+        size_t  first;
+        size_t  size_class;
+
+        slot() : first( NONE ), size_class( 0 )  {   }
+
+        bool    empty() const   { return first == NONE; }
+      };
+
+    private:
+
+      size_t    m_vertex_floats;
+      size_t    m_primitive_vertices;
+
+      // vertices of all slots - the array grows by doubling, m_size ends the last slot
+      std::vector< GLfloat >    m_data;
+      size_t    m_size;
+
+      // first vertices of the free slots of every size class
+      std::vector< std::vector< size_t > >  m_free;
+
+      // vertices written since the last upload
+      size_t    m_dirty_begin;
+      size_t    m_dirty_end;
+
+      bool      m_initialized;
+      bool      m_supported;
+      GLuint    m_buffer;
+      // vertices the buffer object was allocated for
+      size_t    m_buffer_vertices;
+
+      size_t    slot_vertices( const size_t size_class )  const    { return m_primitive_vertices << size_class; }
+
+      void      mark_dirty( const size_t begin, const size_t end )
+      { m_dirty_begin = std::min( m_dirty_begin, begin );
+        m_dirty_end   = std::max( m_dirty_end, end );
+      }
+
+      slot      allocate( const size_t num_vertices );
+
+      VertexPool( const VertexPool& );
+      VertexPool&   operator=( const VertexPool& );
+
+    public:
+
+      // primitive_vertices are 3 for triangles and 2 for lines
+      VertexPool( const size_t vertex_floats, const size_t primitive_vertices );
+
+      size_t    vertex_floats()     const   { return m_vertex_floats; }
+      GLsizei   stride()            const   { return m_vertex_floats * sizeof( GLfloat ); }
+
+      // vertices to draw - the ones of free slots are degenerate
+      size_t    size()              const   { return m_size; }
+
+      // writes the vertices into the slot, or into a new one if they do not fit, and returns it
+      // - no vertices release the slot
+      slot      assign( const slot& s, const GLfloat* vertices, const size_t num_vertices );
+
+      void      release( slot& s );
+
+      // frees all slots
+      void      clear();
+
+      // uploads the changed vertices - returns the base address for gl*Pointer,
+      // zero with buffer objects as the array buffer stays bound until gl_unbind
+      const GLfloat*    gl_bind();
+
+      void      gl_unbind();
+
+      // deletes the buffer object - the vertices are uploaded anew
+      void      gl_release();
+  };
+}
@@ -78,6 +78,7 @@ namespace flat
 		
 		if( it != m_drawables.end() )
 		{ m_drawables.erase( it );
+		  invalidate_view();
           # if defined DBG_FLAT_GLCANVAS_REMOVE_DRAWABLE
           std::clog << "flat::View::remove_drawable\t|drawable removed" << std::endl;
           # endif